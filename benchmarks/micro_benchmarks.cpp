@@ -0,0 +1,393 @@
+#include "my_renderer.h"
+#include "utils/host_visible_buffer.h"
+#include "utils/device_local_buffer.h"
+
+#include <benchmark/benchmark.h>
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+
+namespace
+{
+    // Every input is generated from this seed, so runs on the same machine see identical data.
+    constexpr uint32_t Seed = 1234;
+    constexpr uint32_t VertexDuplication = 4;
+    constexpr int JpegQuality = 90;
+    constexpr size_t ParallelForGrainSize = 1 << 12;
+
+    uint32_t physicalDeviceIndex = 0;
+
+    std::vector<Vertex> createVertices(const uint32_t uniqueCount, const uint32_t duplication)
+    {
+        std::mt19937 generator(Seed);
+        std::uniform_real_distribution distribution(-1.0f, 1.0f);
+
+        std::vector<Vertex> vertices;
+        vertices.reserve(static_cast<size_t>(uniqueCount) * duplication);
+        for (uint32_t i = 0; i < uniqueCount; ++i)
+        {
+            const Vertex vertex = {
+                .pos = { distribution(generator), distribution(generator), distribution(generator) },
+                .color = { 1.0f, 1.0f, 1.0f },
+                .texCoord = { distribution(generator), distribution(generator) }
+            };
+            vertices.insert(vertices.end(), duplication, vertex);
+        }
+        std::ranges::shuffle(vertices, generator);
+
+        return vertices;
+    }
+
+    // Writes a gridSize x gridSize quad grid whose corners are shared by up to six triangles, like a typical closed mesh.
+    std::string createGridObj(const uint32_t gridSize)
+    {
+        static std::map<uint32_t, std::string> paths;
+        if (const auto iterator = paths.find(gridSize); iterator != paths.end())
+        {
+            return iterator->second;
+        }
+
+        const std::string path = (std::filesystem::temp_directory_path() / ("my_renderer_grid_" + std::to_string(gridSize) + ".obj")).string();
+        std::ofstream file(path);
+        if (!file)
+        {
+            throw std::runtime_error("Failed to create " + path + ".");
+        }
+
+        const uint32_t rowLength = gridSize + 1;
+        for (uint32_t y = 0; y < rowLength; ++y)
+        {
+            for (uint32_t x = 0; x < rowLength; ++x)
+            {
+                const float u = static_cast<float>(x) / static_cast<float>(gridSize);
+                const float v = static_cast<float>(y) / static_cast<float>(gridSize);
+                file << "v " << u << " " << v << " " << u * v << "\nvt " << u << " " << v << "\n";
+            }
+        }
+        for (uint32_t y = 0; y < gridSize; ++y)
+        {
+            for (uint32_t x = 0; x < gridSize; ++x)
+            {
+                const uint32_t a = y * rowLength + x + 1;
+                const uint32_t b = a + 1;
+                const uint32_t c = a + rowLength;
+                const uint32_t d = c + 1;
+                file << "f " << a << "/" << a << " " << b << "/" << b << " " << d << "/" << d << "\n"
+                     << "f " << a << "/" << a << " " << d << "/" << d << " " << c << "/" << c << "\n";
+            }
+        }
+
+        paths.emplace(gridSize, path);
+        return path;
+    }
+
+    std::vector<unsigned char> createPixels(const uint32_t size)
+    {
+        std::mt19937 generator(Seed);
+        std::uniform_int_distribution<int> noise(0, 31);
+
+        std::vector<unsigned char> pixels(static_cast<size_t>(size) * size * 4);
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                unsigned char* pixel = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+                pixel[0] = static_cast<unsigned char>((x * 255 / size + noise(generator)) & 0xff);
+                pixel[1] = static_cast<unsigned char>((y * 255 / size + noise(generator)) & 0xff);
+                pixel[2] = static_cast<unsigned char>((x ^ y) & 0xff);
+                pixel[3] = 255;
+            }
+        }
+
+        return pixels;
+    }
+
+    std::vector<unsigned char> encodeImage(const uint32_t size, const bool jpeg)
+    {
+        const std::vector<unsigned char> pixels = createPixels(size);
+
+        std::vector<unsigned char> encoded;
+        const auto append = [](void* context, void* data, const int dataSize)
+        {
+            auto* output = static_cast<std::vector<unsigned char>*>(context);
+            output->insert(output->end(), static_cast<unsigned char*>(data), static_cast<unsigned char*>(data) + dataSize);
+        };
+
+        const int width = static_cast<int>(size);
+        const int result = jpeg ?
+            stbi_write_jpg_to_func(append, &encoded, width, width, 4, pixels.data(), JpegQuality) :
+            stbi_write_png_to_func(append, &encoded, width, width, 4, pixels.data(), width * 4);
+        if (result == 0)
+        {
+            throw std::runtime_error("Failed to encode synthetic image.");
+        }
+
+        return encoded;
+    }
+
+    // Job systems are kept alive across benchmarks, so thread start-up is not measured.
+    JobSystem& getJobSystem(const uint32_t workerCount)
+    {
+        static std::map<uint32_t, std::unique_ptr<JobSystem>> jobSystems;
+
+        std::unique_ptr<JobSystem>& jobSystem = jobSystems[workerCount];
+        if (!jobSystem)
+        {
+            jobSystem = std::make_unique<JobSystem>(workerCount);
+        }
+        return *jobSystem;
+    }
+
+    // Powers of two up to the core count, plus the core count itself.
+    void addWorkerCounts(benchmark::internal::Benchmark* benchmark, const std::vector<int64_t>& sizes)
+    {
+        const auto coreCount = static_cast<int64_t>(std::max(1u, std::thread::hardware_concurrency()));
+        for (const int64_t size : sizes)
+        {
+            for (int64_t workerCount = 1; workerCount < coreCount; workerCount *= 2)
+            {
+                benchmark->Args({ size, workerCount });
+            }
+            benchmark->Args({ size, coreCount });
+        }
+    }
+
+    // One headless environment is shared by every GPU benchmark; it is created on first use so CPU-only runs never touch Vulkan.
+    const Environment* getEnvironment(benchmark::State& state)
+    {
+        static std::unique_ptr<Environment> environment;
+        static std::string error;
+
+        if (!environment and error.empty())
+        {
+            try
+            {
+                environment = std::make_unique<Environment>(nullptr, vk::Extent2D{ 1, 1 }, physicalDeviceIndex, "My Renderer Benchmarks", vk::makeApiVersion(0, 0, 0, 0), 1);
+            }
+            catch (const std::exception& exception)
+            {
+                error = exception.what();
+            }
+        }
+
+        if (!environment)
+        {
+            state.SkipWithError(error.c_str());
+        }
+        return environment.get();
+    }
+
+    void BM_LoadModel(benchmark::State& state)
+    {
+        const std::string path = createGridObj(static_cast<uint32_t>(state.range(0)));
+        JobSystem& jobSystem = getJobSystem(static_cast<uint32_t>(state.range(1)));
+
+        size_t indexCount = 0;
+        for (auto _ : state)
+        {
+            const auto model = Scene::loadMesh(path, jobSystem);
+            indexCount = model.indices.size();
+            benchmark::DoNotOptimize(model.vertices.data());
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(indexCount));
+    }
+    BENCHMARK(BM_LoadModel)->Apply([](benchmark::internal::Benchmark* benchmark) { addWorkerCounts(benchmark, { 64, 1024 }); })->ArgNames({ "grid", "workers" })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+    // Scaling of the scheduler itself on an embarrassingly parallel loop; ideal speedup is linear in workers.
+    void BM_JobSystemParallelFor(benchmark::State& state)
+    {
+        const auto size = static_cast<size_t>(state.range(0));
+        JobSystem& jobSystem = getJobSystem(static_cast<uint32_t>(state.range(1)));
+        const std::vector<Vertex> vertices = createVertices(static_cast<uint32_t>(size), 1);
+        std::vector<size_t> hashes(size);
+        const std::hash<Vertex> hasher;
+
+        for (auto _ : state)
+        {
+            jobSystem.parallelFor(0, size, ParallelForGrainSize, [&](const size_t first, const size_t last)
+            {
+                for (size_t i = first; i < last; ++i)
+                {
+                    hashes[i] = hasher(vertices[i]);
+                }
+            });
+            benchmark::DoNotOptimize(hashes.data());
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(size));
+    }
+    BENCHMARK(BM_JobSystemParallelFor)->Apply([](benchmark::internal::Benchmark* benchmark) { addWorkerCounts(benchmark, { 1 << 20 }); })->ArgNames({ "size", "workers" })->UseRealTime();
+
+    // Overhead of one job round trip, which bounds how fine jobs can usefully be.
+    void BM_JobSystemSubmitWait(benchmark::State& state)
+    {
+        JobSystem& jobSystem = getJobSystem(static_cast<uint32_t>(state.range(0)));
+
+        for (auto _ : state)
+        {
+            JobSystem::Counter counter;
+            jobSystem.submit([] {}, counter);
+            jobSystem.wait(counter);
+        }
+    }
+    BENCHMARK(BM_JobSystemSubmitWait)->Arg(1)->Arg(4)->UseRealTime();
+
+    // Mirrors the deduplication loop of Scene::loadMesh without the OBJ parsing around it.
+    void BM_VertexDedup(benchmark::State& state)
+    {
+        const std::vector<Vertex> vertices = createVertices(static_cast<uint32_t>(state.range(0)), VertexDuplication);
+
+        for (auto _ : state)
+        {
+            std::unordered_map<Vertex, uint32_t> uniqueVertices;
+            std::vector<Vertex> uniqueVertexList;
+            std::vector<uint32_t> indices;
+            indices.reserve(vertices.size());
+
+            for (const Vertex& vertex : vertices)
+            {
+                if (!uniqueVertices.contains(vertex))
+                {
+                    uniqueVertices[vertex] = uniqueVertexList.size();
+                    uniqueVertexList.push_back(vertex);
+                }
+                indices.push_back(uniqueVertices[vertex]);
+            }
+            benchmark::DoNotOptimize(indices.data());
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(vertices.size()));
+    }
+    BENCHMARK(BM_VertexDedup)->RangeMultiplier(8)->Range(1 << 10, 1 << 19);
+
+    void BM_HashVertex(benchmark::State& state)
+    {
+        const std::vector<Vertex> vertices = createVertices(static_cast<uint32_t>(state.range(0)), 1);
+        const std::hash<Vertex> hasher;
+
+        for (auto _ : state)
+        {
+            for (const Vertex& vertex : vertices)
+            {
+                benchmark::DoNotOptimize(hasher(vertex));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(vertices.size()));
+    }
+    BENCHMARK(BM_HashVertex)->Arg(1 << 16);
+
+    void BM_DecodeImage(benchmark::State& state)
+    {
+        const auto size = static_cast<uint32_t>(state.range(0));
+        const bool jpeg = state.range(1) != 0;
+        const std::vector<unsigned char> encoded = encodeImage(size, jpeg);
+        state.SetLabel(jpeg ? "jpeg" : "png");
+
+        for (auto _ : state)
+        {
+            int width, height, channels;
+            stbi_uc* pixels = stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()), &width, &height, &channels, STBI_rgb_alpha);
+            if (pixels == nullptr)
+            {
+                state.SkipWithError("Failed to decode synthetic image.");
+                break;
+            }
+            benchmark::DoNotOptimize(pixels);
+            stbi_image_free(pixels);
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(size) * size * 4);
+    }
+    BENCHMARK(BM_DecodeImage)->ArgsProduct({ { 256, 1024, 2048 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+
+    void BM_HostVisibleBufferUpload(benchmark::State& state)
+    {
+        const Environment* environment = getEnvironment(state);
+        if (environment == nullptr)
+        {
+            return;
+        }
+
+        const auto size = static_cast<vk::DeviceSize>(state.range(0));
+        const std::vector<std::byte> data(size, std::byte{ 0x5a });
+        const HostVisibleBuffer buffer(*environment, size, vk::BufferUsageFlagBits::eUniformBuffer);
+
+        for (auto _ : state)
+        {
+            buffer.uploadData(data.data(), size);
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(size));
+    }
+    BENCHMARK(BM_HostVisibleBufferUpload)->RangeMultiplier(16)->Range(1 << 8, 1 << 26);
+
+    void BM_DeviceLocalBufferUpload(benchmark::State& state)
+    {
+        const Environment* environment = getEnvironment(state);
+        if (environment == nullptr)
+        {
+            return;
+        }
+
+        const auto size = static_cast<vk::DeviceSize>(state.range(0));
+        const std::vector<std::byte> data(size, std::byte{ 0x5a });
+        const DeviceLocalBuffer buffer(*environment, size, vk::BufferUsageFlagBits::eVertexBuffer);
+
+        for (auto _ : state)
+        {
+            buffer.uploadData(data.data(), size);
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(size));
+    }
+    BENCHMARK(BM_DeviceLocalBufferUpload)->RangeMultiplier(16)->Range(1 << 12, 1 << 26)->Unit(benchmark::kMicrosecond);
+
+    void BM_DeviceLocalImageUpload(benchmark::State& state)
+    {
+        const Environment* environment = getEnvironment(state);
+        if (environment == nullptr)
+        {
+            return;
+        }
+
+        const auto size = static_cast<uint32_t>(state.range(0));
+        const std::vector<unsigned char> pixels = createPixels(size);
+        DeviceLocalImage image(*environment, { size, size }, vk::Format::eR8G8B8A8Unorm, vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor);
+
+        for (auto _ : state)
+        {
+            image.uploadData(pixels.data(), pixels.size());
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(pixels.size()));
+    }
+    BENCHMARK(BM_DeviceLocalImageUpload)->RangeMultiplier(4)->Range(256, 4096)->Unit(benchmark::kMicrosecond);
+}
+
+int main(int argc, char** argv)
+{
+    benchmark::Initialize(&argc, argv);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view argument = argv[i];
+        if (argument == "--device" and i + 1 < argc)
+        {
+            physicalDeviceIndex = std::stoul(argv[++i]);
+        }
+        else
+        {
+            std::cerr << "Unknown argument " << argument << "\nUsage: my_renderer_microbench [--device <index>] [benchmark options]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,373 @@
+#include "my_renderer.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string_view>
+
+
+namespace
+{
+    // Frame times are measured against a fixed animation clock so every run renders identical frames.
+    constexpr float FrameTimeStep = 1.0f / 60.0f;
+    constexpr float OrbitRadius = 2.8284271f;
+    constexpr float OrbitHeight = -0.5f;
+    constexpr float OrbitPeriod = 8.0f;
+
+    struct Options
+    {
+        uint32_t frameCount = 300;
+        uint32_t warmupFrameCount = 10;
+        vk::Extent2D extent = { 1280, 720 };
+        std::optional<std::string> jsonPath;
+        std::optional<std::string> csvPath;
+        // Enables dynamic resolution with this GPU frame time target in milliseconds.
+        std::optional<float> targetFrameTime;
+    };
+
+    struct Distribution
+    {
+        double mean;
+        double p50;
+        double p90;
+        double p95;
+        double p99;
+        double max;
+    };
+
+    struct Results
+    {
+        std::string deviceName;
+        double loadTime;
+        double timeToFirstFrame;
+        Distribution cpuFrameTime;
+        Distribution gpuFrameTime;
+        uint64_t peakResidentSetSize;
+        vk::DeviceSize transientMemorySize;
+        vk::DeviceSize lazyTransientMemorySize;
+        vk::DeviceSize savedTransientMemorySize;
+        Distribution renderScale;
+    };
+
+    Options parseOptions(const int argc, char** argv)
+    {
+        Options options;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view argument = argv[i];
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("Missing value for " + std::string(argument));
+            }
+
+            if (argument == "--frames")
+            {
+                options.frameCount = std::stoul(argv[++i]);
+            }
+            else if (argument == "--warmup")
+            {
+                options.warmupFrameCount = std::stoul(argv[++i]);
+            }
+            else if (argument == "--width")
+            {
+                options.extent.width = std::stoul(argv[++i]);
+            }
+            else if (argument == "--height")
+            {
+                options.extent.height = std::stoul(argv[++i]);
+            }
+            else if (argument == "--json")
+            {
+                options.jsonPath = argv[++i];
+            }
+            else if (argument == "--csv")
+            {
+                options.csvPath = argv[++i];
+            }
+            else if (argument == "--target-frame-time")
+            {
+                options.targetFrameTime = std::stof(argv[++i]);
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown argument " + std::string(argument) + "\nUsage: my_renderer_bench [--frames <count>] [--warmup <count>]"
+                                            " [--width <pixels>] [--height <pixels>] [--json <path>] [--csv <path>] [--target-frame-time <ms>]");
+            }
+        }
+
+        if (options.frameCount == 0)
+        {
+            throw std::invalid_argument("At least one measured frame is required.");
+        }
+
+        return options;
+    }
+
+    FrameScript createOrbitScript(const uint32_t frameCount)
+    {
+        std::vector<FrameScript::Frame> frames;
+        frames.reserve(frameCount);
+
+        for (uint32_t i = 0; i < frameCount; ++i)
+        {
+            const float time = static_cast<float>(i) * FrameTimeStep;
+            const float angle = glm::radians(45.0f) + glm::two_pi<float>() * time / OrbitPeriod;
+            frames.push_back({
+                .time = time,
+                .views = {
+                    {
+                        .eye = glm::vec3(OrbitRadius * std::cos(angle), OrbitRadius * std::sin(angle), OrbitHeight),
+                        .target = glm::vec3(0.0f)
+                    }
+                }
+            });
+        }
+
+        return FrameScript(std::move(frames));
+    }
+
+    Distribution summarize(std::vector<double> samples)
+    {
+        if (samples.empty())
+        {
+            return {};
+        }
+
+        std::ranges::sort(samples);
+        const auto percentile = [&samples](const double fraction)
+        {
+            return samples[std::min(samples.size() - 1, static_cast<size_t>(std::ceil(fraction * samples.size())) - 1)];
+        };
+
+        return {
+            .mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size(),
+            .p50 = percentile(0.50),
+            .p90 = percentile(0.90),
+            .p95 = percentile(0.95),
+            .p99 = percentile(0.99),
+            .max = samples.back()
+        };
+    }
+
+    uint64_t getPeakResidentSetSize()
+    {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss;
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+
+    double elapsedMilliseconds(const std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    Results runBenchmark(const Options& options)
+    {
+        const FrameScript frameScript = createOrbitScript(1 + options.warmupFrameCount + options.frameCount);
+
+        const auto startTime = std::chrono::steady_clock::now();
+        MyRenderer renderer(options.extent);
+        if (options.targetFrameTime.has_value())
+        {
+            renderer.setDynamicResolution(options.targetFrameTime.value());
+        }
+        const double loadTime = elapsedMilliseconds(startTime);
+
+        const FrameScript::Frame& firstFrame = frameScript.getFrames()[0];
+        renderer.beginAllocationCheck();
+        renderer.update(firstFrame.time, firstFrame.views);
+        renderer.drawHeadlessFrame(0);
+        renderer.endAllocationCheck();
+        renderer.waitIdle();
+        const double timeToFirstFrame = elapsedMilliseconds(startTime);
+
+        std::vector<double> cpuFrameTimes;
+        std::vector<double> gpuFrameTimes;
+        std::vector<double> renderScales;
+        cpuFrameTimes.reserve(options.frameCount);
+        gpuFrameTimes.reserve(options.frameCount);
+        renderScales.reserve(options.frameCount);
+
+        for (uint32_t i = 1; i < frameScript.getFrames().size(); ++i)
+        {
+            const FrameScript::Frame& frame = frameScript.getFrames()[i];
+
+            renderer.beginAllocationCheck();
+            const auto frameStartTime = std::chrono::steady_clock::now();
+            renderer.update(frame.time, frame.views);
+            renderer.drawHeadlessFrame(i);
+            const double cpuFrameTime = elapsedMilliseconds(frameStartTime);
+            renderer.endAllocationCheck();
+
+            if (i > options.warmupFrameCount)
+            {
+                cpuFrameTimes.push_back(cpuFrameTime);
+                gpuFrameTimes.push_back(renderer.getGpuFrameTime());
+                renderScales.push_back(renderer.getRenderScale());
+            }
+        }
+
+        renderer.waitIdle();
+
+        return {
+            .deviceName = renderer.getDeviceName(),
+            .loadTime = loadTime,
+            .timeToFirstFrame = timeToFirstFrame,
+            .cpuFrameTime = summarize(std::move(cpuFrameTimes)),
+            .gpuFrameTime = summarize(std::move(gpuFrameTimes)),
+            .peakResidentSetSize = getPeakResidentSetSize(),
+            .transientMemorySize = renderer.getTransientMemorySize(),
+            .lazyTransientMemorySize = renderer.getLazilyAllocatedTransientMemorySize(),
+            .savedTransientMemorySize = renderer.getSavedTransientMemorySize(),
+            .renderScale = summarize(std::move(renderScales))
+        };
+    }
+
+    // Writes text as a quoted JSON string, escaping quotes, backslashes and control characters.
+    void writeJsonString(std::ostream& stream, const std::string_view text)
+    {
+        stream << '"';
+        for (const char character : text)
+        {
+            if (character == '"' or character == '\\')
+            {
+                stream << '\\' << character;
+            }
+            else if (static_cast<unsigned char>(character) < 0x20)
+            {
+                constexpr char hexDigits[] = "0123456789abcdef";
+                stream << "\\u00" << hexDigits[character >> 4] << hexDigits[character & 0xf];
+            }
+            else
+            {
+                stream << character;
+            }
+        }
+        stream << '"';
+    }
+
+    // Writes text as a quoted CSV field, doubling quotes.
+    void writeCsvString(std::ostream& stream, const std::string_view text)
+    {
+        stream << '"';
+        for (const char character : text)
+        {
+            if (character == '"')
+            {
+                stream << '"';
+            }
+            stream << character;
+        }
+        stream << '"';
+    }
+
+    void writeJson(std::ostream& stream, const Options& options, const Results& results)
+    {
+        const auto writeDistribution = [&stream](const Distribution& distribution)
+        {
+            stream << "{ \"mean\": " << distribution.mean << ", \"p50\": " << distribution.p50 << ", \"p90\": " << distribution.p90
+                   << ", \"p95\": " << distribution.p95 << ", \"p99\": " << distribution.p99 << ", \"max\": " << distribution.max << " }";
+        };
+
+        stream << "{\n"
+               << "  \"device\": ";
+        writeJsonString(stream, results.deviceName);
+        stream << ",\n"
+               << "  \"width\": " << options.extent.width << ",\n"
+               << "  \"height\": " << options.extent.height << ",\n"
+               << "  \"frames\": " << options.frameCount << ",\n"
+               << "  \"warmupFrames\": " << options.warmupFrameCount << ",\n"
+               << "  \"loadTimeMs\": " << results.loadTime << ",\n"
+               << "  \"timeToFirstFrameMs\": " << results.timeToFirstFrame << ",\n"
+               << "  \"cpuFrameTimeMs\": ";
+        writeDistribution(results.cpuFrameTime);
+        stream << ",\n  \"gpuFrameTimeMs\": ";
+        writeDistribution(results.gpuFrameTime);
+        stream << ",\n"
+               << "  \"peakResidentSetBytes\": " << results.peakResidentSetSize << ",\n"
+               << "  \"transientAttachmentBytes\": " << results.transientMemorySize << ",\n"
+               << "  \"lazyTransientAttachmentBytes\": " << results.lazyTransientMemorySize << ",\n"
+               << "  \"savedTransientAttachmentBytes\": " << results.savedTransientMemorySize << ",\n"
+               << "  \"targetFrameTimeMs\": ";
+        if (options.targetFrameTime.has_value())
+        {
+            stream << options.targetFrameTime.value();
+        }
+        else
+        {
+            stream << "null";
+        }
+        stream << ",\n  \"renderScale\": ";
+        writeDistribution(results.renderScale);
+        stream << "\n}" << std::endl;
+    }
+
+    void writeCsv(std::ostream& stream, const Options& options, const Results& results)
+    {
+        stream << "device,width,height,frames,warmup_frames,load_time_ms,time_to_first_frame_ms,"
+                  "cpu_mean_ms,cpu_p50_ms,cpu_p90_ms,cpu_p95_ms,cpu_p99_ms,cpu_max_ms,"
+                  "gpu_mean_ms,gpu_p50_ms,gpu_p90_ms,gpu_p95_ms,gpu_p99_ms,gpu_max_ms,"
+                  "peak_resident_set_bytes,transient_attachment_bytes,lazy_transient_attachment_bytes,saved_transient_attachment_bytes,"
+                  "target_frame_time_ms,scale_mean,scale_p50,scale_p90,scale_p95,scale_p99,scale_max\n";
+
+        const auto writeDistribution = [&stream](const Distribution& distribution)
+        {
+            stream << distribution.mean << "," << distribution.p50 << "," << distribution.p90 << ","
+                   << distribution.p95 << "," << distribution.p99 << "," << distribution.max << ",";
+        };
+
+        writeCsvString(stream, results.deviceName);
+        stream << "," << options.extent.width << "," << options.extent.height << ","
+               << options.frameCount << "," << options.warmupFrameCount << "," << results.loadTime << "," << results.timeToFirstFrame << ",";
+        writeDistribution(results.cpuFrameTime);
+        writeDistribution(results.gpuFrameTime);
+        stream << results.peakResidentSetSize << "," << results.transientMemorySize << "," << results.lazyTransientMemorySize << ","
+               << results.savedTransientMemorySize << ",";
+        if (options.targetFrameTime.has_value())
+        {
+            stream << options.targetFrameTime.value();
+        }
+        stream << "," << results.renderScale.mean << "," << results.renderScale.p50 << "," << results.renderScale.p90 << ","
+               << results.renderScale.p95 << "," << results.renderScale.p99 << "," << results.renderScale.max << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const Options options = parseOptions(argc, argv);
+        const Results results = runBenchmark(options);
+
+        writeJson(std::cout, options, results);
+
+        if (options.jsonPath.has_value())
+        {
+            std::ofstream file(options.jsonPath.value());
+            writeJson(file, options, results);
+        }
+        if (options.csvPath.has_value())
+        {
+            std::ofstream file(options.csvPath.value());
+            writeCsv(file, options, results);
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
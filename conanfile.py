@@ -20,4 +20,9 @@ class ConanApplication(ConanFile):
     def requirements(self):
         requirements = self.conan_data.get('requirements', [])
         for requirement in requirements:
-            self.requires(requirement)
\ No newline at end of file
+            self.requires(requirement)
+
+    def build_requirements(self):
+        tool_requirements = self.conan_data.get('tool_requirements', [])
+        for tool_requirement in tool_requirements:
+            self.tool_requires(tool_requirement)
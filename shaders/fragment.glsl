@@ -2,14 +2,41 @@
 #pragma shader_stage(fragment)
 
 
-layout(set = 0, binding = 1) uniform sampler2D texSampler;
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 viewProjections[6];
+    mat4 cascadeViewProjections[4];
+} ubo;
+
+layout(set = 0, binding = 1) uniform sampler2DArrayShadow shadowMap;
+layout(set = 1, binding = 0) uniform sampler2D texSampler;
+
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+    vec4 baseColor;
+} pushConstants;
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 fragWorldPosition;
 
 layout(location = 0) out vec4 outColor;
 
+const float ambient = 0.4;
+
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
+    // Use the tightest cascade that contains the fragment, so cascades fitted to one view also serve the others.
+    float lit = 1.0;
+    for (int cascade = 0; cascade < 4; ++cascade) {
+        vec4 lightClip = ubo.cascadeViewProjections[cascade] * vec4(fragWorldPosition, 1.0);
+        vec3 lightCoord = lightClip.xyz / lightClip.w;
+        vec2 shadowUv = lightCoord.xy * 0.5 + 0.5;
+        if (all(greaterThanEqual(shadowUv, vec2(0.0))) && all(lessThanEqual(shadowUv, vec2(1.0))) && lightCoord.z >= 0.0 && lightCoord.z <= 1.0) {
+            lit = texture(shadowMap, vec4(shadowUv, cascade, lightCoord.z));
+            break;
+        }
+    }
+
+    vec4 albedo = texture(texSampler, fragTexCoord) * pushConstants.baseColor;
+    outColor = vec4(albedo.rgb * (ambient + (1.0 - ambient) * lit), albedo.a);
 }
@@ -0,0 +1,14 @@
+#version 450
+#pragma shader_stage(vertex)
+
+
+layout(push_constant) uniform PushConstants {
+    mat4 lightModelViewProjection;
+} pushConstants;
+
+layout(location = 0) in vec3 inPosition;
+
+
+void main() {
+    gl_Position = pushConstants.lightModelViewProjection * vec4(inPosition, 1.0);
+}
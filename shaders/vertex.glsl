@@ -1,23 +1,31 @@
 #version 450
+#extension GL_EXT_multiview : require
 #pragma shader_stage(vertex)
 
 
 layout(set = 0, binding = 0) uniform UniformBufferObject {
-    mat4 model;
-    mat4 view;
-    mat4 proj;
+    mat4 viewProjections[6];
+    mat4 cascadeViewProjections[4];
 } ubo;
 
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+    vec4 baseColor;
+} pushConstants;
+
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragWorldPosition;
 
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    vec4 worldPosition = pushConstants.model * vec4(inPosition, 1.0);
+    gl_Position = ubo.viewProjections[gl_ViewIndex] * worldPosition;
     fragColor = inColor;
     fragTexCoord = inTexCoord;
+    fragWorldPosition = worldPosition.xyz;
 }
@@ -0,0 +1,31 @@
+#ifndef DRAW_ITEM_H
+#define DRAW_ITEM_H
+
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+
+struct DrawItem
+{
+    glm::mat4 transform;
+    glm::vec4 boundingSphere;
+    vk::Buffer vertexBuffer;
+    vk::Buffer positionBuffer;
+    vk::Buffer indexBuffer;
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    vk::DescriptorSet materialDescriptorSet;
+    glm::vec4 baseColor;
+    bool isStatic;
+
+    bool operator==(const DrawItem&) const = default;
+};
+
+
+#endif //DRAW_ITEM_H
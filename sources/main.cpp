@@ -1,14 +1,306 @@
 #include "my_renderer.h"
+#include "utils/cpu_tracer.h"
 
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <exception>
 #include <iostream>
+#include <limits>
+#include <string_view>
+#include <thread>
 
 
-int main()
+namespace
 {
+    struct Options
+    {
+        std::optional<std::string> frameScriptPath;
+        vk::Extent2D headlessExtent = { 1920, 1080 };
+        std::optional<std::string> outputDirectory;
+        FrameReadback::Encoding encoding = FrameReadback::Encoding::Png;
+        uint32_t readbackSlotCount = 4;
+        uint32_t encodeThreadCount = std::max(1u, std::thread::hardware_concurrency());
+        uint32_t deviceCount = 1;
+        bool pipelineStatistics = false;
+        bool animated = true;
+        bool parallelStartup = true;
+        std::optional<std::string> sceneManifestPath;
+        std::optional<vk::DeviceSize> assetBudget;
+        std::optional<std::string> tracePath;
+        float hitchThreshold = FrameTelemetry::DefaultHitchThreshold;
+        std::optional<float> targetFrameTime;
+    };
+
+    // Parses a whole number from minimum up to the 32-bit limit; anything else is reported against option.
+    uint32_t parseUnsigned(const std::string_view option, const std::string_view value, const uint32_t minimum)
+    {
+        uint64_t result = 0;
+        const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (error != std::errc() or end != value.data() + value.size() or result < minimum or result > std::numeric_limits<uint32_t>::max())
+        {
+            throw std::invalid_argument("Invalid value " + std::string(value) + " for " + std::string(option) + ", expected a whole number from "
+                                        + std::to_string(minimum) + " to " + std::to_string(std::numeric_limits<uint32_t>::max()));
+        }
+
+        return static_cast<uint32_t>(result);
+    }
+
+    Options parseOptions(const int argc, char** argv)
+    {
+        Options options;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view argument = argv[i];
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("Missing value for " + std::string(argument));
+            }
+
+            if (argument == "--headless")
+            {
+                options.frameScriptPath = argv[++i];
+            }
+            else if (argument == "--width")
+            {
+                options.headlessExtent.width = parseUnsigned(argument, argv[++i], 1);
+            }
+            else if (argument == "--height")
+            {
+                options.headlessExtent.height = parseUnsigned(argument, argv[++i], 1);
+            }
+            else if (argument == "--output")
+            {
+                options.outputDirectory = argv[++i];
+            }
+            else if (argument == "--encoding")
+            {
+                const std::string_view encoding = argv[++i];
+                if (encoding == "png")
+                {
+                    options.encoding = FrameReadback::Encoding::Png;
+                }
+                else if (encoding == "raw")
+                {
+                    options.encoding = FrameReadback::Encoding::Raw;
+                }
+                else
+                {
+                    throw std::invalid_argument("Unknown encoding " + std::string(encoding) + ", expected png or raw");
+                }
+            }
+            else if (argument == "--readback-slots")
+            {
+                options.readbackSlotCount = parseUnsigned(argument, argv[++i], 1);
+            }
+            else if (argument == "--encode-threads")
+            {
+                options.encodeThreadCount = std::stoul(argv[++i]);
+            }
+            else if (argument == "--devices")
+            {
+                options.deviceCount = std::stoul(argv[++i]);
+            }
+            else if (argument == "--pipeline-statistics")
+            {
+                const std::string_view value = argv[++i];
+                if (value != "on" and value != "off")
+                {
+                    throw std::invalid_argument("Unknown value " + std::string(value) + " for --pipeline-statistics, expected on or off");
+                }
+                options.pipelineStatistics = value == "on";
+            }
+            else if (argument == "--animate")
+            {
+                const std::string_view value = argv[++i];
+                if (value != "on" and value != "off")
+                {
+                    throw std::invalid_argument("Unknown value " + std::string(value) + " for --animate, expected on or off");
+                }
+                options.animated = value == "on";
+            }
+            else if (argument == "--parallel-startup")
+            {
+                const std::string_view value = argv[++i];
+                if (value != "on" and value != "off")
+                {
+                    throw std::invalid_argument("Unknown value " + std::string(value) + " for --parallel-startup, expected on or off");
+                }
+                options.parallelStartup = value == "on";
+            }
+            else if (argument == "--scene")
+            {
+                options.sceneManifestPath = argv[++i];
+            }
+            else if (argument == "--asset-budget")
+            {
+                options.assetBudget = std::stoull(argv[++i]) * 1024 * 1024;
+            }
+            else if (argument == "--hitch-threshold")
+            {
+                options.hitchThreshold = std::stof(argv[++i]);
+            }
+            else if (argument == "--target-frame-time")
+            {
+                options.targetFrameTime = std::stof(argv[++i]);
+            }
+            else if (argument == "--trace")
+            {
+                if (!CpuTracer::isEnabled())
+                {
+                    throw std::invalid_argument("--trace requires a build configured with MY_RENDERER_TRACING=ON");
+                }
+                options.tracePath = argv[++i];
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown argument " + std::string(argument) + "\nUsage: my_renderer [--pipeline-statistics on|off] [--animate on|off] [--parallel-startup on|off] [--scene <scene manifest>] [--asset-budget <MiB>] [--trace <chrome trace path>] [--hitch-threshold <ms>] [--target-frame-time <ms>] [--headless <frame script> [--width <pixels>] [--height <pixels>]"
+                                            " [--devices <count, 0 for all>] [--output <directory> [--encoding png|raw] [--readback-slots <count>] [--encode-threads <count>]]]");
+            }
+        }
+
+        // GPU frame times differ from run to run, so a render scale that follows them would make batch output differ too.
+        if (options.frameScriptPath.has_value() and options.targetFrameTime.has_value())
+        {
+            throw std::invalid_argument("--target-frame-time cannot be combined with --headless, whose frames must not depend on GPU timing");
+        }
+
+        return options;
+    }
+
+    // Opens one renderer per worker, each on its own logical device, and lets them share the frame script through a work-stealing queue.
+    // Workers are dealt out over the suitable physical devices in turn, so asking for more workers than there are devices
+    // opens several logical devices on some of them.
+    // Readback writes every frame under its script index, so the outputs of all workers form a single numbered sequence.
+    void runBatch(const Options& options)
+    {
+        const FrameScript frameScript = FrameScript::load(options.frameScriptPath.value());
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        // Every worker loads and streams on the same job system, so more devices do not mean more threads than cores.
+        JobSystem jobSystem(MyRenderer::getDefaultJobWorkerCount());
+
+        auto primaryRenderer = std::make_unique<MyRenderer>(options.headlessExtent, frameScript.getViewCount(), 0, options.pipelineStatistics, options.parallelStartup, options.sceneManifestPath, &jobSystem);
+        primaryRenderer->setHitchThreshold(options.hitchThreshold);
+        if (options.assetBudget.has_value())
+        {
+            primaryRenderer->setAssetBudget(options.assetBudget.value());
+        }
+        const uint32_t suitableDeviceCount = primaryRenderer->getSuitablePhysicalDeviceCount();
+        const uint32_t workerCount = options.deviceCount == 0 ? suitableDeviceCount : options.deviceCount;
+
+        std::optional<FrameReadback::Settings> readbackSettings;
+        if (options.outputDirectory.has_value())
+        {
+            readbackSettings = FrameReadback::Settings{
+                .outputDirectory = options.outputDirectory.value(),
+                .encoding = options.encoding,
+                .slotCount = options.readbackSlotCount,
+                .threadCount = std::max(1u, options.encodeThreadCount / workerCount)
+            };
+        }
+
+        FrameQueue frameQueue(frameScript.getFrames().size(), workerCount);
+        std::vector<std::exception_ptr> exceptions(workerCount);
+        std::vector<uint32_t> renderedFrameCounts(workerCount, 0);
+        std::vector<std::string> deviceNames(workerCount);
+        deviceNames[0] = primaryRenderer->getDeviceName();
+
+        std::vector<std::thread> workers;
+        for (uint32_t i = 1; i < workerCount; ++i)
+        {
+            workers.emplace_back([&, i]
+            {
+                try
+                {
+                    MyRenderer renderer(options.headlessExtent, frameScript.getViewCount(), i % suitableDeviceCount, options.pipelineStatistics, options.parallelStartup, options.sceneManifestPath, &jobSystem);
+                    deviceNames[i] = renderer.getDeviceName();
+                    renderer.setHitchThreshold(options.hitchThreshold);
+                    if (options.assetBudget.has_value())
+                    {
+                        renderer.setAssetBudget(options.assetBudget.value());
+                    }
+                    renderedFrameCounts[i] = renderer.runHeadless(frameScript, readbackSettings, frameQueue, i);
+                }
+                catch (...)
+                {
+                    exceptions[i] = std::current_exception();
+                }
+            });
+        }
+
+        try
+        {
+            renderedFrameCounts[0] = primaryRenderer->runHeadless(frameScript, readbackSettings, frameQueue, 0);
+        }
+        catch (...)
+        {
+            exceptions[0] = std::current_exception();
+        }
+
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+        for (const std::exception_ptr& exception : exceptions)
+        {
+            if (exception)
+            {
+                std::rethrow_exception(exception);
+            }
+        }
+
+        primaryRenderer->dumpMemoryReport(std::cout);
+
+        if (workerCount > 1)
+        {
+            const double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            std::cout << "Batch of " << frameScript.getFrames().size() << " frames on " << workerCount << " workers over "
+                      << std::min(workerCount, suitableDeviceCount) << " devices took " << elapsedSeconds << " s ("
+                      << frameScript.getFrames().size() / elapsedSeconds << " frames/s)\n";
+            for (uint32_t i = 0; i < workerCount; ++i)
+            {
+                std::cout << "  worker " << i << ": device " << i % suitableDeviceCount << " (" << deviceNames[i] << "), " << renderedFrameCounts[i] << " frames\n";
+            }
+            std::cout << std::flush;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    TRACE_THREAD_NAME("Main");
+
     try
     {
-        MyRenderer app;
-        app.run();
+        const Options options = parseOptions(argc, argv);
+
+        if (options.frameScriptPath.has_value())
+        {
+            runBatch(options);
+        }
+        else
+        {
+            MyRenderer app(std::nullopt, 1, 0, options.pipelineStatistics, options.parallelStartup, options.sceneManifestPath);
+            app.setHitchThreshold(options.hitchThreshold);
+            app.setAnimated(options.animated);
+            if (options.assetBudget.has_value())
+            {
+                app.setAssetBudget(options.assetBudget.value());
+            }
+            if (options.targetFrameTime.has_value())
+            {
+                app.setDynamicResolution(options.targetFrameTime.value());
+            }
+            app.run();
+        }
+
+        if (options.tracePath.has_value())
+        {
+            CpuTracer::writeChromeTrace(options.tracePath.value());
+        }
     }
     catch (const std::exception& exception)
     {
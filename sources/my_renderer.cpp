@@ -6,77 +6,70 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-
-#include "utils/device_local_buffer.h"
 #include "utils/host_visible_buffer.h"
+#include "utils/cpu_tracer.h"
+#include "utils/allocation_tracker.h"
 
+#include <algorithm>
 #include <chrono>
-#include <unordered_map>
-
-
-MyRenderer::MyRenderer() :
-    model(loadModel(ModelPath + ModelFileName)),
-    window(WindowTitle, WindowWidth, WindowHeight),
-    environment(window, ApplicationName, ApplicationVersion, MaxFramesInFlight),
-    renderPipeline(environment),
-    depthImage(environment, environment.getSwapchainExtent(), environment.depthFormat, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageAspectFlagBits::eDepth),
-    vertexBuffer(std::make_unique<DeviceLocalBuffer>(environment, Vertex::Size * model.vertices.size(), vk::BufferUsageFlagBits::eVertexBuffer)),
-    indexBuffer(std::make_unique<DeviceLocalBuffer>(environment, sizeof(uint32_t) * model.indices.size(), vk::BufferUsageFlagBits::eIndexBuffer)),
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+
+MyRenderer::MyRenderer(const std::optional<vk::Extent2D> headlessExtent, const uint32_t viewCount, const uint32_t physicalDeviceIndex, const bool pipelineStatistics, const bool parallelStartup, const std::optional<std::string>& sceneManifestPath, JobSystem* sharedJobSystem) :
+    viewCount(checkViewCount(viewCount, headlessExtent.has_value())),
+    ownedJobSystem(sharedJobSystem == nullptr ? std::make_unique<JobSystem>(getDefaultJobWorkerCount()) : nullptr),
+    jobSystem(sharedJobSystem == nullptr ? *ownedJobSystem : *sharedJobSystem),
+    window(headlessExtent.has_value() ? nullptr : std::make_unique<Window>(WindowTitle, WindowWidth, WindowHeight)),
+    environment(window.get(), headlessExtent.value_or(vk::Extent2D{}), physicalDeviceIndex, ApplicationName, ApplicationVersion, MaxFramesInFlight),
+    assetStreamer(environment, jobSystem),
+    scene(environment, assetStreamer, jobSystem, loadSceneManifest(sceneManifestPath)),
+    renderPipeline(environment, scene.materialDescriptorSetLayout, getViewMask()),
     uniformBuffers(createUniformBuffers(environment, MaxFramesInFlight)),
-    textureImage(createTextureImage(environment)),
-    textureSampler(createTextureSampler(environment)),
+    cascadedShadowMap(environment),
     descriptorSets(environment.createDescriptorSets(MaxFramesInFlight, renderPipeline.descriptorSetLayout)),
-    swapchainFramebuffers(createSwapchainFramebuffers(environment, renderPipeline.renderPass, depthImage.imageView)),
-    graphicsCommandBuffers(environment.createGraphicsCommandBuffers(MaxFramesInFlight)),
+    renderGraph(environment, MaxFramesInFlight),
+    sceneColorTarget(0),
+    sceneDepthTarget(0),
+    outputColorTarget(0),
+    graphicsCommandBuffers(environment.createGraphicsCommandBuffers(CommandBufferCount)),
+    recordedStates(CommandBufferCount),
+    submittedCommandBuffers(),
+    commandBufferRecordCount(0),
     syncObjects(createSyncObjects(environment, MaxFramesInFlight)),
+    renderFinishedSemaphores(createRenderFinishedSemaphores(environment)),
+    retiredSwapchains(),
+    gpuProfiler(environment, CommandBufferCount, pipelineStatistics),
+    frameTelemetry(),
+    resolutionController(),
+    upscaleFilter(vk::Filter::eLinear),
+    renderExtent(environment.getSwapchainExtent()),
+    frameReadback(nullptr),
+    scriptedInstanceTransforms(),
+    drawItems(),
+    nextDrawItems(),
+    staticGeometryVersion(0),
+    sceneVersion(0),
+    swapchainGeneration(0),
+    submittedFrameCount(0),
+    presentedInputEventTime(),
+    allocationCheck(),
+    animated(true),
     currentFrame(0)
 {
-    vertexBuffer->uploadData(model.vertices.data(), Vertex::Size * model.vertices.size());
-    indexBuffer->uploadData(model.indices.data(), sizeof(uint32_t) * model.indices.size());
+    writeDescriptorSets();
 
-    for (uint32_t i = 0; i < MaxFramesInFlight; ++i)
-    {
-        const vk::DescriptorBufferInfo bufferInfo{
-            .buffer = *uniformBuffers[i]->getBuffer(),
-            .offset = 0,
-            .range = sizeof(UniformBufferObject)
-        };
-
-        const vk::DescriptorImageInfo imageInfo{
-            .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-            .imageView = *textureImage.imageView,
-            .sampler = *textureSampler
-        };
+    // Reserved up front so a growing scene does not allocate in steady-state frames.
+    scriptedInstanceTransforms.reserve(scene.getInstanceCount());
+    drawItems.reserve(scene.getInstanceCount());
+    nextDrawItems.reserve(scene.getInstanceCount());
 
-        const std::array<vk::WriteDescriptorSet, 2> descriptorWrites {
-            vk::WriteDescriptorSet{
-                .dstSet = *descriptorSets[i],
-                .dstBinding = 0,
-                .dstArrayElement = 0,
-                .descriptorCount = 1,
-                .descriptorType = vk::DescriptorType::eUniformBuffer,
-                .pBufferInfo = &bufferInfo,
-                .pImageInfo = nullptr,
-                .pTexelBufferView = nullptr
-            },
-            vk::WriteDescriptorSet{
-                .dstSet = *descriptorSets[i],
-                .dstBinding = 1,
-                .dstArrayElement = 0,
-                .descriptorCount = 1,
-                .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-                .pBufferInfo = nullptr,
-                .pImageInfo = &imageInfo,
-                .pTexelBufferView = nullptr
-            }
-        };
-
-        environment.device.updateDescriptorSets(descriptorWrites, nullptr);
+    if (!parallelStartup)
+    {
+        scene.finishLoading();
     }
 }
 
@@ -84,44 +77,235 @@ MyRenderer::~MyRenderer() = default;
 
 void MyRenderer::run()
 {
-    while (!window.shouldClose())
+    if (environment.isHeadless())
     {
-        glfwPollEvents();
-        update();
-        drawFrame();
+        throw std::logic_error("Headless renderers are driven by runHeadless.");
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    auto lastReportTime = startTime;
+    auto lastPollTime = startTime;
+    OrbitCamera camera(DefaultView);
+    std::optional<std::chrono::steady_clock::time_point> inputEventTime;
+
+    // The simulation only reads the scene manifest, which the render thread never changes.
+    const bool animatedSimulation = animated;
+    SimulationThread simulationThread([this, startTime, animatedSimulation](SimulationThread::Snapshot& snapshot)
+    {
+        snapshot.time = animatedSimulation ? std::chrono::duration<float>(snapshot.input.pollTime - startTime).count() : 0.0f;
+        snapshot.view = snapshot.input.camera.getView();
+        scene.animateInstances(snapshot.time, snapshot.instanceTransforms);
+    }, { .pollTime = startTime, .eventTime = std::nullopt, .camera = camera }, scene.getInstanceCount());
+
+    while (!window->shouldClose())
+    {
+        TRACE_SCOPE("Frame");
+
+        const auto frameStartTime = std::chrono::steady_clock::now();
+        const uint64_t singleTimeSubmitCount = environment.getSingleTimeSubmitCount();
+        const uint32_t renderGraphCompileCount = renderGraph.getCompileCount();
+
+        {
+            TRACE_SCOPE("Poll events");
+            glfwPollEvents();
+        }
+        const auto pollTime = std::chrono::steady_clock::now();
+        if (const auto cameraEventTime = pollCameraInput(camera, pollTime, std::chrono::duration<float>(pollTime - lastPollTime).count()))
+        {
+            inputEventTime = cameraEventTime;
+        }
+        lastPollTime = pollTime;
+        simulationThread.submitInput({ .pollTime = pollTime, .eventTime = inputEventTime, .camera = camera });
+
+        beginAllocationCheck();
+        const SimulationThread::Snapshot& snapshot = simulationThread.acquireSnapshot();
+        updateFrame(snapshot.instanceTransforms, { &snapshot.view, 1 });
+        drawFrame(snapshot.input.eventTime);
+        endAllocationCheck();
+
+        pollAssetStreams();
+        recordFrameTelemetry(frameStartTime, singleTimeSubmitCount, renderGraphCompileCount);
+
+        if (window->consumeKeyPress(GpuProfileDumpKey))
+        {
+            gpuProfiler.dump(std::cout);
+        }
+        if (window->consumeKeyPress(MemoryReportDumpKey))
+        {
+            dumpMemoryReport(std::cout);
+        }
+
+        if (const auto currentTime = std::chrono::steady_clock::now(); currentTime - lastReportTime >= StatisticsReportInterval)
+        {
+            reportStatistics();
+            lastReportTime = currentTime;
+        }
     }
 
     environment.device.waitIdle();
+    waitForPresentFences();
+    frameTelemetry.dump(std::cout);
 }
 
-void MyRenderer::update() const
+uint32_t MyRenderer::runHeadless(const FrameScript& frameScript, const std::optional<FrameReadback::Settings>& readbackSettings, FrameQueue& frameQueue, const uint32_t worker)
 {
-    static auto startTime = std::chrono::high_resolution_clock::now();
+    if (!environment.isHeadless())
+    {
+        throw std::logic_error("Windowed renderers are driven by run.");
+    }
 
-    const auto currentTime = std::chrono::high_resolution_clock::now();
-    const float deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+    if (readbackSettings.has_value())
+    {
+        frameReadback = std::make_unique<FrameReadback>(environment, environment.getSwapchainExtent(), viewCount, environment.swapchainSurfaceFormat.format, readbackSettings.value());
+    }
 
-    UniformBufferObject ubo{
-        .model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -0.7f)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.05f)) * glm::rotate(glm::mat4(1.0f), deltaTime * glm::radians(45.0f), glm::vec3(0.0f, 0.0f, 1.0f)) * glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-        .view = glm::lookAt(glm::vec3(2.0f, 2.0f, -0.5f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-        .projection = glm::perspective(glm::radians(45.0f), environment.getSwapchainExtent().width / static_cast<float>(environment.getSwapchainExtent().height), 0.1f, 10.0f)
-    };
-    ubo.projection[1][1] *= -1;
+    const std::string label = "[" + std::to_string(worker) + ": " + std::string(environment.physicalDeviceProperties.deviceName.data()) + "] ";
+    TRACE_THREAD_NAME("Render worker " + std::to_string(worker));
 
-    uniformBuffers[currentFrame]->uploadData(&ubo, sizeof(ubo));
+    const auto startTime = std::chrono::steady_clock::now();
+    auto lastReportTime = startTime;
+    uint32_t renderedFrameCount = 0;
+    uint32_t lastReportFrameCount = 0;
+    uint64_t lastReportWrittenFrameCount = 0;
+
+    // Scripted frames must not depend on how far streaming got, so the whole scene is resident before the first one.
+    scene.finishLoading();
+
+    while (const std::optional<uint32_t> frameNumber = frameQueue.pop(worker))
+    {
+        TRACE_SCOPE("Frame");
+
+        const auto frameStartTime = std::chrono::steady_clock::now();
+        const uint64_t singleTimeSubmitCount = environment.getSingleTimeSubmitCount();
+        const uint32_t renderGraphCompileCount = renderGraph.getCompileCount();
+
+        const FrameScript::Frame& frame = frameScript.getFrames()[frameNumber.value()];
+        beginAllocationCheck();
+        update(frame.time, frame.views);
+        drawHeadlessFrame(frameNumber.value());
+        endAllocationCheck();
+        ++renderedFrameCount;
+
+        pollAssetStreams();
+
+        recordFrameTelemetry(frameStartTime, singleTimeSubmitCount, renderGraphCompileCount);
+
+        if (const auto currentTime = std::chrono::steady_clock::now(); currentTime - lastReportTime >= StatisticsReportInterval)
+        {
+            const double intervalSeconds = std::chrono::duration<double>(currentTime - lastReportTime).count();
+
+            std::ostringstream report;
+            report << label << "Headless throughput: " << (renderedFrameCount - lastReportFrameCount) / intervalSeconds << " frames/s";
+            if (frameReadback)
+            {
+                report << ", " << (frameReadback->getWrittenFrameCount() - lastReportWrittenFrameCount) / intervalSeconds << " frames/s to disk";
+                lastReportWrittenFrameCount = frameReadback->getWrittenFrameCount();
+            }
+            std::cout << report.str() << std::endl;
+
+            if (frameQueue.getWorkerCount() == 1)
+            {
+                reportStatistics();
+            }
+            lastReportTime = currentTime;
+            lastReportFrameCount = renderedFrameCount;
+        }
+    }
+
+    environment.device.waitIdle();
+    if (frameReadback)
+    {
+        frameReadback->flush();
+    }
+    for (uint32_t i = 0; i < MaxFramesInFlight; ++i)
+    {
+        collectGpuTimings(i);
+    }
+
+    const double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    std::ostringstream report;
+    report << label << "Rendered " << renderedFrameCount << " frames at " << environment.getSwapchainExtent().width << "x" << environment.getSwapchainExtent().height
+           << " in " << elapsedSeconds << " s (" << renderedFrameCount / elapsedSeconds << " frames/s)";
+    if (frameReadback)
+    {
+        report << ", wrote " << frameReadback->getWrittenFrameCount() << " frames to " << readbackSettings->outputDirectory
+               << " (" << frameReadback->getWrittenFrameCount() / elapsedSeconds << " frames/s)";
+        frameReadback.reset();
+    }
+    std::cout << report.str() << std::endl;
+    gpuProfiler.dump(std::cout);
+    frameTelemetry.dump(std::cout);
+
+    return renderedFrameCount;
+}
+
+void MyRenderer::update(const float time, const std::span<const FrameScript::View> views)
+{
+    scene.animateInstances(animated ? time : 0.0f, scriptedInstanceTransforms);
+    updateFrame(scriptedInstanceTransforms, views);
 }
 
-void MyRenderer::drawFrame()
+void MyRenderer::updateFrame(const std::span<const glm::mat4> instanceTransforms, const std::span<const FrameScript::View> views)
 {
-    const vk::raii::CommandBuffer& graphicsCommandBuffer = graphicsCommandBuffers[currentFrame];
-    const auto& [imageAvailableSemaphore, renderFinishedSemaphore, inFlightFence] = syncObjects[currentFrame];
+    TRACE_SCOPE("Update");
+
+    if (views.size() != viewCount)
+    {
+        throw std::invalid_argument("Expected " + std::to_string(viewCount) + " views per frame, got " + std::to_string(views.size()) + ".");
+    }
+
+    waitForFrameSlot();
 
-    if (environment.device.waitForFences(*inFlightFence, true, std::numeric_limits<uint64_t>::max()) != vk::Result::eSuccess)
+    const float aspectRatio = environment.getSwapchainExtent().width / static_cast<float>(environment.getSwapchainExtent().height);
+    glm::mat4 projection = glm::perspective(glm::radians(CameraFieldOfView), aspectRatio, CameraNearPlane, CameraFarPlane);
+    projection[1][1] *= -1;
+
+    UniformBufferObject ubo{};
+    for (uint32_t i = 0; i < viewCount; ++i)
+    {
+        ubo.viewProjections[i] = projection * glm::lookAt(views[i].eye, views[i].target, glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+
+    scene.collectDrawItems(instanceTransforms, { ubo.viewProjections.data(), viewCount }, submittedFrameCount, nextDrawItems);
+    // Draw items are baked into cached command buffers, so only a changed draw list bumps the scene version.
+    if (nextDrawItems != drawItems)
     {
-        throw std::runtime_error("Failed to wait for fence.");
+        std::swap(drawItems, nextDrawItems);
+        ++sceneVersion;
     }
 
-    const auto& [acquireImageResult, imageIndex] = environment.getSwapchain().acquireNextImage(std::numeric_limits<uint64_t>::max(), *imageAvailableSemaphore, nullptr);
+    // Cascades are fitted to the first view; the fragment shader picks whichever cascade covers each fragment.
+    const CascadedShadowMap::Camera camera{
+        .view = glm::lookAt(views[0].eye, views[0].target, glm::vec3(0.0f, 0.0f, 1.0f)),
+        .fieldOfView = glm::radians(CameraFieldOfView),
+        .aspectRatio = aspectRatio,
+        .nearPlane = CameraNearPlane,
+        .farPlane = CameraFarPlane
+    };
+    cascadedShadowMap.update(camera, LightDirection, drawItems, staticGeometryVersion);
+
+    for (uint32_t i = 0; i < CascadedShadowMap::CascadeCount; ++i)
+    {
+        ubo.cascadeViewProjections[i] = cascadedShadowMap.getCascades()[i].viewProjection;
+    }
+
+    uniformBuffers[currentFrame]->uploadData(&ubo, sizeof(ubo));
+}
+
+void MyRenderer::drawFrame(const std::optional<std::chrono::steady_clock::time_point> inputEventTime)
+{
+    TRACE_SCOPE("Draw frame");
+
+    SyncObjects& frameSyncObjects = syncObjects[currentFrame];
+    const vk::raii::Semaphore& imageAvailableSemaphore = frameSyncObjects.imageAvailableSemaphore;
+    const vk::raii::Fence& inFlightFence = frameSyncObjects.inFlightFence;
+
+    const auto [acquireImageResult, imageIndex] = [&]
+    {
+        TRACE_SCOPE("Acquire image");
+        return environment.getSwapchain().acquireNextImage(std::numeric_limits<uint64_t>::max(), *imageAvailableSemaphore, nullptr);
+    }();
     if (acquireImageResult == vk::Result::eErrorOutOfDateKHR)
     {
         recreateSwapchain();
@@ -134,8 +318,11 @@ void MyRenderer::drawFrame()
 
     environment.device.resetFences(*inFlightFence);
 
-    graphicsCommandBuffer.reset(vk::CommandBufferResetFlagBits::eReleaseResources);
-    recordRenderCommand(*graphicsCommandBuffer, imageIndex);
+    declareRenderGraph(imageIndex, std::nullopt);
+    const vk::raii::Semaphore& renderFinishedSemaphore = renderFinishedSemaphores[imageIndex];
+
+    const bool cacheable = imageIndex < MaxCachedSwapchainImageCount;
+    const vk::raii::CommandBuffer& graphicsCommandBuffer = prepareCommandBuffer(currentFrame * MaxCachedSwapchainImageCount + (cacheable ? imageIndex : 0), cacheable);
 
     constexpr std::array<vk::PipelineStageFlags, 1> waitStages = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
 
@@ -149,9 +336,24 @@ void MyRenderer::drawFrame()
         .pSignalSemaphores = &*renderFinishedSemaphore
     };
 
-    environment.graphicsQueue.submit(submitInfo, *inFlightFence);
+    {
+        TRACE_SCOPE("Submit");
+        environment.graphicsQueue.submit(submitInfo, *inFlightFence);
+    }
+    ++submittedFrameCount;
+
+    const vk::SwapchainPresentFenceInfoEXT presentFenceInfo{
+        .swapchainCount = 1,
+        .pFences = &*frameSyncObjects.presentFence
+    };
+    if (environment.isSwapchainMaintenanceEnabled())
+    {
+        environment.device.resetFences(*frameSyncObjects.presentFence);
+    }
+    frameSyncObjects.presentSwapchainGeneration = swapchainGeneration;
 
     const vk::PresentInfoKHR presentInfo{
+        .pNext = environment.isSwapchainMaintenanceEnabled() ? &presentFenceInfo : nullptr,
         .waitSemaphoreCount = 1,
         .pWaitSemaphores = &*renderFinishedSemaphore,
         .swapchainCount = 1,
@@ -160,15 +362,26 @@ void MyRenderer::drawFrame()
         .pResults = nullptr
     };
 
-    if (const vk::Result result = environment.presentQueue.presentKHR(presentInfo);
-        result == vk::Result::eErrorOutOfDateKHR or
-        result == vk::Result::eSuboptimalKHR or
-        window.wasFramebufferResized())
+    const vk::Result presentResult = [&]
+    {
+        TRACE_SCOPE("Present");
+        return environment.presentQueue.presentKHR(presentInfo);
+    }();
+    const auto presentTime = std::chrono::steady_clock::now();
+    frameTelemetry.recordPresent(presentTime);
+    if (inputEventTime.has_value() and inputEventTime.value() > presentedInputEventTime)
     {
-        window.resetFramebufferResized();
+        frameTelemetry.recordInputLatency(std::chrono::duration<float, std::milli>(presentTime - inputEventTime.value()).count());
+        presentedInputEventTime = inputEventTime.value();
+    }
+    if (presentResult == vk::Result::eErrorOutOfDateKHR or
+        presentResult == vk::Result::eSuboptimalKHR or
+        window->wasFramebufferResized())
+    {
+        window->resetFramebufferResized();
         recreateSwapchain();
     }
-    else if (result != vk::Result::eSuccess)
+    else if (presentResult != vk::Result::eSuccess)
     {
         throw std::runtime_error("Failed to present swapchain image.");
     }
@@ -176,7 +389,199 @@ void MyRenderer::drawFrame()
     currentFrame = (currentFrame + 1) % MaxFramesInFlight;
 }
 
-void MyRenderer::recordRenderCommand(const vk::CommandBuffer& commandBuffer, const uint32_t imageIndex) const
+void MyRenderer::drawHeadlessFrame(const uint32_t frameNumber)
+{
+    TRACE_SCOPE("Draw frame");
+
+    const vk::raii::Fence& inFlightFence = syncObjects[currentFrame].inFlightFence;
+
+    environment.device.resetFences(*inFlightFence);
+
+    std::optional<uint32_t> readbackSlot;
+    if (frameReadback)
+    {
+        // Every read back frame gets its own output paths and encode job, so writing files allocates by design.
+        const AllocationTracker::Exclusion fileOutputExclusion;
+        readbackSlot = frameReadback->acquireSlot(frameNumber);
+    }
+    declareRenderGraph(std::nullopt, readbackSlot);
+
+    // Scripted frames move the camera and readback slots every frame, so they are always re-recorded.
+    const vk::raii::CommandBuffer& graphicsCommandBuffer = prepareCommandBuffer(currentFrame, false);
+
+    const vk::CommandBufferSubmitInfo commandBufferSubmitInfo{
+        .commandBuffer = *graphicsCommandBuffer,
+        .deviceMask = 0
+    };
+    const vk::SemaphoreSubmitInfo readbackSignalInfo = readbackSlot.has_value() ? frameReadback->getSignalSemaphoreInfo(readbackSlot.value()) : vk::SemaphoreSubmitInfo{};
+
+    const vk::SubmitInfo2 submitInfo{
+        .waitSemaphoreInfoCount = 0,
+        .pWaitSemaphoreInfos = nullptr,
+        .commandBufferInfoCount = 1,
+        .pCommandBufferInfos = &commandBufferSubmitInfo,
+        .signalSemaphoreInfoCount = readbackSlot.has_value() ? 1u : 0u,
+        .pSignalSemaphoreInfos = &readbackSignalInfo
+    };
+
+    {
+        TRACE_SCOPE("Submit");
+        environment.graphicsQueue.submit2(submitInfo, *inFlightFence);
+    }
+    ++submittedFrameCount;
+
+    currentFrame = (currentFrame + 1) % MaxFramesInFlight;
+}
+
+void MyRenderer::beginAllocationCheck()
+{
+    allocationCheck.singleTimeSubmitCount = environment.getSingleTimeSubmitCount();
+    allocationCheck.renderGraphCompileCount = renderGraph.getCompileCount();
+    allocationCheck.swapchainGeneration = swapchainGeneration;
+    AllocationTracker::begin();
+}
+
+void MyRenderer::endAllocationCheck()
+{
+    const uint64_t allocationCount = AllocationTracker::end();
+
+    // Uploads, graph compiles and swapchain recreation allocate by design; any other frame past warmup must not.
+    const bool isSteadyState = allocationCheck.frameCount >= AllocationWarmupFrameCount and
+        environment.getSingleTimeSubmitCount() == allocationCheck.singleTimeSubmitCount and
+        renderGraph.getCompileCount() == allocationCheck.renderGraphCompileCount and
+        swapchainGeneration == allocationCheck.swapchainGeneration;
+    if (isSteadyState and allocationCount > 0)
+    {
+        AllocationTracker::report(std::cerr);
+        throw std::logic_error("Steady-state frame " + std::to_string(allocationCheck.frameCount) + " made " + std::to_string(allocationCount) + " heap allocations on the render thread.");
+    }
+    ++allocationCheck.frameCount;
+}
+
+void MyRenderer::declareRenderGraph(const std::optional<uint32_t> swapchainImageIndex, const std::optional<uint32_t> readbackSlot)
+{
+    TRACE_SCOPE("Declare render graph");
+
+    renderGraph.reset();
+
+    const vk::Extent2D outputExtent = environment.getSwapchainExtent();
+    renderExtent = resolutionController.has_value() ? resolutionController->getRenderExtent(outputExtent) : outputExtent;
+
+    if (swapchainImageIndex.has_value())
+    {
+        outputColorTarget = renderGraph.importImage({
+            .image = environment.getSwapchainImages()[swapchainImageIndex.value()],
+            .imageView = *environment.getSwapchainImageViews()[swapchainImageIndex.value()],
+            .aspectFlags = vk::ImageAspectFlagBits::eColor,
+            .layerCount = 1,
+            .initialLayout = vk::ImageLayout::eUndefined,
+            .initialStageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+            .finalLayout = vk::ImageLayout::ePresentSrcKHR
+        });
+    }
+    else
+    {
+        outputColorTarget = renderGraph.createTransientImage({
+            .extent = outputExtent,
+            .format = environment.swapchainSurfaceFormat.format,
+            .usage = (resolutionController.has_value() ? vk::ImageUsageFlagBits::eTransferDst : vk::ImageUsageFlagBits::eColorAttachment) | vk::ImageUsageFlagBits::eTransferSrc,
+            .layerCount = viewCount
+        });
+    }
+    // Scaled frames draw into the top-left renderExtent of full-size targets, which a scale change leaves as they are.
+    sceneColorTarget = !resolutionController.has_value() ? outputColorTarget : renderGraph.createTransientImage({
+        .extent = outputExtent,
+        .format = environment.swapchainSurfaceFormat.format,
+        .usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+        .layerCount = viewCount
+    });
+    sceneDepthTarget = renderGraph.createTransientImage({
+        .extent = outputExtent,
+        .format = environment.depthFormat,
+        .usage = vk::ImageUsageFlagBits::eDepthStencilAttachment,
+        .layerCount = viewCount
+    });
+    const RenderGraph::ResourceHandle shadowMap = renderGraph.importImage({
+        .image = *cascadedShadowMap.getImage(),
+        .imageView = *cascadedShadowMap.getImageView(),
+        .aspectFlags = vk::ImageAspectFlagBits::eDepth,
+        .layerCount = CascadedShadowMap::CascadeCount,
+        .initialLayout = cascadedShadowMap.isInitialized() ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eUndefined,
+        .initialStageMask = vk::PipelineStageFlagBits2::eFragmentShader,
+        .finalLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal
+    });
+
+    if (cascadedShadowMap.hasPendingCascades())
+    {
+        const RenderGraph::PassHandle shadowPass = renderGraph.addPass([this](const vk::CommandBuffer& commandBuffer)
+        {
+            const GpuProfiler::Scope scope(gpuProfiler, commandBuffer, "Shadow pass");
+            cascadedShadowMap.record(commandBuffer, drawItems, gpuProfiler);
+        });
+        renderGraph.write(shadowPass, shadowMap, RenderGraph::Access::DepthAttachmentWrite);
+    }
+
+    const RenderGraph::PassHandle scenePass = renderGraph.addPass([this](const vk::CommandBuffer& commandBuffer)
+    {
+        const GpuProfiler::Scope scope(gpuProfiler, commandBuffer, "Scene pass");
+        recordScenePass(commandBuffer);
+    });
+    renderGraph.write(scenePass, sceneColorTarget, RenderGraph::Access::ColorAttachmentWrite);
+    renderGraph.write(scenePass, sceneDepthTarget, RenderGraph::Access::DepthAttachmentWrite);
+    renderGraph.read(scenePass, shadowMap, RenderGraph::Access::DepthSampledRead);
+
+    if (resolutionController.has_value())
+    {
+        const RenderGraph::PassHandle upscalePass = renderGraph.addPass([this](const vk::CommandBuffer& commandBuffer)
+        {
+            const GpuProfiler::Scope scope(gpuProfiler, commandBuffer, "Upscale pass");
+            recordUpscalePass(commandBuffer);
+        });
+        renderGraph.read(upscalePass, sceneColorTarget, RenderGraph::Access::TransferRead);
+        renderGraph.write(upscalePass, outputColorTarget, RenderGraph::Access::TransferWrite);
+    }
+
+    if (readbackSlot.has_value())
+    {
+        const RenderGraph::PassHandle readbackPass = renderGraph.addPass([this, slot = readbackSlot.value()](const vk::CommandBuffer& commandBuffer)
+        {
+            const GpuProfiler::Scope scope(gpuProfiler, commandBuffer, "Readback copy");
+            frameReadback->recordCopy(commandBuffer, renderGraph.getImage(outputColorTarget), slot);
+        });
+        renderGraph.read(readbackPass, outputColorTarget, RenderGraph::Access::TransferRead);
+    }
+
+    renderGraph.compile();
+}
+
+const vk::raii::CommandBuffer& MyRenderer::prepareCommandBuffer(const uint32_t commandBufferIndex, const bool cacheable)
+{
+    TRACE_SCOPE("Record commands");
+
+    const vk::raii::CommandBuffer& commandBuffer = graphicsCommandBuffers[commandBufferIndex];
+    const RecordedState state{
+        .sceneVersion = sceneVersion,
+        .swapchainGeneration = swapchainGeneration,
+        .renderGraphKey = renderGraph.getRecordingKey(),
+        .renderExtent = renderExtent
+    };
+
+    // Shadow passes bake in the matrices of the cascades they render, so frames that render any are never replayed.
+    if (!cacheable or cascadedShadowMap.hasPendingCascades() or recordedStates[commandBufferIndex] != state)
+    {
+        // Keeping the command memory lets the pool reuse it instead of reallocating it every frame.
+        commandBuffer.reset({});
+        recordRenderCommand(*commandBuffer, commandBufferIndex);
+        recordedStates[commandBufferIndex] = cacheable and !cascadedShadowMap.hasPendingCascades() ? std::optional(state) : std::nullopt;
+        ++commandBufferRecordCount;
+    }
+    cascadedShadowMap.commit();
+    submittedCommandBuffers[currentFrame] = commandBufferIndex;
+
+    return commandBuffer;
+}
+
+void MyRenderer::recordRenderCommand(const vk::CommandBuffer& commandBuffer, const uint32_t commandBufferIndex)
 {
     constexpr vk::CommandBufferBeginInfo beginInfo{
         .pInheritanceInfo = nullptr
@@ -184,179 +589,517 @@ void MyRenderer::recordRenderCommand(const vk::CommandBuffer& commandBuffer, con
 
     commandBuffer.begin(beginInfo);
 
-    constexpr std::array<vk::ClearValue, 2> clearValues{
-        vk::ClearValue{ .color = vk::ClearColorValue{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } } },
-        vk::ClearValue{ .depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 } }
+    gpuProfiler.beginFrame(commandBuffer, commandBufferIndex);
+    renderGraph.execute(commandBuffer);
+    gpuProfiler.endFrame(commandBuffer);
+
+    commandBuffer.end();
+}
+
+void MyRenderer::recordScenePass(const vk::CommandBuffer& commandBuffer) const
+{
+    const vk::RenderingAttachmentInfo colorAttachmentInfo{
+        .imageView = renderGraph.getImageView(sceneColorTarget),
+        .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+        .resolveMode = vk::ResolveModeFlagBits::eNone,
+        .loadOp = vk::AttachmentLoadOp::eClear,
+        .storeOp = vk::AttachmentStoreOp::eStore,
+        .clearValue = vk::ClearValue{ .color = vk::ClearColorValue{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } } }
+    };
+    const vk::RenderingAttachmentInfo depthAttachmentInfo{
+        .imageView = renderGraph.getImageView(sceneDepthTarget),
+        .imageLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+        .resolveMode = vk::ResolveModeFlagBits::eNone,
+        .loadOp = vk::AttachmentLoadOp::eClear,
+        .storeOp = vk::AttachmentStoreOp::eDontCare,
+        .clearValue = vk::ClearValue{ .depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 } }
     };
 
-    const vk::RenderPassBeginInfo renderPassBeginInfo{
-        .renderPass = *renderPipeline.renderPass,
-        .framebuffer = *swapchainFramebuffers[imageIndex],
-        .renderArea = {
-            .offset = { 0, 0 },
-            .extent = environment.getSwapchainExtent()
-        },
-        .clearValueCount = static_cast<uint32_t>(clearValues.size()),
-        .pClearValues = clearValues.data()
+    const vk::Rect2D renderArea{
+        .offset = { 0, 0 },
+        .extent = renderExtent
+    };
+    const vk::RenderingInfo renderingInfo{
+        .renderArea = renderArea,
+        .layerCount = 1,
+        .viewMask = getViewMask(),
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &colorAttachmentInfo,
+        .pDepthAttachment = &depthAttachmentInfo,
+        .pStencilAttachment = nullptr
     };
 
-    commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
+    commandBuffer.beginRendering(renderingInfo);
     commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *renderPipeline.pipeline);
 
-    commandBuffer.setViewport(0, environment.getViewport());
-    commandBuffer.setScissor(0, environment.getScissor());
+    const vk::Viewport viewport{
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = static_cast<float>(renderExtent.width),
+        .height = static_cast<float>(renderExtent.height),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f
+    };
+    commandBuffer.setViewport(0, viewport);
+    commandBuffer.setScissor(0, renderArea);
 
-    commandBuffer.bindVertexBuffers(0, *vertexBuffer->getBuffer(), { 0 });
-    commandBuffer.bindIndexBuffer(*indexBuffer->getBuffer(), 0, vk::IndexType::eUint32);
     commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *renderPipeline.pipelineLayout, 0, *descriptorSets[currentFrame], nullptr);
 
-    commandBuffer.drawIndexed(model.indices.size(), 1, 0, 0, 0);
+    // Buffers and materials are only rebound when they differ from the previous draw item's.
+    vk::Buffer boundVertexBuffer = nullptr;
+    vk::DescriptorSet boundMaterialDescriptorSet = nullptr;
+    for (const DrawItem& drawItem : drawItems)
+    {
+        if (drawItem.vertexBuffer != boundVertexBuffer)
+        {
+            commandBuffer.bindVertexBuffers(0, drawItem.vertexBuffer, { 0 });
+            commandBuffer.bindIndexBuffer(drawItem.indexBuffer, 0, vk::IndexType::eUint32);
+            boundVertexBuffer = drawItem.vertexBuffer;
+        }
+        if (drawItem.materialDescriptorSet != boundMaterialDescriptorSet)
+        {
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *renderPipeline.pipelineLayout, 1, drawItem.materialDescriptorSet, nullptr);
+            boundMaterialDescriptorSet = drawItem.materialDescriptorSet;
+        }
 
-    commandBuffer.endRenderPass();
+        const RenderPipeline::PushConstants pushConstants{
+            .model = drawItem.transform,
+            .baseColor = drawItem.baseColor
+        };
 
-    commandBuffer.end();
+        commandBuffer.pushConstants(*renderPipeline.pipelineLayout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(pushConstants), &pushConstants);
+        commandBuffer.drawIndexed(drawItem.indexCount, 1, drawItem.firstIndex, drawItem.vertexOffset, 0);
+    }
+
+    commandBuffer.endRendering();
+}
+
+void MyRenderer::recordUpscalePass(const vk::CommandBuffer& commandBuffer) const
+{
+    const vk::Extent2D outputExtent = environment.getSwapchainExtent();
+    const vk::ImageSubresourceLayers subresource{
+        .aspectMask = vk::ImageAspectFlagBits::eColor,
+        .mipLevel = 0,
+        .baseArrayLayer = 0,
+        .layerCount = viewCount
+    };
+
+    const vk::ImageBlit2 region{
+        .srcSubresource = subresource,
+        .srcOffsets = std::array{ vk::Offset3D{ 0, 0, 0 }, vk::Offset3D{ static_cast<int32_t>(renderExtent.width), static_cast<int32_t>(renderExtent.height), 1 } },
+        .dstSubresource = subresource,
+        .dstOffsets = std::array{ vk::Offset3D{ 0, 0, 0 }, vk::Offset3D{ static_cast<int32_t>(outputExtent.width), static_cast<int32_t>(outputExtent.height), 1 } }
+    };
+    const vk::BlitImageInfo2 blitInfo{
+        .srcImage = renderGraph.getImage(sceneColorTarget),
+        .srcImageLayout = vk::ImageLayout::eTransferSrcOptimal,
+        .dstImage = renderGraph.getImage(outputColorTarget),
+        .dstImageLayout = vk::ImageLayout::eTransferDstOptimal,
+        .regionCount = 1,
+        .pRegions = &region,
+        .filter = upscaleFilter
+    };
+
+    commandBuffer.blitImage2(blitInfo);
 }
 
 void MyRenderer::recreateSwapchain()
 {
-    if (window.getFramebufferSize().first == 0 or
-        window.getFramebufferSize().second == 0)
+    if (window->getFramebufferSize().first == 0 or
+        window->getFramebufferSize().second == 0)
     {
         return;
     }
 
-    environment.device.waitIdle();
+    RetiredSwapchain retiredSwapchain{
+        .swapchain = environment.recreateSwapchain(),
+        .renderFinishedSemaphores = std::move(renderFinishedSemaphores),
+        .presentFences = {},
+        .nextSwapchainFrame = submittedFrameCount
+    };
+    renderFinishedSemaphores = createRenderFinishedSemaphores(environment);
 
-    swapchainFramebuffers.clear();
-    environment.recreateSwapchain();
-    depthImage = DeviceLocalImage(environment, environment.getSwapchainExtent(), environment.depthFormat, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageAspectFlagBits::eDepth);
-    swapchainFramebuffers = createSwapchainFramebuffers(environment, renderPipeline.renderPass, depthImage.imageView);
+    // The fences of presents to the old swapchain go with it; their slots continue with fresh ones.
+    if (environment.isSwapchainMaintenanceEnabled())
+    {
+        for (SyncObjects& frameSyncObjects : syncObjects)
+        {
+            if (frameSyncObjects.presentSwapchainGeneration == swapchainGeneration)
+            {
+                retiredSwapchain.presentFences.push_back(std::exchange(frameSyncObjects.presentFence, environment.createFence(vk::FenceCreateFlagBits::eSignaled)));
+            }
+        }
+    }
+
+    retiredSwapchains.push_back(std::move(retiredSwapchain));
+    frameTelemetry.noteHitchCause(FrameTelemetry::HitchCause::Resize);
+    ++swapchainGeneration;
 }
 
-MyRenderer::Model MyRenderer::loadModel(const std::string& path)
+std::optional<std::chrono::steady_clock::time_point> MyRenderer::pollCameraInput(OrbitCamera& camera, const std::chrono::steady_clock::time_point pollTime, const float elapsedTime)
 {
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
+    const auto [dragX, dragY] = window->consumeCursorDrag();
+    const float keyYaw = static_cast<float>(window->isKeyDown(GLFW_KEY_RIGHT)) - static_cast<float>(window->isKeyDown(GLFW_KEY_LEFT));
+    const float keyPitch = static_cast<float>(window->isKeyDown(GLFW_KEY_UP)) - static_cast<float>(window->isKeyDown(GLFW_KEY_DOWN));
+
+    camera.orbit(keyYaw * CameraKeySpeed * elapsedTime - static_cast<float>(dragX) * CameraDragSpeed, keyPitch * CameraKeySpeed * elapsedTime + static_cast<float>(dragY) * CameraDragSpeed);
+    camera.zoom(std::pow(CameraScrollZoom, static_cast<float>(window->consumeScroll())));
 
-    Model model;
+    // Held keys move the camera on every poll, so the poll is their event.
+    const std::optional<std::chrono::steady_clock::time_point> eventTime = window->consumeInputEventTime();
+    return keyYaw != 0.0f or keyPitch != 0.0f ? std::optional(pollTime) : eventTime;
+}
 
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str()))
+void MyRenderer::releaseRetiredSwapchains()
+{
+    const uint64_t completedFrameCount = submittedFrameCount > MaxFramesInFlight ? submittedFrameCount - MaxFramesInFlight : 0;
+    const auto isReleasable = [completedFrameCount](const RetiredSwapchain& retiredSwapchain)
     {
-        throw std::runtime_error(warn + err);
+        if (retiredSwapchain.presentFences.empty())
+        {
+            return retiredSwapchain.nextSwapchainFrame < completedFrameCount;
+        }
+
+        return std::ranges::all_of(retiredSwapchain.presentFences, [](const vk::raii::Fence& presentFence)
+        {
+            return presentFence.getStatus() == vk::Result::eSuccess;
+        });
+    };
+
+    // Oldest first, so a swapchain is never released before the ones it replaced.
+    while (!retiredSwapchains.empty() and isReleasable(retiredSwapchains.front()))
+    {
+        retiredSwapchains.pop_front();
     }
+}
+
+void MyRenderer::waitForFrameSlot()
+{
+    const SyncObjects& frameSyncObjects = syncObjects[currentFrame];
 
-    std::unordered_map<Vertex, uint32_t> uniqueVertices;
-    for (const auto& shape : shapes)
     {
-        for (const auto& index : shape.mesh.indices)
+        TRACE_SCOPE("Wait for fence");
+        // The slot's present fence is reset for this frame's present, so its previous present must be done too.
+        const std::array<vk::Fence, 2> fences = { *frameSyncObjects.inFlightFence, *frameSyncObjects.presentFence };
+        const uint32_t fenceCount = environment.isSwapchainMaintenanceEnabled() ? 2 : 1;
+        if (environment.device.waitForFences(vk::ArrayProxy<const vk::Fence>(fenceCount, fences.data()), true, std::numeric_limits<uint64_t>::max()) != vk::Result::eSuccess)
         {
-            const Vertex vertex = {
-                .pos = {
-                    attrib.vertices[3 * index.vertex_index + 0],
-                    attrib.vertices[3 * index.vertex_index + 1],
-                    attrib.vertices[3 * index.vertex_index + 2]
-                },
-                .texCoord = {
-                    attrib.texcoords[2 * index.texcoord_index + 0],
-                    1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-                },
-                .color = { 1.0f, 1.0f, 1.0f }
-            };
-            if (!uniqueVertices.contains(vertex))
-            {
-                uniqueVertices[vertex] = model.vertices.size();
-                model.vertices.push_back(vertex);
-            }
+            throw std::runtime_error("Failed to wait for fence.");
+        }
+    }
+
+    collectGpuTimings(currentFrame);
+    if (!environment.isHeadless())
+    {
+        releaseRetiredSwapchains();
+    }
+}
+
+void MyRenderer::waitForPresentFences() const
+{
+    if (!environment.isSwapchainMaintenanceEnabled())
+    {
+        return;
+    }
 
-            model.indices.push_back(uniqueVertices[vertex]);
+    std::vector<vk::Fence> presentFences;
+    for (const SyncObjects& frameSyncObjects : syncObjects)
+    {
+        presentFences.push_back(*frameSyncObjects.presentFence);
+    }
+    for (const RetiredSwapchain& retiredSwapchain : retiredSwapchains)
+    {
+        for (const vk::raii::Fence& presentFence : retiredSwapchain.presentFences)
+        {
+            presentFences.push_back(*presentFence);
         }
     }
 
-    return model;
+    if (environment.device.waitForFences(presentFences, true, std::numeric_limits<uint64_t>::max()) != vk::Result::eSuccess)
+    {
+        throw std::runtime_error("Failed to wait for present fences.");
+    }
 }
 
-std::vector<std::unique_ptr<IBuffer>> MyRenderer::createUniformBuffers(const Environment& environment, const uint32_t count)
+void MyRenderer::writeDescriptorSets() const
 {
-    std::vector<std::unique_ptr<IBuffer>> uniformBuffers;
-    uniformBuffers.reserve(count);
-    for (uint32_t i = 0; i < count; ++i)
+    for (uint32_t i = 0; i < MaxFramesInFlight; ++i)
     {
-        uniformBuffers.emplace_back(std::make_unique<HostVisibleBuffer>(environment, sizeof(UniformBufferObject), vk::BufferUsageFlagBits::eUniformBuffer));
+        const vk::DescriptorBufferInfo bufferInfo{
+            .buffer = *uniformBuffers[i]->getBuffer(),
+            .offset = 0,
+            .range = sizeof(UniformBufferObject)
+        };
+
+        const vk::DescriptorImageInfo shadowMapInfo{
+            .sampler = *cascadedShadowMap.getSampler(),
+            .imageView = *cascadedShadowMap.getImageView(),
+            .imageLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal
+        };
+
+        const std::array<vk::WriteDescriptorSet, 2> descriptorWrites {
+            vk::WriteDescriptorSet{
+                .dstSet = *descriptorSets[i],
+                .dstBinding = 0,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = vk::DescriptorType::eUniformBuffer,
+                .pBufferInfo = &bufferInfo,
+                .pImageInfo = nullptr,
+                .pTexelBufferView = nullptr
+            },
+            vk::WriteDescriptorSet{
+                .dstSet = *descriptorSets[i],
+                .dstBinding = 1,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+                .pBufferInfo = nullptr,
+                .pImageInfo = &shadowMapInfo,
+                .pTexelBufferView = nullptr
+            }
+        };
+
+        environment.device.updateDescriptorSets(descriptorWrites, nullptr);
     }
+}
 
-    return uniformBuffers;
+void MyRenderer::pollAssetStreams()
+{
+    assetStreamer.poll();
+    const uint32_t residentAssetCount = scene.getResidentAssetCount();
+    // Each frame waits for the one MaxFramesInFlight before it, so all but the last MaxFramesInFlight frames are done.
+    const uint64_t completedFrameCount = submittedFrameCount > MaxFramesInFlight ? submittedFrameCount - MaxFramesInFlight : 0;
+    // Meshes that became resident or were evicted change what the cached shadow cascades contain.
+    if (scene.poll(submittedFrameCount, completedFrameCount))
+    {
+        ++staticGeometryVersion;
+    }
+    if (scene.getResidentAssetCount() != residentAssetCount)
+    {
+        frameTelemetry.noteHitchCause(FrameTelemetry::HitchCause::Upload);
+    }
 }
 
-DeviceLocalImage MyRenderer::createTextureImage(const Environment& environment)
+void MyRenderer::collectGpuTimings(const uint32_t frameIndex)
 {
-    int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load((TexturePath + TextureFileName).c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    const vk::DeviceSize imageSize = texWidth * texHeight * 4;
+    // Each submission is collected once, even when its frame ends early and the slot is waited on again.
+    const std::optional<uint32_t> commandBufferIndex = std::exchange(submittedCommandBuffers[frameIndex], std::nullopt);
+    if (commandBufferIndex.has_value() and gpuProfiler.collect(commandBufferIndex.value()))
+    {
+        const float gpuFrameTime = gpuProfiler.getLastTime(GpuProfiler::FrameScopeName);
+        frameTelemetry.recordGpuFrameTime(gpuFrameTime);
+        if (resolutionController.has_value())
+        {
+            resolutionController->update(gpuFrameTime);
+        }
+    }
+}
 
-    if (!pixels)
+void MyRenderer::recordFrameTelemetry(const std::chrono::steady_clock::time_point frameStartTime, const uint64_t singleTimeSubmitCount, const uint32_t renderGraphCompileCount)
+{
+    if (environment.getSingleTimeSubmitCount() != singleTimeSubmitCount)
     {
-        throw std::runtime_error("Failed to load texture image.");
+        frameTelemetry.noteHitchCause(FrameTelemetry::HitchCause::Upload);
+    }
+    if (renderGraph.getCompileCount() != renderGraphCompileCount)
+    {
+        frameTelemetry.noteHitchCause(FrameTelemetry::HitchCause::RenderGraphCompile);
     }
 
-    DeviceLocalImage image{environment, {static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight)}, vk::Format::eR8G8B8A8Srgb, vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor};
-    image.uploadData(pixels, imageSize);
-    image.transitionImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+    frameTelemetry.recordCpuFrameTime(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStartTime).count());
+}
 
-    stbi_image_free(pixels);
+void MyRenderer::waitIdle() const
+{
+    environment.device.waitIdle();
+}
 
-    return image;
+uint32_t MyRenderer::getSuitablePhysicalDeviceCount() const
+{
+    return environment.getSuitablePhysicalDeviceCount();
 }
 
-vk::raii::Sampler MyRenderer::createTextureSampler(const Environment& environment)
+std::string MyRenderer::getDeviceName() const
 {
-    const vk::SamplerCreateInfo createInfo{
-        .magFilter = vk::Filter::eLinear,
-        .minFilter = vk::Filter::eLinear,
-        .addressModeU = vk::SamplerAddressMode::eRepeat,
-        .addressModeV = vk::SamplerAddressMode::eRepeat,
-        .addressModeW = vk::SamplerAddressMode::eRepeat,
-        .anisotropyEnable = vk::True,
-        .maxAnisotropy = environment.physicalDeviceProperties.limits.maxSamplerAnisotropy,
-        .borderColor = vk::BorderColor::eIntOpaqueBlack,
-        .unnormalizedCoordinates = vk::False,
-        .compareEnable = vk::False,
-        .compareOp = vk::CompareOp::eAlways,
-        .mipmapMode = vk::SamplerMipmapMode::eLinear,
-        .mipLodBias = 0.0f,
-        .minLod = 0.0f,
-        .maxLod = 0.0f
-    };
+    return environment.physicalDeviceProperties.deviceName.data();
+}
+
+float MyRenderer::getGpuFrameTime() const
+{
+    return gpuProfiler.getLastTime(GpuProfiler::FrameScopeName);
+}
+
+vk::DeviceSize MyRenderer::getTransientMemorySize() const
+{
+    return renderGraph.getTransientMemorySize();
+}
+
+vk::DeviceSize MyRenderer::getLazilyAllocatedTransientMemorySize() const
+{
+    return renderGraph.getLazilyAllocatedTransientMemorySize();
+}
+
+vk::DeviceSize MyRenderer::getSavedTransientMemorySize() const
+{
+    return renderGraph.getSavedTransientMemorySize();
+}
 
-    return environment.device.createSampler(createInfo);
+void MyRenderer::dumpGpuProfile(std::ostream& stream) const
+{
+    gpuProfiler.dump(stream);
 }
 
-std::vector<vk::raii::Framebuffer> MyRenderer::createSwapchainFramebuffers(const Environment& environment,
-    const vk::raii::RenderPass& renderPass, const vk::raii::ImageView& depthImageView)
+void MyRenderer::dumpMemoryReport(std::ostream& stream) const
 {
-    const auto& swapchainImageViews = environment.getSwapchainImageViews();
-    const auto& [width, height] = environment.getSwapchainExtent();
+    environment.getMemoryTracker().dump(stream);
+}
 
-    std::vector<vk::raii::Framebuffer> framebuffers;
-    framebuffers.reserve(swapchainImageViews.size());
-    for (const vk::raii::ImageView& swapchainImageView : swapchainImageViews)
+const FrameTelemetry& MyRenderer::getFrameTelemetry() const
+{
+    return frameTelemetry;
+}
+
+void MyRenderer::setHitchThreshold(const float milliseconds)
+{
+    frameTelemetry.setHitchThreshold(milliseconds);
+}
+
+void MyRenderer::setAnimated(const bool enabled)
+{
+    animated = enabled;
+}
+
+void MyRenderer::setAssetBudget(const vk::DeviceSize budget)
+{
+    scene.setAssetBudget(budget);
+}
+
+void MyRenderer::setDynamicResolution(const float targetFrameTime)
+{
+    const vk::FormatFeatureFlags features = environment.getOptimalTilingFeatures(environment.swapchainSurfaceFormat.format);
+    const vk::FormatFeatureFlags blitFeatures = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst;
+    if ((features & blitFeatures) != blitFeatures or (!environment.isHeadless() and !environment.isSwapchainTransferDstSupported()))
     {
-        const std::array<vk::ImageView, 2> attachments = { *swapchainImageView, *depthImageView };
+        throw std::runtime_error("Dynamic resolution needs blits between color targets and into the swapchain images.");
+    }
 
-        const vk::FramebufferCreateInfo createInfo{
-            .renderPass = *renderPass,
-            .attachmentCount = static_cast<uint32_t>(attachments.size()),
-            .pAttachments = attachments.data(),
-            .width = width,
-            .height = height,
-            .layers = 1
-        };
+    upscaleFilter = features & vk::FormatFeatureFlagBits::eSampledImageFilterLinear ? vk::Filter::eLinear : vk::Filter::eNearest;
+    resolutionController.emplace(targetFrameTime);
+}
+
+float MyRenderer::getRenderScale() const
+{
+    return resolutionController.has_value() ? resolutionController->getScale() : 1.0f;
+}
+
+uint32_t MyRenderer::getViewMask() const
+{
+    return viewCount > 1 ? (1u << viewCount) - 1 : 0;
+}
+
+void MyRenderer::reportStatistics() const
+{
+    std::cout << "GPU frame time: " << gpuProfiler.getAverageTime(GpuProfiler::FrameScopeName) << " ms, command buffer recordings: " << commandBufferRecordCount << ", cached shadow cascades:";
+    for (uint32_t i = 0; i < CascadedShadowMap::CascadeCount; ++i)
+    {
+        if (cascadedShadowMap.isCascadeCached(i))
+        {
+            std::cout << " " << i;
+        }
+    }
+    std::cout << ", resident scene assets: " << scene.getResidentAssetCount() << "/" << scene.getAssetCount() << std::endl;
+
+    const GpuAssetCache::Statistics cacheStatistics = scene.getCacheStatistics();
+    const uint64_t requestCount = cacheStatistics.hitCount + cacheStatistics.missCount;
+    std::cout << "Asset cache: " << cacheStatistics.residentSize / (1024 * 1024) << " MiB resident";
+    if (cacheStatistics.budget != GpuAssetCache::Unlimited)
+    {
+        std::cout << " of " << cacheStatistics.budget / (1024 * 1024) << " MiB";
+    }
+    std::cout << ", hit rate: " << (requestCount > 0 ? 100.0 * cacheStatistics.hitCount / requestCount : 0.0) << "%, evictions: " << cacheStatistics.evictionCount
+              << ", re-uploads: " << cacheStatistics.reuploadCount << std::endl;
+
+    const GeometryHeap::Statistics geometryStatistics = scene.getGeometryStatistics();
+    std::cout << "Geometry heap: " << geometryStatistics.usedSize / (1024 * 1024) << " of " << geometryStatistics.capacity / (1024 * 1024) << " MiB used in "
+              << geometryStatistics.blockCount << " blocks, moves: " << geometryStatistics.moveCount << ", freed blocks: " << geometryStatistics.freedBlockCount << std::endl;
+
+    vk::DeviceSize trackedSize = 0;
+    vk::DeviceSize deviceLocalUsage = 0;
+    vk::DeviceSize deviceLocalBudget = 0;
+    for (const DeviceMemoryTracker::HeapReport& heapReport : environment.getMemoryTracker().getReport())
+    {
+        trackedSize += heapReport.trackedSize;
+        if (heapReport.isDeviceLocal)
+        {
+            deviceLocalUsage += heapReport.usage;
+            deviceLocalBudget += heapReport.budget;
+        }
+    }
+    std::cout << "Device memory: " << trackedSize / (1024 * 1024) << " MiB tracked, device-local heaps " << deviceLocalUsage / (1024 * 1024) << " of "
+              << deviceLocalBudget / (1024 * 1024) << " MiB budget in use" << std::endl;
+
+    std::cout << "Transient attachments: " << renderGraph.getTransientMemorySize() / 1024 << " KiB allocated, " << renderGraph.getLazilyAllocatedTransientMemorySize() / 1024
+              << " KiB lazily, " << renderGraph.getSavedTransientMemorySize() / 1024 << " KiB uncommitted" << std::endl;
+
+    if (resolutionController.has_value())
+    {
+        std::cout << "Dynamic resolution: scale " << resolutionController->getScale() << ", " << renderExtent.width << "x" << renderExtent.height
+                  << ", GPU frame time " << resolutionController->getSmoothedFrameTime() << " of " << resolutionController->getTargetFrameTime()
+                  << " ms, scale changes: " << resolutionController->getScaleChangeCount() << std::endl;
+    }
+}
+
+uint32_t MyRenderer::getDefaultJobWorkerCount()
+{
+    return std::max(2u, std::thread::hardware_concurrency()) - 1;
+}
+
+uint32_t MyRenderer::checkViewCount(const uint32_t viewCount, const bool headless)
+{
+    if (viewCount == 0 or viewCount > MaxViewCount)
+    {
+        throw std::invalid_argument("View count must be between 1 and " + std::to_string(MaxViewCount) + ".");
+    }
+    if (viewCount > 1 and !headless)
+    {
+        throw std::invalid_argument("Multiview rendering is only supported headless.");
+    }
 
-        framebuffers.emplace_back(environment.device, createInfo);
+    return viewCount;
+}
+
+SceneManifest MyRenderer::loadSceneManifest(const std::optional<std::string>& path)
+{
+    if (path.has_value())
+    {
+        return SceneManifest::load(path.value());
     }
 
-    return framebuffers;
+    return SceneManifest(
+        { ModelPath + ModelFileName },
+        { TexturePath + TextureFileName },
+        { { .textureIndex = 0, .baseColor = glm::vec4(1.0f) } },
+        { {
+            .meshIndex = 0,
+            .materialIndex = 0,
+            .position = glm::vec3(0.0f, 0.0f, -0.7f),
+            .scale = 0.05f,
+            .rotation = glm::vec3(glm::radians(90.0f), 0.0f, 0.0f),
+            .spin = glm::radians(45.0f)
+        } });
+}
+
+std::vector<std::unique_ptr<IBuffer>> MyRenderer::createUniformBuffers(const Environment& environment, const uint32_t count)
+{
+    std::vector<std::unique_ptr<IBuffer>> uniformBuffers;
+    uniformBuffers.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uniformBuffers.emplace_back(std::make_unique<HostVisibleBuffer>(environment, sizeof(UniformBufferObject), vk::BufferUsageFlagBits::eUniformBuffer));
+    }
+
+    return uniformBuffers;
 }
 
 std::vector<MyRenderer::SyncObjects> MyRenderer::createSyncObjects(const Environment& environment, const uint32_t count)
@@ -367,10 +1110,23 @@ std::vector<MyRenderer::SyncObjects> MyRenderer::createSyncObjects(const Environ
     {
         syncObjects.push_back({
             .imageAvailableSemaphore = environment.createSemaphore(),
-            .renderFinishedSemaphore = environment.createSemaphore(),
-            .inFlightFence = environment.createFence(vk::FenceCreateFlagBits::eSignaled)
+            .inFlightFence = environment.createFence(vk::FenceCreateFlagBits::eSignaled),
+            .presentFence = environment.isSwapchainMaintenanceEnabled() ? environment.createFence(vk::FenceCreateFlagBits::eSignaled) : vk::raii::Fence(nullptr),
+            .presentSwapchainGeneration = 0
         });
     }
 
     return syncObjects;
 }
+
+std::vector<vk::raii::Semaphore> MyRenderer::createRenderFinishedSemaphores(const Environment& environment)
+{
+    std::vector<vk::raii::Semaphore> semaphores;
+    semaphores.reserve(environment.getSwapchainImages().size());
+    for (size_t i = 0; i < environment.getSwapchainImages().size(); ++i)
+    {
+        semaphores.push_back(environment.createSemaphore());
+    }
+
+    return semaphores;
+}
@@ -5,31 +5,80 @@
 #define VULKAN_HPP_NO_CONSTRUCTORS
 #include <vulkan/vulkan_raii.hpp>
 
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+
 #include "vertex.h"
+#include "draw_item.h"
 #include "utils/window.h"
 #include "utils/environment.h"
 #include "utils/render_pipeline.h"
 #include "utils/i_buffer.h"
 #include "utils/device_local_image.h"
+#include "utils/cascaded_shadow_map.h"
+#include "utils/render_graph.h"
+#include "utils/gpu_profiler.h"
+#include "utils/frame_telemetry.h"
+#include "utils/frame_script.h"
+#include "utils/frame_readback.h"
+#include "utils/frame_queue.h"
+#include "utils/job_system.h"
+#include "utils/asset_streamer.h"
+#include "utils/scene_manifest.h"
+#include "utils/scene.h"
+#include "utils/simulation_thread.h"
+#include "utils/orbit_camera.h"
+#include "utils/resolution_controller.h"
 
 
 class MyRenderer {
+public:
+    // Matches the viewProjections array in the shaders and the minimum maxMultiviewViewCount guaranteed by Vulkan.
+    static constexpr uint32_t MaxViewCount = 6;
+
 private:
     struct SyncObjects {
         vk::raii::Semaphore imageAvailableSemaphore;
-        vk::raii::Semaphore renderFinishedSemaphore;
         vk::raii::Fence inFlightFence;
+        // Signalled by the presentation engine once done with the frame's present; null without present fences.
+        vk::raii::Fence presentFence;
+        // swapchainGeneration of the swapchain the frame last presented to.
+        uint64_t presentSwapchainGeneration;
     };
     struct UniformBufferObject
     {
-        alignas(16) glm::mat4 model;
-        alignas(16) glm::mat4 view;
-        alignas(16) glm::mat4 projection;
+        alignas(16) std::array<glm::mat4, MaxViewCount> viewProjections;
+        alignas(16) std::array<glm::mat4, CascadedShadowMap::CascadeCount> cascadeViewProjections;
+    };
+    // What a cached command buffer was recorded against; it is submitted again only while all of it still holds.
+    struct RecordedState
+    {
+        uint64_t sceneVersion;
+        uint64_t swapchainGeneration;
+        uint64_t renderGraphKey;
+        vk::Extent2D renderExtent;
+
+        bool operator==(const RecordedState&) const = default;
+    };
+    // With present fences, released once the fences of the presents made to it have signalled. Without them, once the
+    // first frame presented to a later swapchain is done on the GPU.
+    struct RetiredSwapchain
+    {
+        Environment::RetiredSwapchain swapchain;
+        std::vector<vk::raii::Semaphore> renderFinishedSemaphores;
+        std::vector<vk::raii::Fence> presentFences;
+        uint64_t nextSwapchainFrame;
     };
-    struct Model
+    // Where the counters stood when the tracked frame began; a frame that moved none of them allocates nothing by design.
+    struct AllocationCheck
     {
-        std::vector<Vertex> vertices;
-        std::vector<uint32_t> indices;
+        uint64_t frameCount;
+        uint64_t singleTimeSubmitCount;
+        uint32_t renderGraphCompileCount;
+        uint64_t swapchainGeneration;
     };
 
     static constexpr auto WindowTitle = "My Renderer";
@@ -46,41 +95,165 @@ private:
     static constexpr std::string TextureFileName = "erato-101.jpg";
 
     static constexpr uint32_t MaxFramesInFlight = 2;
+    // Windowed frames cache one command buffer per frame in flight and swapchain image; images beyond this are re-recorded every frame.
+    static constexpr uint32_t MaxCachedSwapchainImageCount = 8;
+    static constexpr uint32_t CommandBufferCount = MaxFramesInFlight * MaxCachedSwapchainImageCount;
+
+    static constexpr float CameraFieldOfView = 45.0f;
+    static constexpr float CameraNearPlane = 0.1f;
+    static constexpr float CameraFarPlane = 10.0f;
+    static constexpr FrameScript::View DefaultView = {
+        .eye = glm::vec3(2.0f, 2.0f, -0.5f),
+        .target = glm::vec3(0.0f, 0.0f, 0.0f)
+    };
+
+    // Left drags and the arrow keys orbit the camera, the scroll wheel moves it closer or further.
+    static constexpr float CameraDragSpeed = 0.005f;
+    static constexpr float CameraKeySpeed = 1.5f;
+    static constexpr float CameraScrollZoom = 0.9f;
 
-    Model model;
-    Window window;
+    static constexpr glm::vec3 LightDirection = glm::vec3(-0.3f, -0.5f, -1.0f);
+
+    static constexpr auto StatisticsReportInterval = std::chrono::seconds(1);
+    static constexpr int GpuProfileDumpKey = GLFW_KEY_P;
+    static constexpr int MemoryReportDumpKey = GLFW_KEY_M;
+    // Frames before this may still allocate while caches, histories and driver pools fill up.
+    static constexpr uint64_t AllocationWarmupFrameCount = 8;
+
+    uint32_t viewCount;
+    // Null when the renderer runs its jobs on a job system shared with other renderers.
+    std::unique_ptr<JobSystem> ownedJobSystem;
+    std::reference_wrapper<JobSystem> jobSystem;
+    std::unique_ptr<Window> window;
     Environment environment;
+    AssetStreamer assetStreamer;
+    // Created before the pipeline, so in parallel startup its first loads overlap pipeline creation.
+    Scene scene;
     RenderPipeline renderPipeline;
-    DeviceLocalImage depthImage;
-    std::unique_ptr<IBuffer> vertexBuffer;
-    std::unique_ptr<IBuffer> indexBuffer;
     std::vector<std::unique_ptr<IBuffer>> uniformBuffers;
-    DeviceLocalImage textureImage;
-    vk::raii::Sampler textureSampler;
+    CascadedShadowMap cascadedShadowMap;
     std::vector<vk::raii::DescriptorSet> descriptorSets;
-    std::vector<vk::raii::Framebuffer> swapchainFramebuffers;
+    RenderGraph renderGraph;
+    RenderGraph::ResourceHandle sceneColorTarget;
+    RenderGraph::ResourceHandle sceneDepthTarget;
+    // The swapchain image or headless color target; the scene color target itself unless dynamic resolution is on.
+    RenderGraph::ResourceHandle outputColorTarget;
     std::vector<vk::raii::CommandBuffer> graphicsCommandBuffers;
+    std::vector<std::optional<RecordedState>> recordedStates;
+    std::array<std::optional<uint32_t>, MaxFramesInFlight> submittedCommandBuffers;
+    uint64_t commandBufferRecordCount;
     std::vector<SyncObjects> syncObjects;
+    // One per swapchain image: a present may still wait on it after the frame slot that signalled it comes around again.
+    std::vector<vk::raii::Semaphore> renderFinishedSemaphores;
+    std::deque<RetiredSwapchain> retiredSwapchains;
+    GpuProfiler gpuProfiler;
+    FrameTelemetry frameTelemetry;
+    std::optional<ResolutionController> resolutionController;
+    vk::Filter upscaleFilter;
+    // Part of the scene targets drawn to this frame; the whole output extent without dynamic resolution.
+    vk::Extent2D renderExtent;
+    std::unique_ptr<FrameReadback> frameReadback;
+    // Instance transforms of headless frames, which are simulated on the render thread to stay deterministic.
+    std::vector<glm::mat4> scriptedInstanceTransforms;
+    std::vector<DrawItem> drawItems;
+    // Scratch list compared against drawItems, so an unchanged scene keeps its cached command buffers.
+    std::vector<DrawItem> nextDrawItems;
+    uint64_t staticGeometryVersion;
+    // Bumped whenever the draw list changes; pipelines are only created at startup.
+    uint64_t sceneVersion;
+    uint64_t swapchainGeneration;
+    uint64_t submittedFrameCount;
+    // Event time of the newest input a present has shown, so each event's latency is recorded once.
+    std::chrono::steady_clock::time_point presentedInputEventTime;
+    AllocationCheck allocationCheck;
+    bool animated;
     uint32_t currentFrame;
 
 public:
-    MyRenderer();
+    // Headless renderers may draw up to MaxViewCount views per frame into layered targets with multiview.
+    // Draws the scene manifest at sceneManifestPath, or the default model without one. Parallel startup streams the
+    // scene in while rendering starts; otherwise every asset is resident before the constructor returns.
+    // Renderers running side by side pass one sharedJobSystem, so together they do not start more threads than there
+    // are cores; without one, the renderer starts its own.
+    explicit MyRenderer(const std::optional<vk::Extent2D> headlessExtent = std::nullopt, const uint32_t viewCount = 1, const uint32_t physicalDeviceIndex = 0, const bool pipelineStatistics = false, const bool parallelStartup = true, const std::optional<std::string>& sceneManifestPath = std::nullopt, JobSystem* sharedJobSystem = nullptr);
     ~MyRenderer();
 
+    // Renders on the calling thread while a SimulationThread prepares the next frame's snapshot.
     void run();
+    // Renders the frames handed to this worker by frameQueue and returns how many it rendered.
+    uint32_t runHeadless(const FrameScript& frameScript, const std::optional<FrameReadback::Settings>& readbackSettings, FrameQueue& frameQueue, const uint32_t worker);
+    void waitIdle() const;
+    uint32_t getSuitablePhysicalDeviceCount() const;
+    std::string getDeviceName() const;
+    // GPU time of the most recently completed frame in milliseconds.
+    float getGpuFrameTime() const;
+    vk::DeviceSize getTransientMemorySize() const;
+    // Render graph attachments that never leave their pass, in lazily allocated memory, and the part of it the device left uncommitted.
+    vk::DeviceSize getLazilyAllocatedTransientMemorySize() const;
+    vk::DeviceSize getSavedTransientMemorySize() const;
+    void dumpGpuProfile(std::ostream& stream) const;
+    // Device memory per heap and category, against the heap budgets.
+    void dumpMemoryReport(std::ostream& stream) const;
+    const FrameTelemetry& getFrameTelemetry() const;
+    void setHitchThreshold(const float milliseconds);
+    // A still scene keeps its draw list unchanged, so its cached command buffers are replayed instead of re-recorded.
+    void setAnimated(const bool enabled);
+    // Scene assets beyond this many bytes of GPU memory are evicted once out of view, least recently seen first.
+    void setAssetBudget(const vk::DeviceSize budget);
+    // Renders the scene at a scale that keeps the GPU frame time near targetFrameTime milliseconds, then upscales it
+    // to the output with a blit. The scene targets keep the output size, so scale changes never reallocate them. The
+    // scale follows GPU timing, so frames are not reproducible from run to run; scripted batch runs do not offer it.
+    void setDynamicResolution(const float targetFrameTime);
+    // Fraction of the output width and height the scene is rendered at; 1 without dynamic resolution.
+    float getRenderScale() const;
+
+    // A thread per core but one, which the renderer's own thread keeps for device creation and recording.
+    static uint32_t getDefaultJobWorkerCount();
 
-    void update() const;
-    void drawFrame();
+    void update(const float time, const std::span<const FrameScript::View> views);
+    // Builds the draw list and uniforms of the next frame from simulated instance transforms and views. Waits for the
+    // GPU to be done with the frame slot first, since its uniform buffer is rewritten.
+    void updateFrame(const std::span<const glm::mat4> instanceTransforms, const std::span<const FrameScript::View> views);
+    // Submit the frame updateFrame prepared; drawFrame also records the input latency from inputEventTime to its
+    // present, the first time a present shows that event.
+    void drawFrame(const std::optional<std::chrono::steady_clock::time_point> inputEventTime);
+    void drawHeadlessFrame(const uint32_t frameNumber);
+    // Bracket the update and draw of a frame. In builds defining MY_RENDERER_TRACK_ALLOCATIONS, a frame past warmup that
+    // allocates on the render thread without an upload, graph compile or swapchain recreation to account for it has its
+    // allocations reported, and endAllocationCheck throws a logic_error.
+    void beginAllocationCheck();
+    void endAllocationCheck();
 
-    void recordRenderCommand(const vk::CommandBuffer& commandBuffer, const uint32_t imageIndex) const;
+    void declareRenderGraph(const std::optional<uint32_t> swapchainImageIndex, const std::optional<uint32_t> readbackSlot);
+    // Re-records the command buffer at commandBufferIndex unless its cached recording is still valid, and returns it.
+    const vk::raii::CommandBuffer& prepareCommandBuffer(const uint32_t commandBufferIndex, const bool cacheable);
+    void recordRenderCommand(const vk::CommandBuffer& commandBuffer, const uint32_t commandBufferIndex);
+    void recordScenePass(const vk::CommandBuffer& commandBuffer) const;
+    void recordUpscalePass(const vk::CommandBuffer& commandBuffer) const;
+    // Replaces the swapchain without waiting for the device; the old one is kept until its presents are done.
     void recreateSwapchain();
+    // Moves camera by the drags, scrolls and held arrow keys of the last event poll, elapsedTime seconds after the
+    // one before, and returns when the newest of them was handled if any moved it.
+    std::optional<std::chrono::steady_clock::time_point> pollCameraInput(OrbitCamera& camera, const std::chrono::steady_clock::time_point pollTime, const float elapsedTime);
+    void releaseRetiredSwapchains();
+    // Waits for the frame slot's previous submission and present, then collects what they measured.
+    void waitForFrameSlot();
+    // The presentation engine signals present fences on its own, so waiting for the device to idle does not cover them.
+    void waitForPresentFences() const;
+    void writeDescriptorSets() const;
+    // Submits pending asset uploads and installs the scene assets that finished streaming.
+    void pollAssetStreams();
+    void collectGpuTimings(const uint32_t frameIndex);
+    // Ends a frame started at frameStartTime, attributing a hitch to uploads or graph compiles if their counters moved.
+    void recordFrameTelemetry(const std::chrono::steady_clock::time_point frameStartTime, const uint64_t singleTimeSubmitCount, const uint32_t renderGraphCompileCount);
+    uint32_t getViewMask() const;
+    void reportStatistics() const;
 
-    static Model loadModel(const std::string& path);
+    static uint32_t checkViewCount(const uint32_t viewCount, const bool headless);
+    static SceneManifest loadSceneManifest(const std::optional<std::string>& path);
     static std::vector<std::unique_ptr<IBuffer>> createUniformBuffers(const Environment& environment, const uint32_t count);
-    static DeviceLocalImage createTextureImage(const Environment& environment);
-    static vk::raii::Sampler createTextureSampler(const Environment& environment);
-    static std::vector<vk::raii::Framebuffer> createSwapchainFramebuffers(const Environment& environment, const vk::raii::RenderPass& renderPass, const vk::raii::ImageView& depthImageView);
     static std::vector<SyncObjects> createSyncObjects(const Environment& environment, const uint32_t count);
+    static std::vector<vk::raii::Semaphore> createRenderFinishedSemaphores(const Environment& environment);
 };
 
 
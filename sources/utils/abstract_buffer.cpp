@@ -33,6 +33,11 @@ const vk::raii::Buffer& AbstractBuffer::getBuffer() const
     return buffer;
 }
 
+vk::DeviceSize AbstractBuffer::getSize() const
+{
+    return size;
+}
+
 vk::raii::Buffer AbstractBuffer::createBuffer(const vk::DeviceSize size, const vk::BufferUsageFlags usage) const
 {
     const vk::BufferCreateInfo createInfo{
@@ -46,17 +51,11 @@ vk::raii::Buffer AbstractBuffer::createBuffer(const vk::DeviceSize size, const v
     return environment.get().device.createBuffer(createInfo);
 }
 
-vk::raii::DeviceMemory AbstractBuffer::bindBufferMemory(const vk::raii::Buffer& buffer, const vk::MemoryPropertyFlags properties) const
+DeviceMemoryTracker::Allocation AbstractBuffer::bindBufferMemory(const vk::raii::Buffer& buffer, const vk::MemoryPropertyFlags properties,
+    const DeviceMemoryTracker::Category category) const
 {
-    const vk::MemoryRequirements memoryRequirements = buffer.getMemoryRequirements();
-
-    const vk::MemoryAllocateInfo allocateInfo{
-        .allocationSize = memoryRequirements.size,
-        .memoryTypeIndex = environment.get().findMemoryType(memoryRequirements.memoryTypeBits, properties)
-    };
-
-    vk::raii::DeviceMemory bufferMemory = environment.get().device.allocateMemory(allocateInfo);
-    buffer.bindMemory(*bufferMemory, 0);
+    DeviceMemoryTracker::Allocation bufferMemory = environment.get().allocateMemory(buffer.getMemoryRequirements(), properties, category);
+    buffer.bindMemory(*bufferMemory.getMemory(), 0);
 
     return bufferMemory;
 }
@@ -23,10 +23,11 @@ public:
     AbstractBuffer& operator=(AbstractBuffer&& other) noexcept;
 
     const vk::raii::Buffer& getBuffer() const override;
+    vk::DeviceSize getSize() const;
 
 protected:
     vk::raii::Buffer createBuffer(const vk::DeviceSize size, const vk::BufferUsageFlags usage) const;
-    vk::raii::DeviceMemory bindBufferMemory(const vk::raii::Buffer& buffer, const vk::MemoryPropertyFlags properties) const;
+    DeviceMemoryTracker::Allocation bindBufferMemory(const vk::raii::Buffer& buffer, const vk::MemoryPropertyFlags properties, const DeviceMemoryTracker::Category category) const;
 };
 
 
@@ -0,0 +1,167 @@
+#include "allocation_tracker.h"
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define ALLOCATION_TRACKER_HAS_BACKTRACE
+#endif
+
+
+namespace
+{
+    // recordAllocation and operator new sit on top of every captured stack.
+    constexpr int SkippedFrameCount = 2;
+}
+
+thread_local AllocationTracker::ThreadState AllocationTracker::threadState{};
+
+AllocationTracker::Exclusion::Exclusion()
+{
+    ++threadState.exclusionDepth;
+}
+
+AllocationTracker::Exclusion::~Exclusion()
+{
+    --threadState.exclusionDepth;
+}
+
+bool AllocationTracker::isEnabled()
+{
+#ifdef MY_RENDERER_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AllocationTracker::begin()
+{
+    threadState.isTracking = true;
+    threadState.allocationCount = 0;
+    threadState.allocatedSize = 0;
+    threadState.callSiteCount = 0;
+}
+
+uint64_t AllocationTracker::end()
+{
+    threadState.isTracking = false;
+
+    return threadState.allocationCount;
+}
+
+void AllocationTracker::report(std::ostream& stream)
+{
+    std::ostringstream report;
+    report << threadState.allocationCount << " heap allocations (" << threadState.allocatedSize << " bytes) while tracking";
+    if (threadState.callSiteCount == 0)
+    {
+        stream << report.str() << "." << std::endl;
+        return;
+    }
+    report << ", first " << threadState.callSiteCount << ":\n";
+
+    for (uint32_t i = 0; i < threadState.callSiteCount; ++i)
+    {
+        const CallSite& callSite = threadState.callSites[i];
+        report << "  #" << i << " " << callSite.size << " bytes\n";
+
+#ifdef ALLOCATION_TRACKER_HAS_BACKTRACE
+        char** symbols = backtrace_symbols(callSite.frames.data(), static_cast<int>(callSite.frameCount));
+        for (uint32_t j = 0; j < callSite.frameCount; ++j)
+        {
+            report << "    " << (symbols != nullptr ? symbols[j] : "?") << "\n";
+        }
+        std::free(symbols);
+#else
+        report << "    call stacks are unavailable on this platform\n";
+#endif
+    }
+
+    stream << report.str() << std::flush;
+}
+
+void AllocationTracker::recordAllocation(const size_t size)
+{
+    if (!threadState.isTracking or threadState.isRecording or threadState.exclusionDepth > 0)
+    {
+        return;
+    }
+    // Capturing a stack may allocate itself the first time; those allocations are not the caller's.
+    threadState.isRecording = true;
+
+    ++threadState.allocationCount;
+    threadState.allocatedSize += size;
+
+    if (threadState.callSiteCount < MaxCallSites)
+    {
+        CallSite& callSite = threadState.callSites[threadState.callSiteCount++];
+        callSite.size = size;
+        callSite.frameCount = 0;
+
+#ifdef ALLOCATION_TRACKER_HAS_BACKTRACE
+        std::array<void*, MaxStackDepth + SkippedFrameCount> frames;
+        const int frameCount = backtrace(frames.data(), static_cast<int>(frames.size()));
+        if (frameCount > SkippedFrameCount)
+        {
+            callSite.frameCount = static_cast<uint32_t>(frameCount - SkippedFrameCount);
+            std::copy_n(frames.begin() + SkippedFrameCount, callSite.frameCount, callSite.frames.begin());
+        }
+#endif
+    }
+
+    threadState.isRecording = false;
+}
+
+#ifdef MY_RENDERER_TRACK_ALLOCATIONS
+// The array and nothrow forms forward to these by default. The sized deletes are replaced too, since a standard
+// library whose own sized deletes do not forward would hand them memory it did not allocate.
+void* operator new(const std::size_t size)
+{
+    AllocationTracker::recordAllocation(size);
+
+    void* pointer = std::malloc(std::max<std::size_t>(size, 1));
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+    AllocationTracker::recordAllocation(size);
+
+    const auto alignmentValue = static_cast<std::size_t>(alignment);
+    void* pointer = std::aligned_alloc(alignmentValue, (std::max<std::size_t>(size, 1) + alignmentValue - 1) / alignmentValue * alignmentValue);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, const std::align_val_t alignment) noexcept
+{
+    operator delete(pointer, alignment);
+}
+#endif
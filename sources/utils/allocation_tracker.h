@@ -0,0 +1,63 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+
+// Counts the heap allocations a thread makes between begin and end, keeping the call stacks of the first
+// MaxCallSites of them. Only the thread calling begin is covered: the renderer tracks its render thread, and
+// allocations on the simulation, job and encode threads go uncounted. Counting relies on the global operator new
+// replacements that are only compiled into builds defining MY_RENDERER_TRACK_ALLOCATIONS; elsewhere end always
+// returns 0.
+class AllocationTracker {
+public:
+    static constexpr uint32_t MaxCallSites = 16;
+    static constexpr uint32_t MaxStackDepth = 8;
+
+    // Leaves the allocations of its lifetime uncounted, for paths that allocate by design. Exclusions nest.
+    class Exclusion {
+    public:
+        Exclusion();
+        ~Exclusion();
+
+        Exclusion(const Exclusion&) = delete;
+        Exclusion& operator=(const Exclusion&) = delete;
+    };
+
+private:
+    struct CallSite
+    {
+        size_t size;
+        uint32_t frameCount;
+        std::array<void*, MaxStackDepth> frames;
+    };
+    // Trivially constructible so the hook never allocates to set up its own state.
+    struct ThreadState
+    {
+        bool isTracking;
+        bool isRecording;
+        uint32_t exclusionDepth;
+        uint64_t allocationCount;
+        uint64_t allocatedSize;
+        uint32_t callSiteCount;
+        std::array<CallSite, MaxCallSites> callSites;
+    };
+
+    static thread_local ThreadState threadState;
+
+public:
+    static bool isEnabled();
+    static void begin();
+    // Stops tracking and returns the number of allocations made since begin.
+    static uint64_t end();
+    // Describes the allocations of the last tracked span of this thread.
+    static void report(std::ostream& stream);
+    static void recordAllocation(const size_t size);
+};
+
+
+#endif //ALLOCATION_TRACKER_H
@@ -0,0 +1,174 @@
+#include "asset_streamer.h"
+
+
+#include "cpu_tracer.h"
+
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+
+AssetStreamer::SubmitAwaiter::SubmitAwaiter(AssetStreamer& streamer, RecordFunction record) :
+    streamer(streamer),
+    record(std::move(record)),
+    continuation(),
+    exception()
+{
+}
+
+bool AssetStreamer::SubmitAwaiter::await_ready() const noexcept
+{
+    return false;
+}
+
+void AssetStreamer::SubmitAwaiter::await_suspend(const std::coroutine_handle<> continuation)
+{
+    this->continuation = continuation;
+    streamer.get().enqueue(*this);
+}
+
+void AssetStreamer::SubmitAwaiter::await_resume() const
+{
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+AssetStreamer::AssetStreamer(const Environment& environment, JobSystem& jobSystem) :
+    environment(environment),
+    jobSystem(jobSystem),
+    timelineSemaphore(environment.createTimelineSemaphore()),
+    nextTimelineValue(1),
+    mutex(),
+    queuedSubmits(),
+    inFlightSubmits(),
+    completedSubmitCount(0)
+{
+}
+
+AssetStreamer::~AssetStreamer()
+{
+    if (inFlightSubmits.empty())
+    {
+        return;
+    }
+
+    // The command buffers may not be freed while the GPU still executes them.
+    const uint64_t lastTimelineValue = inFlightSubmits.back().timelineValue;
+    const vk::SemaphoreWaitInfo waitInfo{
+        .semaphoreCount = 1,
+        .pSemaphores = &*timelineSemaphore,
+        .pValues = &lastTimelineValue
+    };
+
+    static_cast<void>(environment.get().device.waitSemaphores(waitInfo, std::numeric_limits<uint64_t>::max()));
+}
+
+AssetStreamer::SubmitAwaiter AssetStreamer::submit(RecordFunction record)
+{
+    return SubmitAwaiter(*this, std::move(record));
+}
+
+void AssetStreamer::poll()
+{
+    TRACE_SCOPE("Poll asset streamer");
+
+    std::vector<SubmitAwaiter*> submits;
+    {
+        std::lock_guard lock(mutex);
+        submits.swap(queuedSubmits);
+    }
+
+    for (SubmitAwaiter* awaiter : submits)
+    {
+        try
+        {
+            vk::raii::CommandBuffer commandBuffer = environment.get().beginSingleTimeCommands();
+            awaiter->record(*commandBuffer);
+            commandBuffer.end();
+
+            const uint64_t signalValue = nextTimelineValue;
+            const vk::CommandBufferSubmitInfo commandBufferSubmitInfo{
+                .commandBuffer = *commandBuffer,
+                .deviceMask = 0
+            };
+            const vk::SemaphoreSubmitInfo signalSemaphoreInfo{
+                .semaphore = *timelineSemaphore,
+                .value = signalValue,
+                .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+                .deviceIndex = 0
+            };
+            const vk::SubmitInfo2 submitInfo{
+                .waitSemaphoreInfoCount = 0,
+                .pWaitSemaphoreInfos = nullptr,
+                .commandBufferInfoCount = 1,
+                .pCommandBufferInfos = &commandBufferSubmitInfo,
+                .signalSemaphoreInfoCount = 1,
+                .pSignalSemaphoreInfos = &signalSemaphoreInfo
+            };
+            environment.get().graphicsQueue.submit2(submitInfo);
+            ++nextTimelineValue;
+
+            inFlightSubmits.push_back({
+                .timelineValue = signalValue,
+                .commandBuffer = std::move(commandBuffer),
+                .continuation = awaiter->continuation
+            });
+        }
+        catch (...)
+        {
+            awaiter->exception = std::current_exception();
+            resume(awaiter->continuation);
+        }
+    }
+
+    // Submits signal in increasing order, so the completed ones are always at the front.
+    const uint64_t completedValue = timelineSemaphore.getCounterValue();
+    while (!inFlightSubmits.empty() and inFlightSubmits.front().timelineValue <= completedValue)
+    {
+        resume(inFlightSubmits.front().continuation);
+        inFlightSubmits.pop_front();
+        ++completedSubmitCount;
+    }
+}
+
+bool AssetStreamer::isIdle() const
+{
+    std::lock_guard lock(mutex);
+    return queuedSubmits.empty() and inFlightSubmits.empty();
+}
+
+uint64_t AssetStreamer::getCompletedSubmitCount() const
+{
+    return completedSubmitCount;
+}
+
+std::vector<std::byte> AssetStreamer::loadFile(const std::string& path)
+{
+    TRACE_SCOPE("Read file");
+
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open file " + path + ".");
+    }
+
+    std::vector<std::byte> contents(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+
+    return contents;
+}
+
+void AssetStreamer::enqueue(SubmitAwaiter& awaiter)
+{
+    std::lock_guard lock(mutex);
+    queuedSubmits.push_back(&awaiter);
+}
+
+void AssetStreamer::resume(const std::coroutine_handle<> continuation)
+{
+    // Continuations go to a worker so what follows the GPU work, often more decoding, stays off the frame.
+    jobSystem.get().submitDetached([continuation] { continuation.resume(); });
+}
@@ -0,0 +1,156 @@
+#ifndef ASSET_STREAMER_H
+#define ASSET_STREAMER_H
+
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <vulkan/vulkan_raii.hpp>
+
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "environment.h"
+#include "job_system.h"
+
+
+// Awaitables for asset coroutines. File reads and decoding run as jobs and resume the coroutine on the worker that
+// finished them. GPU work is recorded and submitted by poll on the thread that owns the graphics queue, which resumes
+// the coroutine on a worker once a timeline semaphore shows the work complete, so neither side ever blocks.
+class AssetStreamer {
+public:
+    using RecordFunction = std::function<void(const vk::CommandBuffer&)>;
+
+    template<typename F>
+    class JobAwaiter {
+    public:
+        using Result = std::invoke_result_t<F&>;
+
+    private:
+        std::reference_wrapper<JobSystem> jobSystem;
+        F function;
+        std::optional<Result> result;
+        std::exception_ptr exception;
+
+    public:
+        JobAwaiter(JobSystem& jobSystem, F function) :
+            jobSystem(jobSystem),
+            function(std::move(function)),
+            result(),
+            exception()
+        {
+        }
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(const std::coroutine_handle<> continuation)
+        {
+            // The awaiter lives in the coroutine frame, which the resumed coroutine may free, so nothing touches it afterwards.
+            jobSystem.get().submitDetached([this, continuation]
+            {
+                try
+                {
+                    result.emplace(function());
+                }
+                catch (...)
+                {
+                    exception = std::current_exception();
+                }
+                continuation.resume();
+            });
+        }
+
+        Result await_resume()
+        {
+            if (exception)
+            {
+                std::rethrow_exception(exception);
+            }
+
+            return std::move(result.value());
+        }
+    };
+
+    class SubmitAwaiter {
+    private:
+        friend class AssetStreamer;
+
+        std::reference_wrapper<AssetStreamer> streamer;
+        RecordFunction record;
+        std::coroutine_handle<> continuation;
+        std::exception_ptr exception;
+
+    public:
+        SubmitAwaiter(AssetStreamer& streamer, RecordFunction record);
+
+        bool await_ready() const noexcept;
+        void await_suspend(const std::coroutine_handle<> continuation);
+        void await_resume() const;
+    };
+
+private:
+    struct InFlightSubmit
+    {
+        uint64_t timelineValue;
+        vk::raii::CommandBuffer commandBuffer;
+        std::coroutine_handle<> continuation;
+    };
+
+    std::reference_wrapper<const Environment> environment;
+    std::reference_wrapper<JobSystem> jobSystem;
+    vk::raii::Semaphore timelineSemaphore;
+    uint64_t nextTimelineValue;
+    mutable std::mutex mutex;
+    std::vector<SubmitAwaiter*> queuedSubmits;
+    std::deque<InFlightSubmit> inFlightSubmits;
+    uint64_t completedSubmitCount;
+
+public:
+    AssetStreamer(const Environment& environment, JobSystem& jobSystem);
+    // Waits for submitted GPU work. Coroutines still suspended on this streamer must have finished before it goes away.
+    ~AssetStreamer();
+
+    AssetStreamer(const AssetStreamer&) = delete;
+    AssetStreamer& operator=(const AssetStreamer&) = delete;
+
+    // co_await yields function() computed on a job worker. The coroutine stays suspended meanwhile, so function
+    // captures its locals by reference rather than copying them into the awaiter.
+    template<typename F>
+    JobAwaiter<F> runJob(F function)
+    {
+        return JobAwaiter<F>(jobSystem.get(), std::move(function));
+    }
+
+    auto readFile(const std::string& path)
+    {
+        return runJob([&path] { return loadFile(path); });
+    }
+
+    // co_await returns once the commands record writes have finished on the GPU. Everything record references
+    // must outlive the co_await, which keeping it in the coroutine frame guarantees.
+    SubmitAwaiter submit(RecordFunction record);
+
+    // poll runs once per frame on the thread that submits to the graphics queue, and only that thread asks isIdle.
+    void poll();
+    bool isIdle() const;
+    uint64_t getCompletedSubmitCount() const;
+
+    static std::vector<std::byte> loadFile(const std::string& path);
+
+private:
+    void enqueue(SubmitAwaiter& awaiter);
+    void resume(const std::coroutine_handle<> continuation);
+};
+
+
+#endif //ASSET_STREAMER_H
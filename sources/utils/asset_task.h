@@ -0,0 +1,103 @@
+#ifndef ASSET_TASK_H
+#define ASSET_TASK_H
+
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+
+// Handle to an asset coroutine. The coroutine starts on the calling thread and continues on whichever thread resumes
+// the operation it awaits, so the owner polls ready instead of blocking. The coroutine frees its own frame when it
+// finishes and the handle only shares its result, so dropping an unfinished handle simply discards the result.
+template<typename T>
+class AssetTask {
+private:
+    struct Result
+    {
+        std::atomic<bool> isDone = false;
+        std::optional<T> value;
+        std::exception_ptr exception;
+    };
+
+public:
+    struct promise_type
+    {
+        std::shared_ptr<Result> result = std::make_shared<Result>();
+
+        // The promise outlives the coroutine's locals, so a ready task no longer touches anything they referenced.
+        ~promise_type()
+        {
+            result->isDone.store(true, std::memory_order_release);
+        }
+
+        AssetTask get_return_object()
+        {
+            return AssetTask(result);
+        }
+
+        std::suspend_never initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        void return_value(T value)
+        {
+            result->value.emplace(std::move(value));
+        }
+
+        void unhandled_exception()
+        {
+            result->exception = std::current_exception();
+        }
+    };
+
+private:
+    std::shared_ptr<Result> result;
+
+public:
+    bool ready() const
+    {
+        return result and result->isDone.load(std::memory_order_acquire);
+    }
+
+    // Takes the result once ready, rethrowing whatever the coroutine threw.
+    T get()
+    {
+        if (!ready())
+        {
+            throw std::logic_error("Asset task is not ready.");
+        }
+
+        if (result->exception)
+        {
+            std::rethrow_exception(result->exception);
+        }
+        if (!result->value.has_value())
+        {
+            throw std::logic_error("Asset task result was already taken.");
+        }
+
+        T value = std::move(result->value.value());
+        result->value.reset();
+        return value;
+    }
+
+private:
+    explicit AssetTask(std::shared_ptr<Result> result) :
+        result(std::move(result))
+    {
+    }
+};
+
+
+#endif //ASSET_TASK_H
@@ -0,0 +1,291 @@
+#include "cascaded_shadow_map.h"
+
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+
+CascadedShadowMap::CascadedShadowMap(const Environment& environment) :
+    environment(environment),
+    shadowPipeline(environment),
+    depthImage(environment, { Resolution, Resolution }, environment.shadowDepthFormat, vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eDepth, CascadeCount),
+    cascadeImageViews(createCascadeImageViews()),
+    sampler(createSampler()),
+    cascades(),
+    cascadeStates(),
+    cachedCascades(),
+    initialized(false)
+{
+}
+
+CascadedShadowMap::~CascadedShadowMap() = default;
+
+void CascadedShadowMap::update(const Camera& camera, const glm::vec3& lightDirection,
+    const std::vector<DrawItem>& drawItems, const uint64_t staticGeometryVersion)
+{
+    const glm::vec3 direction = glm::normalize(lightDirection);
+    const glm::vec3 up = std::abs(direction.z) > 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+    const glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), direction, up);
+    const glm::mat4 inverseLightRotation = glm::inverse(lightRotation);
+    const glm::mat4 inverseView = glm::inverse(camera.view);
+
+    const float tanHalfFieldOfView = std::tan(camera.fieldOfView * 0.5f);
+    const std::array<float, CascadeCount> splitDepths = computeSplitDepths(camera.nearPlane, camera.farPlane);
+
+    float sliceNear = camera.nearPlane;
+    for (uint32_t i = 0; i < CascadeCount; ++i)
+    {
+        const float sliceFar = splitDepths[i];
+
+        std::array<glm::vec3, 8> corners;
+        for (uint32_t j = 0; j < corners.size(); ++j)
+        {
+            const float depth = j < 4 ? sliceNear : sliceFar;
+            const float x = (j & 1 ? 1.0f : -1.0f) * depth * tanHalfFieldOfView * camera.aspectRatio;
+            const float y = (j & 2 ? 1.0f : -1.0f) * depth * tanHalfFieldOfView;
+            corners[j] = glm::vec3(inverseView * glm::vec4(x, y, -depth, 1.0f));
+        }
+
+        glm::vec3 center(0.0f);
+        for (const glm::vec3& corner : corners)
+        {
+            center += corner / static_cast<float>(corners.size());
+        }
+
+        // The sphere radius only depends on the slice shape, so rounding it keeps the projection size constant while the camera rotates.
+        float radius = 0.0f;
+        for (const glm::vec3& corner : corners)
+        {
+            radius = std::max(radius, glm::length(corner - center));
+        }
+        radius = std::ceil(radius * RadiusGranularity) / RadiusGranularity;
+
+        // Snapping the center to whole texels in light space keeps the matrix bit-identical until the camera moves by a texel.
+        const float texelSize = 2.0f * radius / static_cast<float>(Resolution);
+        glm::vec3 lightSpaceCenter = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+        lightSpaceCenter = glm::floor(lightSpaceCenter / texelSize) * texelSize;
+        const glm::vec3 snappedCenter = glm::vec3(inverseLightRotation * glm::vec4(lightSpaceCenter, 1.0f));
+
+        const glm::mat4 lightView = glm::lookAt(snappedCenter - direction * radius * CasterDepthScale, snappedCenter, up);
+        const glm::mat4 lightProjection = glm::orthoRH_ZO(-radius, radius, -radius, radius, 0.0f, radius * (CasterDepthScale + 1.0f));
+
+        cascades[i] = Cascade{
+            .viewProjection = lightProjection * lightView,
+            .splitDepth = sliceFar
+        };
+
+        CascadeState& cascadeState = cascadeStates[i];
+        cascadeState.lightView = lightView;
+        cascadeState.radius = radius;
+
+        bool containsDynamicCasters = false;
+        for (const DrawItem& drawItem : drawItems)
+        {
+            if (!drawItem.isStatic and overlapsCascade(cascadeState, drawItem))
+            {
+                containsDynamicCasters = true;
+                break;
+            }
+        }
+
+        const bool isDirty = !cascadeState.hasRendered or
+            containsDynamicCasters or
+            cascadeState.containedDynamicCasters or
+            cascadeState.renderedStaticGeometryVersion != staticGeometryVersion or
+            cascadeState.renderedViewProjection != cascades[i].viewProjection;
+
+        if (isDirty)
+        {
+            cascadeState.renderedViewProjection = cascades[i].viewProjection;
+            cascadeState.renderedStaticGeometryVersion = staticGeometryVersion;
+            cascadeState.hasRendered = true;
+            cascadeState.containedDynamicCasters = containsDynamicCasters;
+            cascadeState.pending = true;
+        }
+
+        sliceNear = sliceFar;
+    }
+}
+
+void CascadedShadowMap::record(const vk::CommandBuffer& commandBuffer, const std::vector<DrawItem>& drawItems, GpuProfiler& profiler) const
+{
+    constexpr vk::Extent2D extent{ Resolution, Resolution };
+
+    const vk::Viewport viewport{
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = static_cast<float>(Resolution),
+        .height = static_cast<float>(Resolution),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f
+    };
+    const vk::Rect2D scissor{
+        .offset = { 0, 0 },
+        .extent = extent
+    };
+
+    for (uint32_t i = 0; i < CascadeCount; ++i)
+    {
+        if (!cascadeStates[i].pending)
+        {
+            continue;
+        }
+
+        const GpuProfiler::Scope cascadeScope(profiler, commandBuffer, CascadeScopeNames[i]);
+
+        const vk::RenderingAttachmentInfo depthAttachmentInfo{
+            .imageView = *cascadeImageViews[i],
+            .imageLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+            .resolveMode = vk::ResolveModeFlagBits::eNone,
+            .loadOp = vk::AttachmentLoadOp::eClear,
+            .storeOp = vk::AttachmentStoreOp::eStore,
+            .clearValue = vk::ClearValue{ .depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 } }
+        };
+
+        const vk::RenderingInfo renderingInfo{
+            .renderArea = scissor,
+            .layerCount = 1,
+            .viewMask = 0,
+            .colorAttachmentCount = 0,
+            .pColorAttachments = nullptr,
+            .pDepthAttachment = &depthAttachmentInfo,
+            .pStencilAttachment = nullptr
+        };
+
+        commandBuffer.beginRendering(renderingInfo);
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *shadowPipeline.pipeline);
+
+        commandBuffer.setViewport(0, viewport);
+        commandBuffer.setScissor(0, scissor);
+
+        // Buffers are only rebound between draw items of different meshes.
+        vk::Buffer boundPositionBuffer = nullptr;
+        for (const DrawItem& drawItem : drawItems)
+        {
+            if (drawItem.positionBuffer != boundPositionBuffer)
+            {
+                commandBuffer.bindVertexBuffers(0, drawItem.positionBuffer, { 0 });
+                commandBuffer.bindIndexBuffer(drawItem.indexBuffer, 0, vk::IndexType::eUint32);
+                boundPositionBuffer = drawItem.positionBuffer;
+            }
+
+            const ShadowPipeline::PushConstants pushConstants{
+                .lightModelViewProjection = cascades[i].viewProjection * drawItem.transform
+            };
+
+            commandBuffer.pushConstants(*shadowPipeline.pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(pushConstants), &pushConstants);
+            commandBuffer.drawIndexed(drawItem.indexCount, 1, drawItem.firstIndex, drawItem.vertexOffset, 0);
+        }
+
+        commandBuffer.endRendering();
+    }
+}
+
+void CascadedShadowMap::commit()
+{
+    initialized = initialized or hasPendingCascades();
+
+    for (uint32_t i = 0; i < CascadeCount; ++i)
+    {
+        cachedCascades[i] = !cascadeStates[i].pending;
+        cascadeStates[i].pending = false;
+    }
+}
+
+const std::array<CascadedShadowMap::Cascade, CascadedShadowMap::CascadeCount>& CascadedShadowMap::getCascades() const
+{
+    return cascades;
+}
+
+bool CascadedShadowMap::isCascadeCached(const uint32_t cascadeIndex) const
+{
+    return cachedCascades[cascadeIndex];
+}
+
+bool CascadedShadowMap::hasPendingCascades() const
+{
+    return std::ranges::any_of(cascadeStates, [](const CascadeState& cascadeState) { return cascadeState.pending; });
+}
+
+bool CascadedShadowMap::isInitialized() const
+{
+    return initialized;
+}
+
+const vk::raii::Image& CascadedShadowMap::getImage() const
+{
+    return depthImage.getImage();
+}
+
+const vk::raii::ImageView& CascadedShadowMap::getImageView() const
+{
+    return depthImage.imageView;
+}
+
+const vk::raii::Sampler& CascadedShadowMap::getSampler() const
+{
+    return sampler;
+}
+
+std::vector<vk::raii::ImageView> CascadedShadowMap::createCascadeImageViews() const
+{
+    std::vector<vk::raii::ImageView> imageViews;
+    imageViews.reserve(CascadeCount);
+    for (uint32_t i = 0; i < CascadeCount; ++i)
+    {
+        imageViews.emplace_back(depthImage.createLayerImageView(i));
+    }
+
+    return imageViews;
+}
+
+vk::raii::Sampler CascadedShadowMap::createSampler() const
+{
+    constexpr vk::SamplerCreateInfo createInfo{
+        .magFilter = vk::Filter::eLinear,
+        .minFilter = vk::Filter::eLinear,
+        .mipmapMode = vk::SamplerMipmapMode::eNearest,
+        .addressModeU = vk::SamplerAddressMode::eClampToBorder,
+        .addressModeV = vk::SamplerAddressMode::eClampToBorder,
+        .addressModeW = vk::SamplerAddressMode::eClampToBorder,
+        .mipLodBias = 0.0f,
+        .anisotropyEnable = vk::False,
+        .maxAnisotropy = 1.0f,
+        .compareEnable = vk::True,
+        .compareOp = vk::CompareOp::eLessOrEqual,
+        .minLod = 0.0f,
+        .maxLod = 0.0f,
+        .borderColor = vk::BorderColor::eFloatOpaqueWhite,
+        .unnormalizedCoordinates = vk::False
+    };
+
+    return environment.get().device.createSampler(createInfo);
+}
+
+std::array<float, CascadedShadowMap::CascadeCount> CascadedShadowMap::computeSplitDepths(const float nearPlane, const float farPlane)
+{
+    std::array<float, CascadeCount> splitDepths;
+    for (uint32_t i = 0; i < CascadeCount; ++i)
+    {
+        const float fraction = static_cast<float>(i + 1) / static_cast<float>(CascadeCount);
+        const float logarithmicSplit = nearPlane * std::pow(farPlane / nearPlane, fraction);
+        const float uniformSplit = nearPlane + (farPlane - nearPlane) * fraction;
+        splitDepths[i] = SplitLambda * logarithmicSplit + (1.0f - SplitLambda) * uniformSplit;
+    }
+
+    return splitDepths;
+}
+
+bool CascadedShadowMap::overlapsCascade(const CascadeState& cascadeState, const DrawItem& drawItem)
+{
+    const glm::vec3 worldCenter = glm::vec3(drawItem.transform * glm::vec4(glm::vec3(drawItem.boundingSphere), 1.0f));
+    const float scale = std::max({ glm::length(glm::vec3(drawItem.transform[0])), glm::length(glm::vec3(drawItem.transform[1])), glm::length(glm::vec3(drawItem.transform[2])) });
+    const float worldRadius = drawItem.boundingSphere.w * scale;
+
+    const glm::vec3 lightSpaceCenter = glm::vec3(cascadeState.lightView * glm::vec4(worldCenter, 1.0f));
+
+    return std::abs(lightSpaceCenter.x) <= cascadeState.radius + worldRadius and
+        std::abs(lightSpaceCenter.y) <= cascadeState.radius + worldRadius;
+}
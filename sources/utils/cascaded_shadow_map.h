@@ -0,0 +1,96 @@
+#ifndef CASCADED_SHADOW_MAP_H
+#define CASCADED_SHADOW_MAP_H
+
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <vulkan/vulkan_raii.hpp>
+
+#include <glm/glm.hpp>
+
+#include "environment.h"
+#include "shadow_pipeline.h"
+#include "device_local_image.h"
+#include "gpu_profiler.h"
+#include "../draw_item.h"
+
+
+class CascadedShadowMap {
+public:
+    static constexpr uint32_t CascadeCount = 4;
+    static constexpr uint32_t Resolution = 2048;
+
+    struct Camera
+    {
+        glm::mat4 view;
+        float fieldOfView;
+        float aspectRatio;
+        float nearPlane;
+        float farPlane;
+    };
+    struct Cascade
+    {
+        glm::mat4 viewProjection;
+        float splitDepth;
+    };
+
+private:
+    struct CascadeState
+    {
+        glm::mat4 lightView;
+        float radius;
+        glm::mat4 renderedViewProjection;
+        uint64_t renderedStaticGeometryVersion;
+        bool hasRendered;
+        bool containedDynamicCasters;
+        bool pending;
+    };
+
+    static constexpr float SplitLambda = 0.75f;
+    static constexpr float CasterDepthScale = 2.0f;
+    static constexpr float RadiusGranularity = 16.0f;
+    static constexpr std::array<const char*, CascadeCount> CascadeScopeNames = {
+        "Shadow cascade 0",
+        "Shadow cascade 1",
+        "Shadow cascade 2",
+        "Shadow cascade 3"
+    };
+
+    std::reference_wrapper<const Environment> environment;
+    ShadowPipeline shadowPipeline;
+    DeviceLocalImage depthImage;
+    std::vector<vk::raii::ImageView> cascadeImageViews;
+    vk::raii::Sampler sampler;
+    std::array<Cascade, CascadeCount> cascades;
+    std::array<CascadeState, CascadeCount> cascadeStates;
+    std::array<bool, CascadeCount> cachedCascades;
+    bool initialized;
+
+public:
+    explicit CascadedShadowMap(const Environment& environment);
+    ~CascadedShadowMap();
+
+    CascadedShadowMap(const CascadedShadowMap&) = delete;
+    CascadedShadowMap& operator=(const CascadedShadowMap&) = delete;
+
+    void update(const Camera& camera, const glm::vec3& lightDirection, const std::vector<DrawItem>& drawItems, const uint64_t staticGeometryVersion);
+    void record(const vk::CommandBuffer& commandBuffer, const std::vector<DrawItem>& drawItems, GpuProfiler& profiler) const;
+    void commit();
+
+    const std::array<Cascade, CascadeCount>& getCascades() const;
+    bool isCascadeCached(const uint32_t cascadeIndex) const;
+    bool hasPendingCascades() const;
+    bool isInitialized() const;
+    const vk::raii::Image& getImage() const;
+    const vk::raii::ImageView& getImageView() const;
+    const vk::raii::Sampler& getSampler() const;
+
+private:
+    std::vector<vk::raii::ImageView> createCascadeImageViews() const;
+    vk::raii::Sampler createSampler() const;
+
+    static std::array<float, CascadeCount> computeSplitDepths(const float nearPlane, const float farPlane);
+    static bool overlapsCascade(const CascadeState& cascadeState, const DrawItem& drawItem);
+};
+
+
+#endif //CASCADED_SHADOW_MAP_H
@@ -0,0 +1,147 @@
+#include "cpu_tracer.h"
+
+
+#include <fstream>
+#include <stdexcept>
+
+
+CpuTracer::Scope::Scope(const char* name) :
+    name(name),
+    startTime(now())
+{
+}
+
+CpuTracer::Scope::~Scope()
+{
+    record(name, startTime, std::chrono::steady_clock::now());
+}
+
+bool CpuTracer::isEnabled()
+{
+#ifdef MY_RENDERER_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void CpuTracer::setThreadName(const std::string& threadName)
+{
+    ThreadBuffer& threadBuffer = getThreadBuffer();
+
+    std::lock_guard lock(getRegistry().mutex);
+    threadBuffer.threadName = threadName;
+}
+
+void CpuTracer::writeChromeTrace(std::ostream& stream)
+{
+    Registry& registry = getRegistry();
+    std::lock_guard lock(registry.mutex);
+
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    const auto separate = [&stream, &first]
+    {
+        if (!first)
+        {
+            stream << ",\n";
+        }
+        first = false;
+    };
+
+    for (const std::unique_ptr<ThreadBuffer>& threadBuffer : registry.threadBuffers)
+    {
+        separate();
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadBuffer->threadId << ",\"args\":{\"name\":\"";
+        writeEscaped(stream, threadBuffer->threadName);
+        stream << "\"}}";
+
+        const uint64_t end = threadBuffer->writeIndex.load(std::memory_order_acquire);
+        const uint64_t begin = end > EventsPerThread ? end - EventsPerThread : 0;
+        for (uint64_t i = begin; i < end; ++i)
+        {
+            const Event& event = threadBuffer->events[i % EventsPerThread];
+
+            separate();
+            stream << "{\"name\":\"";
+            writeEscaped(stream, event.name);
+            stream << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadBuffer->threadId
+                   << ",\"ts\":" << static_cast<double>(event.start) / 1e3
+                   << ",\"dur\":" << static_cast<double>(event.duration) / 1e3 << "}";
+        }
+    }
+
+    stream << "\n]}" << std::endl;
+}
+
+void CpuTracer::writeChromeTrace(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open trace file " + path + ".");
+    }
+
+    writeChromeTrace(file);
+}
+
+CpuTracer::Registry& CpuTracer::getRegistry()
+{
+    static Registry registry;
+
+    return registry;
+}
+
+CpuTracer::ThreadBuffer& CpuTracer::getThreadBuffer()
+{
+    thread_local ThreadBuffer* threadBuffer = []
+    {
+        Registry& registry = getRegistry();
+        std::lock_guard lock(registry.mutex);
+
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->threadId = static_cast<uint32_t>(registry.threadBuffers.size());
+        buffer->threadName = "Thread " + std::to_string(buffer->threadId);
+        buffer->writeIndex.store(0, std::memory_order_relaxed);
+
+        registry.threadBuffers.push_back(std::move(buffer));
+        return registry.threadBuffers.back().get();
+    }();
+
+    return *threadBuffer;
+}
+
+std::chrono::steady_clock::time_point CpuTracer::now()
+{
+    // Creating the registry first keeps every start time after the trace epoch.
+    getRegistry();
+
+    return std::chrono::steady_clock::now();
+}
+
+void CpuTracer::record(const char* name, const std::chrono::steady_clock::time_point startTime, const std::chrono::steady_clock::time_point endTime)
+{
+    ThreadBuffer& threadBuffer = getThreadBuffer();
+    const std::chrono::steady_clock::time_point epoch = getRegistry().epoch;
+
+    const uint64_t index = threadBuffer.writeIndex.load(std::memory_order_relaxed);
+    threadBuffer.events[index % EventsPerThread] = {
+        .name = name,
+        .start = std::chrono::duration_cast<std::chrono::nanoseconds>(startTime - epoch).count(),
+        .duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count()
+    };
+    threadBuffer.writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void CpuTracer::writeEscaped(std::ostream& stream, const std::string& text)
+{
+    for (const char character : text)
+    {
+        if (character == '"' or character == '\\')
+        {
+            stream << '\\';
+        }
+        stream << character;
+    }
+}
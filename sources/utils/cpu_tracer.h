@@ -0,0 +1,86 @@
+#ifndef CPU_TRACER_H
+#define CPU_TRACER_H
+
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+// Instrumentation points compile to nothing unless the build defines MY_RENDERER_TRACING.
+#ifdef MY_RENDERER_TRACING
+#define TRACE_CONCATENATE_DETAIL(a, b) a##b
+#define TRACE_CONCATENATE(a, b) TRACE_CONCATENATE_DETAIL(a, b)
+#define TRACE_SCOPE(name) const CpuTracer::Scope TRACE_CONCATENATE(traceScope, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) CpuTracer::setThreadName(name)
+#else
+#define TRACE_SCOPE(name) static_cast<void>(0)
+#define TRACE_THREAD_NAME(name) static_cast<void>(0)
+#endif
+
+
+// Collects timed scopes into one ring buffer per thread. Only the owning thread writes its ring, so recording
+// is lock-free; the registry mutex is taken once per thread and when exporting. Rings keep the most recent
+// EventsPerThread scopes, and exporting is meant to happen while traced threads are quiescent.
+class CpuTracer {
+public:
+    static constexpr uint32_t EventsPerThread = 1 << 16;
+
+    class Scope {
+    public:
+        // name must outlive the tracer; string literals are expected.
+        explicit Scope(const char* name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name;
+        std::chrono::steady_clock::time_point startTime;
+    };
+
+private:
+    struct Event
+    {
+        const char* name;
+        int64_t start;
+        int64_t duration;
+    };
+    struct ThreadBuffer
+    {
+        uint32_t threadId;
+        std::string threadName;
+        std::atomic<uint64_t> writeIndex;
+        std::array<Event, EventsPerThread> events;
+    };
+    struct Registry
+    {
+        std::mutex mutex;
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+    };
+
+public:
+    static bool isEnabled();
+    static void setThreadName(const std::string& threadName);
+    // Writes every recorded scope in the Chrome trace event format, loadable in chrome://tracing and Perfetto.
+    static void writeChromeTrace(std::ostream& stream);
+    static void writeChromeTrace(const std::string& path);
+
+private:
+    static Registry& getRegistry();
+    static ThreadBuffer& getThreadBuffer();
+    static std::chrono::steady_clock::time_point now();
+    static void record(const char* name, const std::chrono::steady_clock::time_point startTime, const std::chrono::steady_clock::time_point endTime);
+    static void writeEscaped(std::ostream& stream, const std::string& text);
+};
+
+
+#endif //CPU_TRACER_H
@@ -1,9 +1,12 @@
 #include "device_local_buffer.h"
 
 
+#include "cpu_tracer.h"
+
+
 DeviceLocalBuffer::DeviceLocalBuffer(const Environment& environment, const vk::DeviceSize size, const vk::BufferUsageFlags usage) :
     AbstractBuffer(environment, size, usage),
-    bufferMemory(bindBufferMemory(buffer, vk::MemoryPropertyFlagBits::eDeviceLocal))
+    bufferMemory(bindBufferMemory(buffer, vk::MemoryPropertyFlagBits::eDeviceLocal, DeviceMemoryTracker::getBufferCategory(usage)))
 {
 }
 
@@ -28,17 +31,20 @@ DeviceLocalBuffer& DeviceLocalBuffer::operator=(DeviceLocalBuffer&& other) noexc
 
 void DeviceLocalBuffer::uploadData(const void* sourceData, const vk::DeviceSize dataSize) const
 {
+    TRACE_SCOPE("Upload buffer");
+
     if (dataSize > size)
     {
         throw std::runtime_error("Data size is greater than buffer size.");
     }
 
     const vk::raii::Buffer stagingBuffer = createBuffer(dataSize, vk::BufferUsageFlagBits::eTransferSrc);
-    const vk::raii::DeviceMemory stagingBufferMemory = bindBufferMemory(stagingBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+    const DeviceMemoryTracker::Allocation stagingBufferMemory = bindBufferMemory(stagingBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                                                                                 DeviceMemoryTracker::Category::Staging);
 
-    void *data = stagingBufferMemory.mapMemory(0, dataSize);
+    void *data = stagingBufferMemory.getMemory().mapMemory(0, dataSize);
     std::memcpy(data, sourceData, dataSize);
-    stagingBufferMemory.unmapMemory();
+    stagingBufferMemory.getMemory().unmapMemory();
 
     const vk::raii::CommandBuffer commandBuffer = environment.get().beginSingleTimeCommands();
 
@@ -7,7 +7,7 @@
 
 class DeviceLocalBuffer : public AbstractBuffer {
 private:
-    vk::raii::DeviceMemory bufferMemory;
+    DeviceMemoryTracker::Allocation bufferMemory;
 
 public:
     DeviceLocalBuffer(const Environment& environment, const vk::DeviceSize size, const vk::BufferUsageFlags usage);
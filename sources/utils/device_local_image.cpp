@@ -2,19 +2,22 @@
 
 
 #include "host_visible_buffer.h"
+#include "image_barrier.h"
+#include "cpu_tracer.h"
 
 
 DeviceLocalImage::DeviceLocalImage(const Environment& environment, const vk::Extent2D extent, const vk::Format format,
-    const vk::ImageUsageFlags usage, const vk::ImageAspectFlags aspectFlags) :
+    const vk::ImageUsageFlags usage, const vk::ImageAspectFlags aspectFlags, const uint32_t layerCount) :
     environment(environment),
     extent(extent),
+    layerCount(layerCount),
     format(format),
     aspectFlags(aspectFlags),
-    size(extent.width * extent.height * 4),
+    size(extent.width * extent.height * 4 * layerCount),
     currentLayout(vk::ImageLayout::eUndefined),
     image(createImage(extent, format, usage)),
-    imageMemory(allocateImageMemory(vk::MemoryPropertyFlagBits::eDeviceLocal)),
-    imageView(createImageView(format))
+    imageMemory(allocateImageMemory(vk::MemoryPropertyFlagBits::eDeviceLocal, DeviceMemoryTracker::getImageCategory(usage))),
+    imageView(createImageView(format, layerCount > 1 ? vk::ImageViewType::e2DArray : vk::ImageViewType::e2D, 0, layerCount))
 {
 
 }
@@ -24,6 +27,7 @@ DeviceLocalImage::~DeviceLocalImage() = default;
 DeviceLocalImage::DeviceLocalImage(DeviceLocalImage&& other) noexcept :
     environment(other.environment),
     extent(other.extent),
+    layerCount(other.layerCount),
     size(other.size),
     format(other.format),
     aspectFlags(other.aspectFlags),
@@ -40,6 +44,7 @@ DeviceLocalImage& DeviceLocalImage::operator=(DeviceLocalImage&& other) noexcept
     {
         environment = other.environment;
         extent = other.extent;
+        layerCount = other.layerCount;
         format = other.format;
         aspectFlags = other.aspectFlags;
         size = other.size;
@@ -57,16 +62,35 @@ const vk::raii::Image& DeviceLocalImage::getImage() const
     return image;
 }
 
+vk::ImageLayout DeviceLocalImage::getLayout() const
+{
+    return currentLayout;
+}
+
+vk::DeviceSize DeviceLocalImage::getSize() const
+{
+    return size;
+}
+
+vk::raii::ImageView DeviceLocalImage::createLayerImageView(const uint32_t layer) const
+{
+    if (layer >= layerCount)
+    {
+        throw std::out_of_range("Image layer is out of range.");
+    }
+
+    return createImageView(format, vk::ImageViewType::e2D, layer, 1);
+}
+
 void DeviceLocalImage::uploadData(const void* sourceData, const vk::DeviceSize dataSize)
 {
+    TRACE_SCOPE("Upload image");
+
     if (dataSize > size)
     {
         throw std::runtime_error("Data size is greater than image size.");
     }
 
-    const vk::ImageLayout previousLayout = currentLayout;
-    transitionImageLayout(vk::ImageLayout::eTransferDstOptimal);
-
     const HostVisibleBuffer stagingBuffer(environment.get(), size, vk::BufferUsageFlagBits::eTransferSrc);
     stagingBuffer.uploadData(sourceData, dataSize);
 
@@ -84,81 +108,46 @@ void DeviceLocalImage::uploadData(const void* sourceData, const vk::DeviceSize d
         .imageExtent = vk::Extent3D{ extent.width, extent.height, 1 }
     };
 
+    const vk::ImageLayout previousLayout = currentLayout;
+
     const vk::raii::CommandBuffer commandBuffer = environment.get().beginSingleTimeCommands();
+    recordLayoutTransition(*commandBuffer, vk::ImageLayout::eTransferDstOptimal);
     commandBuffer.copyBufferToImage(*stagingBuffer.getBuffer(), *image, vk::ImageLayout::eTransferDstOptimal, region);
+    if (previousLayout != vk::ImageLayout::eUndefined)
+    {
+        recordLayoutTransition(*commandBuffer, previousLayout);
+    }
     environment.get().submitSingleTimeCommands(commandBuffer);
-
-    transitionImageLayout(previousLayout);
 }
 
 void DeviceLocalImage::transitionImageLayout(const vk::ImageLayout newLayout)
 {
-    if (newLayout == vk::ImageLayout::eUndefined or newLayout == vk::ImageLayout::ePreinitialized)
+    if (newLayout == currentLayout)
     {
         return;
     }
 
-    vk::AccessFlags srcAccessMask;
-    vk::AccessFlags dstAccessMask;
-    vk::PipelineStageFlags srcStageMask;
-    vk::PipelineStageFlags dstStageMask;
-    vk::ImageAspectFlags aspectMask;
+    const vk::raii::CommandBuffer commandBuffer = environment.get().beginSingleTimeCommands();
+    recordLayoutTransition(*commandBuffer, newLayout);
+    environment.get().submitSingleTimeCommands(commandBuffer);
+}
 
-    switch (currentLayout)
+void DeviceLocalImage::recordLayoutTransition(const vk::CommandBuffer& commandBuffer, const vk::ImageLayout newLayout)
+{
+    if (newLayout == vk::ImageLayout::eUndefined or newLayout == vk::ImageLayout::ePreinitialized)
     {
-        case vk::ImageLayout::eUndefined:
-            srcAccessMask = {};
-            srcStageMask = vk::PipelineStageFlagBits::eTopOfPipe;
-            break;
-        case vk::ImageLayout::eTransferDstOptimal:
-            srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-            srcStageMask = vk::PipelineStageFlagBits::eTransfer;
-            break;
-        default: throw std::invalid_argument("Unsupported layout transition.");
+        throw std::invalid_argument("Cannot transition an image to an undefined layout.");
     }
 
-    switch (newLayout)
-    {
-        case vk::ImageLayout::eTransferDstOptimal:
-            dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-            dstStageMask = vk::PipelineStageFlagBits::eTransfer;
-            aspectMask = vk::ImageAspectFlagBits::eColor;
-            break;
-        case vk::ImageLayout::eShaderReadOnlyOptimal:
-            dstAccessMask = vk::AccessFlagBits::eShaderRead;
-            dstStageMask = vk::PipelineStageFlagBits::eFragmentShader;
-            aspectMask = vk::ImageAspectFlagBits::eColor;
-            break;
-        case vk::ImageLayout::eDepthStencilAttachmentOptimal:
-            dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
-            dstStageMask = vk::PipelineStageFlagBits::eEarlyFragmentTests;
-            aspectMask = hasStencilComponent(format) ? vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil : vk::ImageAspectFlagBits::eDepth;
-            break;
-        default: throw std::invalid_argument("Unsupported layout transition.");
-    }
+    const vk::ImageMemoryBarrier2 barrier = ImageBarrier::create(*image, ImageBarrier::getAspectFlags(format), layerCount, currentLayout, newLayout);
 
-    const vk::ImageMemoryBarrier barrier{
-        .oldLayout = currentLayout,
-        .newLayout = newLayout,
-        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .image = *image,
-        .subresourceRange = vk::ImageSubresourceRange{
-            .aspectMask = aspectMask,
-            .baseMipLevel = 0,
-            .levelCount = 1,
-            .baseArrayLayer = 0,
-            .layerCount =  1
-        },
-        .srcAccessMask = srcAccessMask,
-        .dstAccessMask = dstAccessMask
+    const vk::DependencyInfo dependencyInfo{
+        .imageMemoryBarrierCount = 1,
+        .pImageMemoryBarriers = &barrier
     };
 
-    const vk::raii::CommandBuffer commandBuffer = environment.get().beginSingleTimeCommands();
-    commandBuffer.pipelineBarrier(srcStageMask, dstStageMask, {}, nullptr, nullptr, barrier);
-    environment.get().submitSingleTimeCommands(commandBuffer);
+    commandBuffer.pipelineBarrier2(dependencyInfo);
 
-    aspectFlags = aspectMask;
     currentLayout = newLayout;
 }
 
@@ -170,7 +159,7 @@ vk::raii::Image DeviceLocalImage::createImage(const vk::Extent2D extent, const v
         .format = format,
         .extent = vk::Extent3D{ extent.width, extent.height, 1 },
         .mipLevels = 1,
-        .arrayLayers = 1,
+        .arrayLayers = layerCount,
         .samples = vk::SampleCountFlagBits::e1,
         .tiling = vk::ImageTiling::eOptimal,
         .usage = usage | vk::ImageUsageFlagBits::eTransferDst,
@@ -183,26 +172,20 @@ vk::raii::Image DeviceLocalImage::createImage(const vk::Extent2D extent, const v
     return environment.get().device.createImage(createInfo);
 }
 
-vk::raii::DeviceMemory DeviceLocalImage::allocateImageMemory(const vk::MemoryPropertyFlags properties) const
+DeviceMemoryTracker::Allocation DeviceLocalImage::allocateImageMemory(const vk::MemoryPropertyFlags properties, const DeviceMemoryTracker::Category category) const
 {
-    const vk::MemoryRequirements memoryRequirements = image.getMemoryRequirements();
-
-    const vk::MemoryAllocateInfo allocateInfo{
-        .allocationSize = memoryRequirements.size,
-        .memoryTypeIndex = environment.get().findMemoryType(memoryRequirements.memoryTypeBits, properties)
-    };
-
-    vk::raii::DeviceMemory imageMemory = environment.get().device.allocateMemory(allocateInfo);
-    image.bindMemory(*imageMemory, 0);
+    DeviceMemoryTracker::Allocation imageMemory = environment.get().allocateMemory(image.getMemoryRequirements(), properties, category);
+    image.bindMemory(*imageMemory.getMemory(), 0);
 
     return imageMemory;
 }
 
-vk::raii::ImageView DeviceLocalImage::createImageView(const vk::Format format) const
+vk::raii::ImageView DeviceLocalImage::createImageView(const vk::Format format, const vk::ImageViewType viewType,
+    const uint32_t baseLayer, const uint32_t viewLayerCount) const
 {
     const vk::ImageViewCreateInfo createInfo{
         .image = *image,
-        .viewType = vk::ImageViewType::e2D,
+        .viewType = viewType,
         .format = format,
         .components = {
             .r = vk::ComponentSwizzle::eIdentity,
@@ -214,15 +197,10 @@ vk::raii::ImageView DeviceLocalImage::createImageView(const vk::Format format) c
             .aspectMask = aspectFlags,
             .baseMipLevel = 0,
             .levelCount = 1,
-            .baseArrayLayer = 0,
-            .layerCount = 1
+            .baseArrayLayer = baseLayer,
+            .layerCount = viewLayerCount
         }
     };
 
     return environment.get().device.createImageView(createInfo);
 }
-
-bool DeviceLocalImage::hasStencilComponent(const vk::Format format)
-{
-    return format == vk::Format::eD32SfloatS8Uint or format == vk::Format::eD24UnormS8Uint;
-}
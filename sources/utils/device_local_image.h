@@ -12,17 +12,18 @@ class DeviceLocalImage {
 private:
     std::reference_wrapper<const Environment> environment;
     vk::Extent2D extent;
+    uint32_t layerCount;
     vk::Format format;
     vk::ImageAspectFlags aspectFlags;
     vk::DeviceSize size;
     vk::ImageLayout currentLayout;
     vk::raii::Image image;
-    vk::raii::DeviceMemory imageMemory;
+    DeviceMemoryTracker::Allocation imageMemory;
 public:
     vk::raii::ImageView imageView;
 
 public:
-    DeviceLocalImage(const Environment& environment, const vk::Extent2D extent, const vk::Format format, const vk::ImageUsageFlags usage, const vk::ImageAspectFlags aspectFlags);
+    DeviceLocalImage(const Environment& environment, const vk::Extent2D extent, const vk::Format format, const vk::ImageUsageFlags usage, const vk::ImageAspectFlags aspectFlags, const uint32_t layerCount = 1);
     ~DeviceLocalImage();
 
     DeviceLocalImage(const DeviceLocalImage&) = delete;
@@ -32,15 +33,17 @@ public:
     DeviceLocalImage& operator=(DeviceLocalImage&& other) noexcept;
 
     const vk::raii::Image& getImage() const;
+    vk::raii::ImageView createLayerImageView(const uint32_t layer) const;
     void uploadData(const void* sourceData, const vk::DeviceSize dataSize);
+    vk::ImageLayout getLayout() const;
+    vk::DeviceSize getSize() const;
     void transitionImageLayout(const vk::ImageLayout newLayout);
+    void recordLayoutTransition(const vk::CommandBuffer& commandBuffer, const vk::ImageLayout newLayout);
 
 private:
     vk::raii::Image createImage(const vk::Extent2D extent, const vk::Format format, const vk::ImageUsageFlags usage) const;
-    vk::raii::DeviceMemory allocateImageMemory(const vk::MemoryPropertyFlags properties) const;
-    vk::raii::ImageView createImageView(const vk::Format format) const;
-
-    static bool hasStencilComponent(vk::Format format);
+    DeviceMemoryTracker::Allocation allocateImageMemory(const vk::MemoryPropertyFlags properties, const DeviceMemoryTracker::Category category) const;
+    vk::raii::ImageView createImageView(const vk::Format format, const vk::ImageViewType viewType, const uint32_t baseLayer, const uint32_t viewLayerCount) const;
 };
 
 
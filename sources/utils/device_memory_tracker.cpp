@@ -0,0 +1,312 @@
+#include "device_memory_tracker.h"
+
+
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+
+namespace
+{
+    constexpr double BytesPerMebibyte = 1024.0 * 1024.0;
+}
+
+
+DeviceMemoryTracker::Allocation::Allocation(vk::raii::DeviceMemory memory, DeviceMemoryTracker& tracker, const uint32_t heapIndex,
+    const Category category, const vk::DeviceSize size) :
+    memory(std::move(memory)),
+    tracker(&tracker),
+    heapIndex(heapIndex),
+    category(category),
+    size(size)
+{
+}
+
+DeviceMemoryTracker::Allocation::~Allocation()
+{
+    release();
+}
+
+DeviceMemoryTracker::Allocation::Allocation(Allocation&& other) noexcept :
+    memory(std::move(other.memory)),
+    tracker(std::exchange(other.tracker, nullptr)),
+    heapIndex(other.heapIndex),
+    category(other.category),
+    size(other.size)
+{
+}
+
+DeviceMemoryTracker::Allocation& DeviceMemoryTracker::Allocation::operator=(Allocation&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        memory = std::move(other.memory);
+        tracker = std::exchange(other.tracker, nullptr);
+        heapIndex = other.heapIndex;
+        category = other.category;
+        size = other.size;
+    }
+
+    return *this;
+}
+
+const vk::raii::DeviceMemory& DeviceMemoryTracker::Allocation::getMemory() const
+{
+    return memory;
+}
+
+void DeviceMemoryTracker::Allocation::release()
+{
+    if (tracker != nullptr)
+    {
+        tracker->release(heapIndex, category, size);
+        tracker = nullptr;
+    }
+}
+
+DeviceMemoryTracker::DeviceMemoryTracker(const vk::raii::PhysicalDevice& physicalDevice, const bool budgetExtensionEnabled) :
+    physicalDevice(physicalDevice),
+    memoryProperties(physicalDevice.getMemoryProperties()),
+    budgetExtensionEnabled(budgetExtensionEnabled),
+    mutex(),
+    heapUsages()
+{
+}
+
+DeviceMemoryTracker::~DeviceMemoryTracker() = default;
+
+DeviceMemoryTracker::Allocation DeviceMemoryTracker::allocate(const vk::raii::Device& device, const vk::MemoryRequirements& requirements,
+    const vk::MemoryPropertyFlags properties, const Category category)
+{
+    const uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+    const uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+
+    {
+        std::lock_guard lock(mutex);
+
+        const HeapBudget heapBudget = queryBudgets()[heapIndex];
+        const vk::DeviceSize projectedUsage = heapBudget.usage + requirements.size;
+        const BudgetState budgetState = projectedUsage > heapBudget.budget ? BudgetState::OverBudget :
+                                        projectedUsage > WarningBudgetFraction * heapBudget.budget ? BudgetState::NearBudget :
+                                        BudgetState::WithinBudget;
+
+        HeapUsage& heapUsage = heapUsages[heapIndex];
+        if (budgetState > heapUsage.budgetState)
+        {
+            std::ostringstream warning;
+            warning << std::fixed << std::setprecision(1)
+                    << "Warning: allocating " << requirements.size / BytesPerMebibyte << " MiB of " << getCategoryName(category) << " memory takes heap "
+                    << heapIndex << " to " << projectedUsage / BytesPerMebibyte << " MiB, " << (budgetState == BudgetState::OverBudget ? "past" : "near")
+                    << " its budget of " << heapBudget.budget / BytesPerMebibyte << " MiB.";
+            std::cerr << warning.str() << std::endl;
+        }
+        heapUsage.budgetState = budgetState;
+    }
+
+    const vk::MemoryAllocateInfo allocateInfo{
+        .allocationSize = requirements.size,
+        .memoryTypeIndex = memoryTypeIndex
+    };
+    vk::raii::DeviceMemory memory = device.allocateMemory(allocateInfo);
+
+    {
+        std::lock_guard lock(mutex);
+
+        HeapUsage& heapUsage = heapUsages[heapIndex];
+        heapUsage.categorySizes[static_cast<size_t>(category)] += requirements.size;
+        ++heapUsage.allocationCount;
+    }
+
+    return Allocation(std::move(memory), *this, heapIndex, category, requirements.size);
+}
+
+uint32_t DeviceMemoryTracker::findMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const
+{
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        if ((typeFilter & (1 << i)) and
+            (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("Failed to find suitable memory type.");
+}
+
+bool DeviceMemoryTracker::hasMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const
+{
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        if ((typeFilter & (1 << i)) and
+            (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+vk::MemoryPropertyFlags DeviceMemoryTracker::getMemoryTypeProperties(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const
+{
+    return memoryProperties.memoryTypes[findMemoryType(typeFilter, properties)].propertyFlags;
+}
+
+bool DeviceMemoryTracker::isBudgetExtensionEnabled() const
+{
+    return budgetExtensionEnabled;
+}
+
+std::vector<DeviceMemoryTracker::HeapReport> DeviceMemoryTracker::getReport() const
+{
+    std::lock_guard lock(mutex);
+
+    const std::array<HeapBudget, vk::MaxMemoryHeaps> budgets = queryBudgets();
+
+    std::vector<HeapReport> report;
+    report.reserve(memoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+    {
+        report.push_back({
+            .size = memoryProperties.memoryHeaps[i].size,
+            .budget = budgets[i].budget,
+            .usage = budgets[i].usage,
+            .trackedSize = getTrackedSize(heapUsages[i]),
+            .categorySizes = heapUsages[i].categorySizes,
+            .allocationCount = heapUsages[i].allocationCount,
+            .isDeviceLocal = static_cast<bool>(memoryProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+        });
+    }
+
+    return report;
+}
+
+void DeviceMemoryTracker::dump(std::ostream& stream) const
+{
+    const std::vector<HeapReport> heapReports = getReport();
+
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(1)
+           << "Device memory (MiB, " << (budgetExtensionEnabled ? "budgets from VK_EXT_memory_budget" : "budgets are heap sizes without VK_EXT_memory_budget") << "):\n";
+    for (size_t i = 0; i < heapReports.size(); ++i)
+    {
+        const HeapReport& heapReport = heapReports[i];
+        report << "  Heap " << i << (heapReport.isDeviceLocal ? " (device local)" : "") << ": " << heapReport.usage / BytesPerMebibyte << " of "
+               << heapReport.budget / BytesPerMebibyte << " budget in use";
+        if (heapReport.budget > 0)
+        {
+            report << " (" << 100.0 * heapReport.usage / heapReport.budget << "%)";
+        }
+        report << ", heap size " << heapReport.size / BytesPerMebibyte << "\n"
+               << "    tracked " << heapReport.trackedSize / BytesPerMebibyte << " in " << heapReport.allocationCount << " allocations:";
+        for (uint32_t category = 0; category < CategoryCount; ++category)
+        {
+            report << " " << getCategoryName(static_cast<Category>(category)) << " " << heapReport.categorySizes[category] / BytesPerMebibyte;
+        }
+        report << "\n";
+    }
+
+    stream << report.str() << std::flush;
+}
+
+DeviceMemoryTracker::Category DeviceMemoryTracker::getBufferCategory(const vk::BufferUsageFlags usage)
+{
+    if (usage & (vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer))
+    {
+        return Category::Mesh;
+    }
+    if (usage & vk::BufferUsageFlagBits::eUniformBuffer)
+    {
+        return Category::Uniform;
+    }
+    if (usage & (vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst))
+    {
+        return Category::Staging;
+    }
+
+    return Category::Other;
+}
+
+DeviceMemoryTracker::Category DeviceMemoryTracker::getImageCategory(const vk::ImageUsageFlags usage)
+{
+    if (usage & (vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment))
+    {
+        return Category::Attachment;
+    }
+    if (usage & vk::ImageUsageFlagBits::eSampled)
+    {
+        return Category::Texture;
+    }
+
+    return Category::Other;
+}
+
+const char* DeviceMemoryTracker::getCategoryName(const Category category)
+{
+    switch (category)
+    {
+    case Category::Mesh:
+        return "mesh";
+    case Category::Texture:
+        return "texture";
+    case Category::Attachment:
+        return "attachment";
+    case Category::Staging:
+        return "staging";
+    case Category::Uniform:
+        return "uniform";
+    case Category::Other:
+        return "other";
+    }
+
+    return "unknown";
+}
+
+void DeviceMemoryTracker::release(const uint32_t heapIndex, const Category category, const vk::DeviceSize size)
+{
+    std::lock_guard lock(mutex);
+
+    HeapUsage& heapUsage = heapUsages[heapIndex];
+    heapUsage.categorySizes[static_cast<size_t>(category)] -= size;
+    --heapUsage.allocationCount;
+}
+
+std::array<DeviceMemoryTracker::HeapBudget, vk::MaxMemoryHeaps> DeviceMemoryTracker::queryBudgets() const
+{
+    std::array<HeapBudget, vk::MaxMemoryHeaps> budgets{};
+
+    if (budgetExtensionEnabled)
+    {
+        const auto properties = physicalDevice.get().getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        const vk::PhysicalDeviceMemoryBudgetPropertiesEXT& budgetProperties = properties.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+        {
+            budgets[i] = {
+                .budget = budgetProperties.heapBudget[i],
+                .usage = budgetProperties.heapUsage[i]
+            };
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+        {
+            budgets[i] = {
+                .budget = memoryProperties.memoryHeaps[i].size,
+                .usage = getTrackedSize(heapUsages[i])
+            };
+        }
+    }
+
+    return budgets;
+}
+
+vk::DeviceSize DeviceMemoryTracker::getTrackedSize(const HeapUsage& heapUsage)
+{
+    return std::accumulate(heapUsage.categorySizes.begin(), heapUsage.categorySizes.end(), vk::DeviceSize{ 0 });
+}
@@ -0,0 +1,127 @@
+#ifndef DEVICE_MEMORY_TRACKER_H
+#define DEVICE_MEMORY_TRACKER_H
+
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <vulkan/vulkan_raii.hpp>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+
+// Counts every device memory allocation by heap and category. With VK_EXT_memory_budget the heaps are checked against
+// the budgets the driver reports, which also cover other processes; without it, against the heap sizes and the
+// tracked usage alone. An allocation that would take its heap near or past the budget warns before it is made, so a
+// later out-of-memory error has a trail. Allocations may be made from any thread.
+class DeviceMemoryTracker {
+public:
+    enum class Category
+    {
+        Mesh,
+        Texture,
+        Attachment,
+        Staging,
+        Uniform,
+        Other
+    };
+    static constexpr uint32_t CategoryCount = 6;
+    // Allocations taking a heap past this fraction of its budget warn once, until the heap drops below it again.
+    static constexpr double WarningBudgetFraction = 0.9;
+
+    struct HeapReport
+    {
+        vk::DeviceSize size;
+        vk::DeviceSize budget;
+        // Usage of the whole process as the driver sees it with VK_EXT_memory_budget, the tracked size otherwise.
+        vk::DeviceSize usage;
+        vk::DeviceSize trackedSize;
+        std::array<vk::DeviceSize, CategoryCount> categorySizes;
+        uint32_t allocationCount;
+        bool isDeviceLocal;
+    };
+
+    // Owns one device memory allocation and keeps it counted until it is freed.
+    class Allocation {
+    private:
+        vk::raii::DeviceMemory memory;
+        DeviceMemoryTracker* tracker;
+        uint32_t heapIndex;
+        Category category;
+        vk::DeviceSize size;
+
+    public:
+        Allocation(vk::raii::DeviceMemory memory, DeviceMemoryTracker& tracker, const uint32_t heapIndex, const Category category, const vk::DeviceSize size);
+        ~Allocation();
+
+        Allocation(const Allocation&) = delete;
+        Allocation& operator=(const Allocation&) = delete;
+
+        Allocation(Allocation&& other) noexcept;
+        Allocation& operator=(Allocation&& other) noexcept;
+
+        const vk::raii::DeviceMemory& getMemory() const;
+
+    private:
+        void release();
+    };
+
+private:
+    enum class BudgetState
+    {
+        WithinBudget,
+        NearBudget,
+        OverBudget
+    };
+    struct HeapUsage
+    {
+        std::array<vk::DeviceSize, CategoryCount> categorySizes;
+        uint32_t allocationCount;
+        BudgetState budgetState;
+    };
+    struct HeapBudget
+    {
+        vk::DeviceSize budget;
+        vk::DeviceSize usage;
+    };
+
+    std::reference_wrapper<const vk::raii::PhysicalDevice> physicalDevice;
+    const vk::PhysicalDeviceMemoryProperties memoryProperties;
+    const bool budgetExtensionEnabled;
+    mutable std::mutex mutex;
+    std::array<HeapUsage, vk::MaxMemoryHeaps> heapUsages;
+
+public:
+    // budgetExtensionEnabled tells whether the device was created with VK_EXT_memory_budget.
+    DeviceMemoryTracker(const vk::raii::PhysicalDevice& physicalDevice, const bool budgetExtensionEnabled);
+    ~DeviceMemoryTracker();
+
+    DeviceMemoryTracker(const DeviceMemoryTracker&) = delete;
+    DeviceMemoryTracker& operator=(const DeviceMemoryTracker&) = delete;
+
+    Allocation allocate(const vk::raii::Device& device, const vk::MemoryRequirements& requirements, const vk::MemoryPropertyFlags properties, const Category category);
+    uint32_t findMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const;
+    // Like findMemoryType, without throwing when no memory type matches.
+    bool hasMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const;
+    // All property flags of the memory type findMemoryType picks, which may have more than were asked for.
+    vk::MemoryPropertyFlags getMemoryTypeProperties(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const;
+    bool isBudgetExtensionEnabled() const;
+    std::vector<HeapReport> getReport() const;
+    void dump(std::ostream& stream) const;
+
+    static Category getBufferCategory(const vk::BufferUsageFlags usage);
+    static Category getImageCategory(const vk::ImageUsageFlags usage);
+    static const char* getCategoryName(const Category category);
+
+private:
+    void release(const uint32_t heapIndex, const Category category, const vk::DeviceSize size);
+    // Must be called with the mutex held.
+    std::array<HeapBudget, vk::MaxMemoryHeaps> queryBudgets() const;
+    static vk::DeviceSize getTrackedSize(const HeapUsage& heapUsage);
+};
+
+
+#endif //DEVICE_MEMORY_TRACKER_H
@@ -1,30 +1,40 @@
 #include "environment.h"
 
 
+#include "cpu_tracer.h"
+
+#include <algorithm>
 #include <iostream>
 #include <set>
+#include <string_view>
+#include <utility>
 
 
-Environment::Environment(const Window& window, const char* applicationName, const uint32_t applicationVersion, const uint32_t maxFramesInFlight) :
+Environment::Environment(const Window* window, const vk::Extent2D headlessExtent, const uint32_t physicalDeviceIndex, const char* applicationName, const uint32_t applicationVersion, const uint32_t maxFramesInFlight) :
     window(window),
     context(),
+    validationEnabled(enabledDebug and hasValidationLayers()),
     instance(createInstance(applicationName, applicationVersion)),
     debugMessenger(createDebugMessenger()),
-    surface(window.createSurface(instance)),
-    physicalDevice(selectPhysicalDevice()),
+    surface(createSurface()),
+    physicalDevice(selectPhysicalDevice(physicalDeviceIndex)),
     queueFamilyIndices(findQueueFamilies(physicalDevice)),
     physicalDeviceProperties(physicalDevice.getProperties()),
     device(createDevice()),
     graphicsQueue(device.getQueue(queueFamilyIndices.graphicsFamily.value(), 0)),
-    presentQueue(device.getQueue(queueFamilyIndices.presentFamily.value(), 0)),
+    presentQueue(queueFamilyIndices.presentFamily.has_value() ? device.getQueue(queueFamilyIndices.presentFamily.value(), 0) : vk::raii::Queue(nullptr)),
     graphicsCommandPool(createCommandPool(queueFamilyIndices.graphicsFamily.value())),
     descriptorPool(createDescriptorPool(maxFramesInFlight)),
-    swapchainSurfaceFormat(chooseSwapchainSurfaceFormat(querySwapchainSupport(physicalDevice).formats)),
-    swapchainExtent(chooseSwapchainExtent(querySwapchainSupport(physicalDevice).capabilities)),
-    swapchain(createSwapchain()),
-    swapchainImages(swapchain.getImages()),
+    memoryTracker(physicalDevice, isDeviceExtensionEnabled(vk::EXTMemoryBudgetExtensionName)),
+    swapchainMaintenanceEnabled(isDeviceExtensionEnabled(vk::EXTSwapchainMaintenance1ExtensionName)),
+    swapchainSurfaceFormat(isHeadless() ? HeadlessSurfaceFormat : chooseSwapchainSurfaceFormat(querySwapchainSupport(physicalDevice).formats)),
+    swapchainExtent(isHeadless() ? headlessExtent : chooseSwapchainExtent(querySwapchainSupport(physicalDevice).capabilities)),
+    swapchain(createSwapchain(nullptr)),
+    swapchainImages(isHeadless() ? std::vector<vk::Image>() : swapchain.getImages()),
     swapchainImageViews(createSwapchainImageViews()),
-    depthFormat(findSupportedFormat({ vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint }, vk::ImageTiling::eOptimal, vk::FormatFeatureFlagBits::eDepthStencilAttachment))
+    singleTimeSubmitCount(0),
+    depthFormat(findSupportedFormat({ vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint }, vk::ImageTiling::eOptimal, vk::FormatFeatureFlagBits::eDepthStencilAttachment)),
+    shadowDepthFormat(findSupportedFormat({ vk::Format::eD32Sfloat, vk::Format::eD16Unorm }, vk::ImageTiling::eOptimal, vk::FormatFeatureFlagBits::eDepthStencilAttachment | vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eSampledImageFilterLinear))
 {
 }
 
@@ -70,6 +80,20 @@ vk::raii::Semaphore Environment::createSemaphore(const vk::SemaphoreCreateFlags
     return device.createSemaphore(createInfo);
 }
 
+vk::raii::Semaphore Environment::createTimelineSemaphore(const uint64_t initialValue) const
+{
+    const vk::SemaphoreTypeCreateInfo typeCreateInfo{
+        .semaphoreType = vk::SemaphoreType::eTimeline,
+        .initialValue = initialValue
+    };
+
+    const vk::SemaphoreCreateInfo createInfo{
+        .pNext = &typeCreateInfo
+    };
+
+    return device.createSemaphore(createInfo);
+}
+
 vk::raii::Fence Environment::createFence(const vk::FenceCreateFlags flags) const
 {
     const vk::FenceCreateInfo createInfo{
@@ -79,6 +103,37 @@ vk::raii::Fence Environment::createFence(const vk::FenceCreateFlags flags) const
     return device.createFence(createInfo);
 }
 
+bool Environment::isHeadless() const
+{
+    return window == nullptr;
+}
+
+bool Environment::isPipelineStatisticsQueryEnabled() const
+{
+    return physicalDevice.getFeatures().pipelineStatisticsQuery;
+}
+
+bool Environment::isSwapchainTransferDstSupported() const
+{
+    return !isHeadless() and
+           static_cast<bool>(querySwapchainSupport(physicalDevice).capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferDst);
+}
+
+bool Environment::isSwapchainMaintenanceEnabled() const
+{
+    return swapchainMaintenanceEnabled;
+}
+
+vk::FormatFeatureFlags Environment::getOptimalTilingFeatures(const vk::Format format) const
+{
+    return physicalDevice.getFormatProperties(format).optimalTilingFeatures;
+}
+
+uint32_t Environment::getSuitablePhysicalDeviceCount() const
+{
+    return getSuitablePhysicalDevices().size();
+}
+
 vk::Viewport Environment::getViewport() const
 {
     return {
@@ -109,25 +164,25 @@ const vk::raii::SwapchainKHR& Environment::getSwapchain() const
     return swapchain;
 }
 
+const std::vector<vk::Image>& Environment::getSwapchainImages() const
+{
+    return swapchainImages;
+}
+
 const std::vector<vk::raii::ImageView>& Environment::getSwapchainImageViews() const
 {
     return swapchainImageViews;
 }
 
-uint32_t Environment::findMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const
+DeviceMemoryTracker::Allocation Environment::allocateMemory(const vk::MemoryRequirements& requirements, const vk::MemoryPropertyFlags properties,
+    const DeviceMemoryTracker::Category category) const
 {
-    const vk::PhysicalDeviceMemoryProperties memoryProperties = physicalDevice.getMemoryProperties();
-
-    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
-    {
-        if ((typeFilter & (1 << i)) and
-            (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
-        {
-            return i;
-        }
-    }
+    return memoryTracker.allocate(device, requirements, properties, category);
+}
 
-    throw std::runtime_error("Failed to find suitable memory type.");
+const DeviceMemoryTracker& Environment::getMemoryTracker() const
+{
+    return memoryTracker;
 }
 
 vk::raii::CommandBuffer Environment::beginSingleTimeCommands() const
@@ -159,27 +214,46 @@ void Environment::submitSingleTimeCommands(const vk::raii::CommandBuffer& comman
 
     graphicsQueue.submit(submitInfo, nullptr);
     graphicsQueue.waitIdle();
+    singleTimeSubmitCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Environment::getSingleTimeSubmitCount() const
+{
+    return singleTimeSubmitCount.load(std::memory_order_relaxed);
 }
 
 
-void Environment::recreateSwapchain()
+Environment::RetiredSwapchain Environment::recreateSwapchain()
 {
-    swapchainImageViews.clear();
-    swapchainImages.clear();
-    swapchain.clear();
+    TRACE_SCOPE("Recreate swapchain");
+
+    if (isHeadless())
+    {
+        throw std::logic_error("A headless environment has no swapchain to recreate.");
+    }
 
     swapchainExtent = chooseSwapchainExtent(querySwapchainSupport(physicalDevice).capabilities);
 
-    swapchain = createSwapchain();
+    // Handing the old swapchain over lets presentation move to the new one while frames using the old images are still in flight.
+    RetiredSwapchain retiredSwapchain{
+        .swapchain = createSwapchain(*swapchain),
+        .imageViews = std::move(swapchainImageViews)
+    };
+    std::swap(swapchain, retiredSwapchain.swapchain);
+
     swapchainImages = swapchain.getImages();
     swapchainImageViews = createSwapchainImageViews();
+
+    return retiredSwapchain;
 }
 
 vk::raii::Instance Environment::createInstance(const char* applicationName, const uint32_t applicationVersion) const
 {
+    TRACE_SCOPE("Create instance");
+
     void* pNext = nullptr;
     vk::DebugUtilsMessengerCreateInfoEXT debugUtilsMessengerCreateInfo = getDebugUtilsMessengerCreateInfo();
-    if constexpr (enabledDebug)
+    if (validationEnabled)
     {
         pNext = &debugUtilsMessengerCreateInfo;
     }
@@ -193,7 +267,7 @@ vk::raii::Instance Environment::createInstance(const char* applicationName, cons
     };
 
     std::vector<const char*> enabledLayerNames;
-    if constexpr (enabledDebug)
+    if (validationEnabled)
     {
         for (const char* layer : validationLayers)
         {
@@ -201,11 +275,15 @@ vk::raii::Instance Environment::createInstance(const char* applicationName, cons
         }
     }
 
-    std::vector<const char*> enabledExtensions = getRequiredExtensionNames();
+    const std::vector<const char*> enabledExtensions = getInstanceExtensionNames();
+    const bool portabilityEnumerationEnabled = std::ranges::any_of(enabledExtensions, [](const char* extensionName)
+    {
+        return std::string_view(extensionName) == vk::KHRPortabilityEnumerationExtensionName;
+    });
 
     const vk::InstanceCreateInfo createInfo{
         .pNext = pNext,
-        .flags = vk::InstanceCreateFlagBits::eEnumeratePortabilityKHR,
+        .flags = portabilityEnumerationEnabled ? vk::InstanceCreateFlagBits::eEnumeratePortabilityKHR : vk::InstanceCreateFlags(),
         .pApplicationInfo = &applicationInfo,
         .enabledLayerCount = static_cast<uint32_t>(enabledLayerNames.size()),
         .ppEnabledLayerNames = enabledLayerNames.data(),
@@ -218,7 +296,7 @@ vk::raii::Instance Environment::createInstance(const char* applicationName, cons
 
 vk::raii::DebugUtilsMessengerEXT Environment::createDebugMessenger() const
 {
-    if constexpr (!enabledDebug)
+    if (!validationEnabled)
     {
         return nullptr;
     }
@@ -226,21 +304,50 @@ vk::raii::DebugUtilsMessengerEXT Environment::createDebugMessenger() const
     return instance.createDebugUtilsMessengerEXT(getDebugUtilsMessengerCreateInfo());
 }
 
-vk::raii::PhysicalDevice Environment::selectPhysicalDevice() const
+vk::raii::SurfaceKHR Environment::createSurface() const
+{
+    if (isHeadless())
+    {
+        return nullptr;
+    }
+
+    return window->createSurface(instance);
+}
+
+std::vector<vk::raii::PhysicalDevice> Environment::getSuitablePhysicalDevices() const
 {
-    for (const vk::raii::PhysicalDevice& physicalDevice : instance.enumeratePhysicalDevices())
+    std::vector<vk::raii::PhysicalDevice> suitablePhysicalDevices;
+    for (vk::raii::PhysicalDevice& physicalDevice : instance.enumeratePhysicalDevices())
     {
         if (isPhysicalDeviceSuitable(physicalDevice))
         {
-            return physicalDevice;
+            suitablePhysicalDevices.push_back(std::move(physicalDevice));
         }
     }
 
-    throw std::runtime_error("No suitable physical device found");
+    return suitablePhysicalDevices;
+}
+
+vk::raii::PhysicalDevice Environment::selectPhysicalDevice(const uint32_t physicalDeviceIndex) const
+{
+    std::vector<vk::raii::PhysicalDevice> suitablePhysicalDevices = getSuitablePhysicalDevices();
+    if (suitablePhysicalDevices.empty())
+    {
+        throw std::runtime_error("No suitable physical device found");
+    }
+    if (physicalDeviceIndex >= suitablePhysicalDevices.size())
+    {
+        throw std::invalid_argument("Physical device index " + std::to_string(physicalDeviceIndex) + " is out of range, only "
+                                    + std::to_string(suitablePhysicalDevices.size()) + " suitable physical devices were found");
+    }
+
+    return std::move(suitablePhysicalDevices[physicalDeviceIndex]);
 }
 
 vk::raii::Device Environment::createDevice() const
 {
+    TRACE_SCOPE("Create device");
+
     constexpr float queuePriority = 1.0f;
 
     std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
@@ -254,7 +361,7 @@ vk::raii::Device Environment::createDevice() const
     }
 
     std::vector<const char*> enabledLayerNames;
-    if constexpr (enabledDebug)
+    if (validationEnabled)
     {
         for (const char* layer : validationLayers)
         {
@@ -262,15 +369,43 @@ vk::raii::Device Environment::createDevice() const
         }
     }
 
-    constexpr vk::PhysicalDeviceFeatures enabledFeatures{
-        .samplerAnisotropy = vk::True
+    const vk::PhysicalDeviceFeatures enabledFeatures{
+        .samplerAnisotropy = vk::True,
+        .pipelineStatisticsQuery = physicalDevice.getFeatures().pipelineStatisticsQuery
+    };
+
+    vk::PhysicalDeviceVulkan11Features enabledVulkan11Features{
+        .multiview = vk::True
+    };
+
+    vk::PhysicalDeviceVulkan12Features enabledVulkan12Features{
+        .pNext = &enabledVulkan11Features,
+        .timelineSemaphore = vk::True
+    };
+
+    vk::PhysicalDeviceVulkan13Features enabledVulkan13Features{
+        .pNext = &enabledVulkan12Features,
+        .synchronization2 = vk::True,
+        .dynamicRendering = vk::True
+    };
+
+    vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT enabledSwapchainMaintenanceFeatures{
+        .pNext = &enabledVulkan13Features,
+        .swapchainMaintenance1 = vk::True
     };
 
+    const std::vector<const char*> enabledExtensions = getDeviceExtensionNames(physicalDevice);
+    const bool swapchainMaintenanceEnabled = std::ranges::any_of(enabledExtensions, [](const char* extensionName)
+    {
+        return std::string_view(extensionName) == vk::EXTSwapchainMaintenance1ExtensionName;
+    });
+
     const vk::DeviceCreateInfo createInfo{
+        .pNext = swapchainMaintenanceEnabled ? static_cast<void*>(&enabledSwapchainMaintenanceFeatures) : &enabledVulkan13Features,
         .queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
         .pQueueCreateInfos = queueCreateInfos.data(),
-        .enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size()),
-        .ppEnabledExtensionNames = deviceExtensions.data(),
+        .enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size()),
+        .ppEnabledExtensionNames = enabledExtensions.data(),
         .enabledLayerCount = static_cast<uint32_t>(enabledLayerNames.size()),
         .ppEnabledLayerNames = enabledLayerNames.data(),
         .pEnabledFeatures = &enabledFeatures
@@ -312,8 +447,15 @@ vk::raii::DescriptorPool Environment::createDescriptorPool(const uint32_t count)
     return device.createDescriptorPool(createInfo);
 }
 
-vk::raii::SwapchainKHR Environment::createSwapchain() const
+vk::raii::SwapchainKHR Environment::createSwapchain(const vk::SwapchainKHR oldSwapchain) const
 {
+    TRACE_SCOPE("Create swapchain");
+
+    if (isHeadless())
+    {
+        return nullptr;
+    }
+
     const SwapchainDetails swapchainDetails = querySwapchainSupport(physicalDevice);
     const vk::PresentModeKHR presentMode = chooseSwapchainPresentMode(swapchainDetails.presentModes);
 
@@ -332,7 +474,7 @@ vk::raii::SwapchainKHR Environment::createSwapchain() const
         .imageColorSpace = swapchainSurfaceFormat.colorSpace,
         .imageExtent = swapchainExtent,
         .imageArrayLayers = 1,
-        .imageUsage = vk::ImageUsageFlagBits::eColorAttachment,
+        .imageUsage = vk::ImageUsageFlagBits::eColorAttachment | (swapchainDetails.capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferDst),
         .imageSharingMode = uniqueQueueFamilyIndices.size() > 1 ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive,
         .queueFamilyIndexCount = static_cast<uint32_t>(uniqueQueueFamilyIndices.size()),
         .pQueueFamilyIndices = uniqueQueueFamilyIndices.data(),
@@ -340,7 +482,7 @@ vk::raii::SwapchainKHR Environment::createSwapchain() const
         .compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque,
         .presentMode = presentMode,
         .clipped = vk::True,
-        .oldSwapchain = nullptr
+        .oldSwapchain = oldSwapchain
     };
 
     return device.createSwapchainKHR(createInfo);
@@ -376,27 +518,116 @@ std::vector<vk::raii::ImageView> Environment::createSwapchainImageViews() const
     return swapchainImageViews;
 }
 
-std::vector<const char*> Environment::getRequiredExtensionNames()
+bool Environment::hasValidationLayers() const
+{
+    const std::vector<vk::LayerProperties> availableLayers = context.enumerateInstanceLayerProperties();
+
+    const bool available = std::ranges::all_of(validationLayers, [&availableLayers](const char* layerName)
+    {
+        return std::ranges::any_of(availableLayers, [layerName](const vk::LayerProperties& layer)
+        {
+            return std::string_view(layer.layerName) == layerName;
+        });
+    });
+    if (!available)
+    {
+        std::cerr << "Validation layers requested but not available, continuing without them." << std::endl;
+    }
+
+    return available;
+}
+
+bool Environment::isInstanceExtensionAvailable(const char* extensionName) const
+{
+    return std::ranges::any_of(context.enumerateInstanceExtensionProperties(), [extensionName](const vk::ExtensionProperties& extension)
+    {
+        return std::string_view(extension.extensionName) == extensionName;
+    });
+}
+
+bool Environment::isSurfaceMaintenanceAvailable() const
+{
+    return !isHeadless() and
+            isInstanceExtensionAvailable(vk::KHRGetSurfaceCapabilities2ExtensionName) and
+            isInstanceExtensionAvailable(vk::EXTSurfaceMaintenance1ExtensionName);
+}
+
+std::vector<const char*> Environment::getInstanceExtensionNames() const
 {
     std::vector<const char*> extensionNames;
 
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-    for (uint32_t i = 0; i < glfwExtensionCount; ++i)
+    if (!isHeadless())
     {
-        extensionNames.emplace_back(glfwExtensions[i]);
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        for (uint32_t i = 0; i < glfwExtensionCount; ++i)
+        {
+            extensionNames.emplace_back(glfwExtensions[i]);
+        }
+
+        if (isSurfaceMaintenanceAvailable())
+        {
+            extensionNames.emplace_back(vk::KHRGetSurfaceCapabilities2ExtensionName);
+            extensionNames.emplace_back(vk::EXTSurfaceMaintenance1ExtensionName);
+        }
     }
 
-    if constexpr (enabledDebug)
+    if (validationEnabled)
     {
         extensionNames.emplace_back(vk::EXTDebugUtilsExtensionName);
     }
 
-    extensionNames.emplace_back(vk::KHRPortabilityEnumerationExtensionName);
+    if (isInstanceExtensionAvailable(vk::KHRPortabilityEnumerationExtensionName))
+    {
+        extensionNames.emplace_back(vk::KHRPortabilityEnumerationExtensionName);
+    }
+
+    return extensionNames;
+}
+
+std::vector<const char*> Environment::getDeviceExtensionNames(const vk::raii::PhysicalDevice& physicalDevice) const
+{
+    std::vector<const char*> extensionNames;
+
+    const std::vector<vk::ExtensionProperties> availableExtensions = physicalDevice.enumerateDeviceExtensionProperties();
+    const auto isAvailable = [&availableExtensions](const char* extensionName)
+    {
+        return std::ranges::any_of(availableExtensions, [extensionName](const vk::ExtensionProperties& extension)
+        {
+            return std::string_view(extension.extensionName) == extensionName;
+        });
+    };
+
+    if (!isHeadless())
+    {
+        extensionNames.assign(deviceExtensions.begin(), deviceExtensions.end());
+
+        if (isSurfaceMaintenanceAvailable() and isAvailable(vk::EXTSwapchainMaintenance1ExtensionName) and
+            physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT>().get<vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT>().swapchainMaintenance1)
+        {
+            extensionNames.emplace_back(vk::EXTSwapchainMaintenance1ExtensionName);
+        }
+    }
+
+    for (const char* optionalExtension : optionalDeviceExtensions)
+    {
+        if (isAvailable(optionalExtension))
+        {
+            extensionNames.emplace_back(optionalExtension);
+        }
+    }
 
     return extensionNames;
 }
 
+bool Environment::isDeviceExtensionEnabled(const char* extensionName) const
+{
+    return std::ranges::any_of(getDeviceExtensionNames(physicalDevice), [extensionName](const char* enabledExtension)
+    {
+        return std::string_view(enabledExtension) == extensionName;
+    });
+}
+
 vk::DebugUtilsMessengerCreateInfoEXT Environment::getDebugUtilsMessengerCreateInfo()
 {
     return vk::DebugUtilsMessengerCreateInfoEXT{
@@ -414,18 +645,29 @@ vk::DebugUtilsMessengerCreateInfoEXT Environment::getDebugUtilsMessengerCreateIn
 bool Environment::isPhysicalDeviceSuitable(const vk::raii::PhysicalDevice& physicalDevice) const
 {
     const QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
-    const SwapchainDetails swapchainDetails = querySwapchainSupport(physicalDevice);
     const bool extensionsSupported = checkDeviceExtensionSupport(physicalDevice);
-    const vk::PhysicalDeviceFeatures supportedFeatures = physicalDevice.getFeatures();
+    const auto supportedFeatures = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan11Features, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features>();
+    const vk::PhysicalDeviceVulkan11Features& supportedVulkan11Features = supportedFeatures.get<vk::PhysicalDeviceVulkan11Features>();
+    const vk::PhysicalDeviceVulkan12Features& supportedVulkan12Features = supportedFeatures.get<vk::PhysicalDeviceVulkan12Features>();
+    const vk::PhysicalDeviceVulkan13Features& supportedVulkan13Features = supportedFeatures.get<vk::PhysicalDeviceVulkan13Features>();
 
-    return indices.isComplete() and
-            swapchainDetails.isComplete() and
+    return indices.isComplete(!isHeadless()) and
             extensionsSupported and
-            supportedFeatures.samplerAnisotropy;
+            (isHeadless() or querySwapchainSupport(physicalDevice).isComplete()) and
+            supportedFeatures.get<vk::PhysicalDeviceFeatures2>().features.samplerAnisotropy and
+            supportedVulkan11Features.multiview and
+            supportedVulkan12Features.timelineSemaphore and
+            supportedVulkan13Features.synchronization2 and
+            supportedVulkan13Features.dynamicRendering;
 }
 
-bool Environment::checkDeviceExtensionSupport(const vk::raii::PhysicalDevice& physicalDevice)
+bool Environment::checkDeviceExtensionSupport(const vk::raii::PhysicalDevice& physicalDevice) const
 {
+    if (isHeadless())
+    {
+        return true;
+    }
+
     const std::vector<vk::ExtensionProperties> availableExtensions = physicalDevice.enumerateDeviceExtensionProperties();
 
     std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
@@ -450,7 +692,7 @@ Environment::QueueFamilyIndices Environment::findQueueFamilies(const vk::raii::P
             graphicsFamilyIndices.push_back(i);
         }
 
-        if (physicalDevice.getSurfaceSupportKHR(i, *surface))
+        if (!isHeadless() and physicalDevice.getSurfaceSupportKHR(i, *surface))
         {
             presentFamilyIndices.push_back(i);
         }
@@ -519,7 +761,7 @@ vk::Extent2D Environment::chooseSwapchainExtent(const vk::SurfaceCapabilitiesKHR
         return capabilities.currentExtent;
     }
 
-    const auto [width, height] = window.getFramebufferSize();
+    const auto [width, height] = window->getFramebufferSize();
 
     return {
         .width = std::clamp(static_cast<uint32_t>(width), capabilities.minImageExtent.width, capabilities.maxImageExtent.width),
@@ -8,7 +8,10 @@
 #define VULKAN_HPP_NO_CONSTRUCTORS
 #include <vulkan/vulkan_raii.hpp>
 
+#include <atomic>
+
 #include "window.h"
+#include "device_memory_tracker.h"
 
 
 class Environment {
@@ -17,10 +20,10 @@ private:
         const std::optional<uint32_t> graphicsFamily;
         const std::optional<uint32_t> presentFamily;
 
-        bool isComplete() const
+        bool isComplete(const bool requiresPresent) const
         {
             return graphicsFamily.has_value() and
-                    presentFamily.has_value();
+                    (!requiresPresent or presentFamily.has_value());
         }
 
         std::vector<uint32_t> getUniqueIndices() const
@@ -50,9 +53,18 @@ private:
         }
     };
 
+public:
+    // A swapchain replaced by recreateSwapchain, which must outlive the frames that rendered to or presented its images.
+    struct RetiredSwapchain
+    {
+        vk::raii::SwapchainKHR swapchain;
+        std::vector<vk::raii::ImageView> imageViews;
+    };
+
 private:
-    const Window& window;
+    const Window* const window;
     const vk::raii::Context context;
+    const bool validationEnabled;
     const vk::raii::Instance instance;
     const std::optional<vk::raii::DebugUtilsMessengerEXT> debugMessenger;
     const vk::raii::SurfaceKHR surface;
@@ -66,6 +78,8 @@ public:
 private:
     const vk::raii::CommandPool graphicsCommandPool;
     const vk::raii::DescriptorPool descriptorPool;
+    mutable DeviceMemoryTracker memoryTracker;
+    const bool swapchainMaintenanceEnabled;
 public:
     const vk::SurfaceFormatKHR swapchainSurfaceFormat;
 private:
@@ -73,28 +87,49 @@ private:
     vk::raii::SwapchainKHR swapchain;
     std::vector<vk::Image> swapchainImages;
     std::vector<vk::raii::ImageView> swapchainImageViews;
+    mutable std::atomic<uint64_t> singleTimeSubmitCount;
 public:
     const vk::Format depthFormat;
+    const vk::Format shadowDepthFormat;
 
 public:
-    Environment(const Window& window, const char* applicationName, const uint32_t applicationVersion, const uint32_t maxFramesInFlight);
+    // Without a window there is no surface, swapchain or present queue and the render extent is headlessExtent.
+    // physicalDeviceIndex selects among the suitable physical devices and must be below getSuitablePhysicalDeviceCount.
+    Environment(const Window* window, const vk::Extent2D headlessExtent, const uint32_t physicalDeviceIndex, const char* applicationName, const uint32_t applicationVersion, const uint32_t maxFramesInFlight);
     ~Environment();
 
     std::vector<vk::raii::CommandBuffer> createGraphicsCommandBuffers(const uint32_t count, const vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary) const;
     std::vector<vk::raii::DescriptorSet> createDescriptorSets(const uint32_t count, const vk::raii::DescriptorSetLayout& descriptorSetLayout) const;
     vk::raii::Semaphore createSemaphore(const vk::SemaphoreCreateFlags flags = {}) const;
+    vk::raii::Semaphore createTimelineSemaphore(const uint64_t initialValue = 0) const;
     vk::raii::Fence createFence(const vk::FenceCreateFlags flags = {}) const;
 
+    bool isHeadless() const;
+    // Pipeline statistics queries are enabled whenever the device supports them.
+    bool isPipelineStatisticsQueryEnabled() const;
+    // Swapchain images are also transfer destinations where the surface allows it, so they can be blitted to.
+    bool isSwapchainTransferDstSupported() const;
+    // VK_EXT_swapchain_maintenance1 is enabled where available, so presents can signal a fence once the presentation
+    // engine is done with them.
+    bool isSwapchainMaintenanceEnabled() const;
+    vk::FormatFeatureFlags getOptimalTilingFeatures(const vk::Format format) const;
+    uint32_t getSuitablePhysicalDeviceCount() const;
     vk::Viewport getViewport() const;
     vk::Rect2D getScissor() const;
     vk::Extent2D getSwapchainExtent() const;
     const vk::raii::SwapchainKHR& getSwapchain() const;
+    const std::vector<vk::Image>& getSwapchainImages() const;
     const std::vector<vk::raii::ImageView>& getSwapchainImageViews() const;
 
-    uint32_t findMemoryType(const uint32_t typeFilter, const vk::MemoryPropertyFlags properties) const;
+    // Allocates memory of a type allowed by requirements with properties, counted under category in the memory tracker.
+    DeviceMemoryTracker::Allocation allocateMemory(const vk::MemoryRequirements& requirements, const vk::MemoryPropertyFlags properties, const DeviceMemoryTracker::Category category) const;
+    const DeviceMemoryTracker& getMemoryTracker() const;
     vk::raii::CommandBuffer beginSingleTimeCommands() const;
     void submitSingleTimeCommands(const vk::raii::CommandBuffer& commandBuffer) const;
-    void recreateSwapchain();
+    // Number of blocking single-time submissions so far, so callers can attribute stalls to uploads.
+    uint64_t getSingleTimeSubmitCount() const;
+    // Creates the new swapchain from the current one without waiting for the device, and hands the old one back.
+    RetiredSwapchain recreateSwapchain();
 
 private:
     static constexpr auto EngineName = "No Engine";
@@ -107,21 +142,36 @@ private:
     static constexpr std::array<const char*, 1> validationLayers = {
         "VK_LAYER_KHRONOS_validation"
     };
-    static constexpr std::array<const char*, 2> deviceExtensions = {
-        "VK_KHR_portability_subset",
+    static constexpr std::array<const char*, 1> deviceExtensions = {
         vk::KHRSwapchainExtensionName
     };
+    static constexpr std::array<const char*, 2> optionalDeviceExtensions = {
+        "VK_KHR_portability_subset",
+        vk::EXTMemoryBudgetExtensionName
+    };
+    static constexpr vk::SurfaceFormatKHR HeadlessSurfaceFormat = {
+        .format = vk::Format::eR8G8B8A8Srgb,
+        .colorSpace = vk::ColorSpaceKHR::eSrgbNonlinear
+    };
 
     vk::raii::Instance createInstance(const char* applicationName, const uint32_t applicationVersion) const;
     vk::raii::DebugUtilsMessengerEXT createDebugMessenger() const;
-    vk::raii::PhysicalDevice selectPhysicalDevice() const;
+    vk::raii::SurfaceKHR createSurface() const;
+    std::vector<vk::raii::PhysicalDevice> getSuitablePhysicalDevices() const;
+    vk::raii::PhysicalDevice selectPhysicalDevice(const uint32_t physicalDeviceIndex) const;
     vk::raii::Device createDevice() const;
     vk::raii::CommandPool createCommandPool(const uint32_t queueFamilyIndex) const;
     vk::raii::DescriptorPool createDescriptorPool(const uint32_t count) const;
-    vk::raii::SwapchainKHR createSwapchain() const;
+    vk::raii::SwapchainKHR createSwapchain(const vk::SwapchainKHR oldSwapchain) const;
     std::vector<vk::raii::ImageView> createSwapchainImageViews() const;
 
-    static std::vector<const char*> getRequiredExtensionNames();
+    bool hasValidationLayers() const;
+    bool isInstanceExtensionAvailable(const char* extensionName) const;
+    // The instance side of VK_EXT_swapchain_maintenance1.
+    bool isSurfaceMaintenanceAvailable() const;
+    std::vector<const char*> getInstanceExtensionNames() const;
+    std::vector<const char*> getDeviceExtensionNames(const vk::raii::PhysicalDevice& physicalDevice) const;
+    bool isDeviceExtensionEnabled(const char* extensionName) const;
     static vk::DebugUtilsMessengerCreateInfoEXT getDebugUtilsMessengerCreateInfo();
     static VKAPI_ATTR vk::Bool32 VKAPI_CALL debugCallback(
         VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -129,7 +179,7 @@ private:
         const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
         void* pUserData);
     bool isPhysicalDeviceSuitable(const vk::raii::PhysicalDevice& physicalDevice) const;
-    static bool checkDeviceExtensionSupport(const vk::raii::PhysicalDevice& physicalDevice);
+    bool checkDeviceExtensionSupport(const vk::raii::PhysicalDevice& physicalDevice) const;
     QueueFamilyIndices findQueueFamilies(const vk::raii::PhysicalDevice& physicalDevice) const;
     SwapchainDetails querySwapchainSupport(const vk::raii::PhysicalDevice& physicalDevice) const;
     static vk::SurfaceFormatKHR chooseSwapchainSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& availableFormats);
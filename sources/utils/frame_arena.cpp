@@ -0,0 +1,25 @@
+#include "frame_arena.h"
+
+
+FrameArena::FrameArena(const size_t capacity) :
+    block(capacity),
+    resource(block.data(), block.size(), std::pmr::null_memory_resource())
+{
+}
+
+FrameArena::~FrameArena() = default;
+
+void FrameArena::reset()
+{
+    resource.release();
+}
+
+std::pmr::memory_resource& FrameArena::getResource()
+{
+    return resource;
+}
+
+size_t FrameArena::getCapacity() const
+{
+    return block.size();
+}
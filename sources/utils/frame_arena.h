@@ -0,0 +1,31 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+
+// Bump allocator for scratch data that lives for one frame. All memory comes from a block reserved up front and is
+// reclaimed at once by reset; exhausting it throws std::bad_alloc instead of falling back to the heap.
+class FrameArena {
+private:
+    std::vector<std::byte> block;
+    std::pmr::monotonic_buffer_resource resource;
+
+public:
+    explicit FrameArena(const size_t capacity);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Everything allocated from the arena must be destroyed before it is reset.
+    void reset();
+    std::pmr::memory_resource& getResource();
+    size_t getCapacity() const;
+};
+
+
+#endif //FRAME_ARENA_H
@@ -0,0 +1,94 @@
+#include "frame_queue.h"
+
+
+#include <stdexcept>
+
+
+FrameQueue::FrameQueue(const uint32_t frameCount, const uint32_t workerCount)
+{
+    if (workerCount == 0)
+    {
+        throw std::invalid_argument("Frame queue needs at least one worker.");
+    }
+
+    ranges.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        auto range = std::make_unique<Range>();
+        range->begin = static_cast<uint64_t>(frameCount) * i / workerCount;
+        range->end = static_cast<uint64_t>(frameCount) * (i + 1) / workerCount;
+        ranges.push_back(std::move(range));
+    }
+}
+
+FrameQueue::~FrameQueue() = default;
+
+std::optional<uint32_t> FrameQueue::pop(const uint32_t worker)
+{
+    Range& range = *ranges.at(worker);
+
+    do
+    {
+        std::lock_guard lock(range.mutex);
+        if (range.begin < range.end)
+        {
+            return range.begin++;
+        }
+    }
+    while (steal(worker));
+
+    return std::nullopt;
+}
+
+uint32_t FrameQueue::getWorkerCount() const
+{
+    return ranges.size();
+}
+
+bool FrameQueue::steal(const uint32_t worker)
+{
+    while (true)
+    {
+        Range* victim = nullptr;
+        uint32_t victimSize = 0;
+        for (uint32_t i = 0; i < ranges.size(); ++i)
+        {
+            if (i == worker)
+            {
+                continue;
+            }
+
+            std::lock_guard lock(ranges[i]->mutex);
+            if (ranges[i]->end - ranges[i]->begin > victimSize)
+            {
+                victim = ranges[i].get();
+                victimSize = ranges[i]->end - ranges[i]->begin;
+            }
+        }
+
+        if (victim == nullptr)
+        {
+            return false;
+        }
+
+        uint32_t stolenBegin, stolenEnd;
+        {
+            std::lock_guard lock(victim->mutex);
+            if (victim->begin == victim->end)
+            {
+                continue;
+            }
+
+            stolenEnd = victim->end;
+            stolenBegin = victim->end - (victim->end - victim->begin + 1) / 2;
+            victim->end = stolenBegin;
+        }
+
+        Range& range = *ranges[worker];
+        std::lock_guard lock(range.mutex);
+        range.begin = stolenBegin;
+        range.end = stolenEnd;
+
+        return true;
+    }
+}
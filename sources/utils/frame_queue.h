@@ -0,0 +1,39 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+
+// Hands out frame numbers to workers. Each worker starts with a contiguous slice and steals
+// the back half of the largest remaining slice once its own runs dry.
+class FrameQueue {
+private:
+    struct Range
+    {
+        std::mutex mutex;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    std::vector<std::unique_ptr<Range>> ranges;
+
+public:
+    FrameQueue(const uint32_t frameCount, const uint32_t workerCount);
+    ~FrameQueue();
+
+    FrameQueue(const FrameQueue&) = delete;
+    FrameQueue& operator=(const FrameQueue&) = delete;
+
+    std::optional<uint32_t> pop(const uint32_t worker);
+    uint32_t getWorkerCount() const;
+
+private:
+    bool steal(const uint32_t worker);
+};
+
+
+#endif //FRAME_QUEUE_H
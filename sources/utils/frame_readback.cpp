@@ -0,0 +1,253 @@
+#include "frame_readback.h"
+
+
+#include "cpu_tracer.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+
+FrameReadback::FrameReadback(const Environment& environment, const vk::Extent2D extent, const uint32_t layerCount, const vk::Format format, Settings settings) :
+    environment(environment),
+    settings(std::move(settings)),
+    extent(extent),
+    layerCount(layerCount),
+    timelineSemaphore(environment.createTimelineSemaphore()),
+    nextTimelineValue(1),
+    slots(createSlots(environment, 4ull * extent.width * extent.height * layerCount, this->settings.slotCount)),
+    writtenFrameCount(0),
+    threadPool(this->settings.threadCount)
+{
+    if (format != vk::Format::eR8G8B8A8Srgb and format != vk::Format::eR8G8B8A8Unorm)
+    {
+        throw std::invalid_argument("Frame readback expects an RGBA8 color target.");
+    }
+
+    std::filesystem::create_directories(this->settings.outputDirectory);
+}
+
+FrameReadback::~FrameReadback() = default;
+
+uint32_t FrameReadback::acquireSlot(const uint32_t frameNumber)
+{
+    poll();
+
+    while (true)
+    {
+        for (uint32_t i = 0; i < slots.size(); ++i)
+        {
+            if (slots[i].state == SlotState::Free)
+            {
+                slots[i].state = SlotState::Copying;
+                slots[i].frameNumber = frameNumber;
+                slots[i].timelineValue = nextTimelineValue++;
+                return i;
+            }
+        }
+
+        Slot& oldestSlot = *std::ranges::min_element(slots, {}, &Slot::timelineValue);
+        if (oldestSlot.state == SlotState::Copying)
+        {
+            const vk::SemaphoreWaitInfo waitInfo{
+                .semaphoreCount = 1,
+                .pSemaphores = &*timelineSemaphore,
+                .pValues = &oldestSlot.timelineValue
+            };
+
+            if (environment.get().device.waitSemaphores(waitInfo, std::numeric_limits<uint64_t>::max()) != vk::Result::eSuccess)
+            {
+                throw std::runtime_error("Failed to wait for frame readback.");
+            }
+            startEncoding(oldestSlot);
+        }
+        finishEncoding(oldestSlot);
+    }
+}
+
+void FrameReadback::recordCopy(const vk::CommandBuffer& commandBuffer, const vk::Image image, const uint32_t slot) const
+{
+    const vk::BufferImageCopy region{
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = {
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = layerCount
+        },
+        .imageOffset = { 0, 0, 0 },
+        .imageExtent = { extent.width, extent.height, 1 }
+    };
+
+    commandBuffer.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, *slots[slot].buffer.getBuffer(), region);
+
+    const vk::MemoryBarrier2 hostReadBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eHost,
+        .dstAccessMask = vk::AccessFlagBits2::eHostRead
+    };
+
+    const vk::DependencyInfo dependencyInfo{
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &hostReadBarrier
+    };
+
+    commandBuffer.pipelineBarrier2(dependencyInfo);
+}
+
+vk::SemaphoreSubmitInfo FrameReadback::getSignalSemaphoreInfo(const uint32_t slot) const
+{
+    return {
+        .semaphore = *timelineSemaphore,
+        .value = slots[slot].timelineValue,
+        .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+        .deviceIndex = 0
+    };
+}
+
+void FrameReadback::poll()
+{
+    const uint64_t completedValue = timelineSemaphore.getCounterValue();
+
+    for (Slot& slot : slots)
+    {
+        if (slot.state == SlotState::Copying and slot.timelineValue <= completedValue)
+        {
+            startEncoding(slot);
+        }
+        else if (slot.state == SlotState::Encoding and slot.encodeResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            finishEncoding(slot);
+        }
+    }
+}
+
+void FrameReadback::flush()
+{
+    const uint64_t lastTimelineValue = nextTimelineValue - 1;
+    const vk::SemaphoreWaitInfo waitInfo{
+        .semaphoreCount = 1,
+        .pSemaphores = &*timelineSemaphore,
+        .pValues = &lastTimelineValue
+    };
+
+    if (environment.get().device.waitSemaphores(waitInfo, std::numeric_limits<uint64_t>::max()) != vk::Result::eSuccess)
+    {
+        throw std::runtime_error("Failed to wait for frame readback.");
+    }
+
+    for (Slot& slot : slots)
+    {
+        if (slot.state == SlotState::Copying)
+        {
+            startEncoding(slot);
+        }
+    }
+    for (Slot& slot : slots)
+    {
+        if (slot.state == SlotState::Encoding)
+        {
+            finishEncoding(slot);
+        }
+    }
+}
+
+uint64_t FrameReadback::getWrittenFrameCount() const
+{
+    return writtenFrameCount;
+}
+
+void FrameReadback::startEncoding(Slot& slot)
+{
+    std::vector<std::string> paths;
+    for (uint32_t i = 0; i < layerCount; ++i)
+    {
+        paths.push_back(getOutputPath(slot.frameNumber, i));
+    }
+
+    slot.buffer.invalidate();
+    slot.state = SlotState::Encoding;
+    slot.encodeResult = threadPool.submit([paths = std::move(paths), encoding = settings.encoding, extent = extent, pixels = static_cast<const std::byte*>(slot.buffer.getMappedMemory())]
+    {
+        const size_t layerSize = 4ull * extent.width * extent.height;
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            encode(paths[i], encoding, extent, pixels + i * layerSize);
+        }
+    });
+}
+
+void FrameReadback::finishEncoding(Slot& slot)
+{
+    slot.state = SlotState::Free;
+    slot.encodeResult.get();
+    ++writtenFrameCount;
+}
+
+std::string FrameReadback::getOutputPath(const uint32_t frameNumber, const uint32_t layer) const
+{
+    std::ostringstream path;
+    path << settings.outputDirectory << "/frame_" << std::setw(6) << std::setfill('0') << frameNumber;
+    if (layerCount > 1)
+    {
+        path << "_view" << layer;
+    }
+    path << (settings.encoding == Encoding::Png ? ".png" : ".raw");
+
+    return path.str();
+}
+
+std::vector<FrameReadback::Slot> FrameReadback::createSlots(const Environment& environment, const vk::DeviceSize slotSize, const uint32_t count)
+{
+    if (count == 0)
+    {
+        throw std::invalid_argument("Frame readback needs at least one slot.");
+    }
+
+    std::vector<Slot> slots;
+    slots.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        slots.push_back({
+            .buffer = HostVisibleBuffer(environment, slotSize, vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eHostCached),
+            .state = SlotState::Free,
+            .frameNumber = 0,
+            .timelineValue = 0,
+            .encodeResult = {}
+        });
+    }
+
+    return slots;
+}
+
+void FrameReadback::encode(const std::string& path, const Encoding encoding, const vk::Extent2D extent, const void* pixels)
+{
+    TRACE_SCOPE("Encode frame");
+
+    const int width = static_cast<int>(extent.width);
+    const int height = static_cast<int>(extent.height);
+
+    if (encoding == Encoding::Png)
+    {
+        if (stbi_write_png(path.c_str(), width, height, 4, pixels, 4 * width) == 0)
+        {
+            throw std::runtime_error("Failed to write " + path);
+        }
+        return;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(static_cast<const char*>(pixels), static_cast<std::streamsize>(4) * width * height);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef FRAME_READBACK_H
+#define FRAME_READBACK_H
+
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <vulkan/vulkan_raii.hpp>
+
+#include <future>
+#include <string>
+
+#include "environment.h"
+#include "host_visible_buffer.h"
+#include "thread_pool.h"
+
+
+class FrameReadback {
+public:
+    enum class Encoding
+    {
+        Png,
+        Raw
+    };
+    struct Settings
+    {
+        std::string outputDirectory;
+        Encoding encoding;
+        uint32_t slotCount;
+        uint32_t threadCount;
+    };
+
+private:
+    enum class SlotState
+    {
+        Free,
+        Copying,
+        Encoding
+    };
+    struct Slot
+    {
+        HostVisibleBuffer buffer;
+        SlotState state;
+        uint32_t frameNumber;
+        uint64_t timelineValue;
+        std::future<void> encodeResult;
+    };
+
+    std::reference_wrapper<const Environment> environment;
+    Settings settings;
+    vk::Extent2D extent;
+    uint32_t layerCount;
+    vk::raii::Semaphore timelineSemaphore;
+    uint64_t nextTimelineValue;
+    std::vector<Slot> slots;
+    uint64_t writtenFrameCount;
+    ThreadPool threadPool;
+
+public:
+    // Each layer of the color target is written as its own file.
+    FrameReadback(const Environment& environment, const vk::Extent2D extent, const uint32_t layerCount, const vk::Format format, Settings settings);
+    ~FrameReadback();
+
+    FrameReadback(const FrameReadback&) = delete;
+    FrameReadback& operator=(const FrameReadback&) = delete;
+
+    // Returns a slot for the frame, blocking only when every slot is still copying or encoding.
+    uint32_t acquireSlot(const uint32_t frameNumber);
+    // The image must be in eTransferSrcOptimal.
+    void recordCopy(const vk::CommandBuffer& commandBuffer, const vk::Image image, const uint32_t slot) const;
+    // Signals the slot's copy completion; add it to the submit that contains recordCopy.
+    vk::SemaphoreSubmitInfo getSignalSemaphoreInfo(const uint32_t slot) const;
+    void poll();
+    void flush();
+
+    uint64_t getWrittenFrameCount() const;
+
+private:
+    void startEncoding(Slot& slot);
+    void finishEncoding(Slot& slot);
+    std::string getOutputPath(const uint32_t frameNumber, const uint32_t layer) const;
+
+    static std::vector<Slot> createSlots(const Environment& environment, const vk::DeviceSize slotSize, const uint32_t count);
+    static void encode(const std::string& path, const Encoding encoding, const vk::Extent2D extent, const void* pixels);
+};
+
+
+#endif //FRAME_READBACK_H
@@ -0,0 +1,85 @@
+#include "frame_script.h"
+
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+
+FrameScript::FrameScript(std::vector<Frame> frames) :
+    frames(std::move(frames))
+{
+    if (this->frames.empty())
+    {
+        throw std::invalid_argument("Frame script contains no frames.");
+    }
+
+    for (const Frame& frame : this->frames)
+    {
+        if (frame.views.empty() or frame.views.size() != this->frames.front().views.size())
+        {
+            throw std::invalid_argument("Every frame in a frame script needs the same, non-zero number of views.");
+        }
+    }
+}
+
+FrameScript::~FrameScript() = default;
+
+const std::vector<FrameScript::Frame>& FrameScript::getFrames() const
+{
+    return frames;
+}
+
+uint32_t FrameScript::getViewCount() const
+{
+    return frames.front().views.size();
+}
+
+FrameScript FrameScript::load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open frame script: " + path);
+    }
+
+    std::vector<Frame> frames;
+
+    std::string line;
+    for (uint32_t lineNumber = 1; std::getline(file, line); ++lineNumber)
+    {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos or line[first] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream stream(line);
+        std::vector<float> values;
+        for (float value; stream >> value;)
+        {
+            values.push_back(value);
+        }
+
+        if (!stream.eof() or values.size() < 7 or (values.size() - 1) % 6 != 0)
+        {
+            throw std::runtime_error("Malformed frame at " + path + ":" + std::to_string(lineNumber));
+        }
+
+        Frame frame{
+            .time = values[0],
+            .views = {}
+        };
+        for (size_t i = 1; i < values.size(); i += 6)
+        {
+            frame.views.push_back({
+                .eye = glm::vec3(values[i], values[i + 1], values[i + 2]),
+                .target = glm::vec3(values[i + 3], values[i + 4], values[i + 5])
+            });
+        }
+
+        frames.push_back(std::move(frame));
+    }
+
+    return FrameScript(std::move(frames));
+}
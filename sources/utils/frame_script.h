@@ -0,0 +1,40 @@
+#ifndef FRAME_SCRIPT_H
+#define FRAME_SCRIPT_H
+
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+
+class FrameScript {
+public:
+    struct View
+    {
+        glm::vec3 eye;
+        glm::vec3 target;
+    };
+    struct Frame
+    {
+        float time;
+        std::vector<View> views;
+    };
+
+private:
+    std::vector<Frame> frames;
+
+public:
+    explicit FrameScript(std::vector<Frame> frames);
+    ~FrameScript();
+
+    const std::vector<Frame>& getFrames() const;
+    uint32_t getViewCount() const;
+
+    // One frame per line: "time eyeX eyeY eyeZ targetX targetY targetZ", optionally followed by further eye/target groups
+    // for multiview rendering. Every frame must have the same number of views. Blank lines and lines starting with '#' are skipped.
+    static FrameScript load(const std::string& path);
+};
+
+
+#endif //FRAME_SCRIPT_H
@@ -0,0 +1,130 @@
+#include "frame_telemetry.h"
+
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+
+FrameTelemetry::FrameTelemetry(const float hitchThreshold) :
+    hitchThreshold(hitchThreshold),
+    cpuFrameTimes(),
+    gpuFrameTimes(),
+    presentIntervals(),
+    inputLatencies(),
+    lastPresentTime(std::nullopt),
+    pendingCauses(),
+    hitchCounts()
+{
+}
+
+void FrameTelemetry::noteHitchCause(const HitchCause cause)
+{
+    pendingCauses[static_cast<uint32_t>(cause)] = true;
+}
+
+void FrameTelemetry::recordCpuFrameTime(const float milliseconds)
+{
+    cpuFrameTimes.record(milliseconds);
+
+    if (milliseconds > hitchThreshold)
+    {
+        if (std::ranges::none_of(pendingCauses, [](const bool pending) { return pending; }))
+        {
+            pendingCauses[static_cast<uint32_t>(HitchCause::Unattributed)] = true;
+        }
+
+        for (uint32_t i = 0; i < HitchCauseCount; ++i)
+        {
+            hitchCounts[i] += pendingCauses[i] ? 1 : 0;
+        }
+    }
+
+    pendingCauses.fill(false);
+}
+
+void FrameTelemetry::recordGpuFrameTime(const float milliseconds)
+{
+    gpuFrameTimes.record(milliseconds);
+}
+
+void FrameTelemetry::recordPresent(const std::chrono::steady_clock::time_point presentTime)
+{
+    if (lastPresentTime.has_value())
+    {
+        presentIntervals.record(std::chrono::duration<float, std::milli>(presentTime - lastPresentTime.value()).count());
+    }
+    lastPresentTime = presentTime;
+}
+
+void FrameTelemetry::recordInputLatency(const float milliseconds)
+{
+    inputLatencies.record(milliseconds);
+}
+
+void FrameTelemetry::setHitchThreshold(const float milliseconds)
+{
+    hitchThreshold = milliseconds;
+}
+
+float FrameTelemetry::getHitchThreshold() const
+{
+    return hitchThreshold;
+}
+
+const FrameTimeHistogram& FrameTelemetry::getCpuFrameTimes() const
+{
+    return cpuFrameTimes;
+}
+
+const FrameTimeHistogram& FrameTelemetry::getGpuFrameTimes() const
+{
+    return gpuFrameTimes;
+}
+
+const FrameTimeHistogram& FrameTelemetry::getPresentIntervals() const
+{
+    return presentIntervals;
+}
+
+const FrameTimeHistogram& FrameTelemetry::getInputLatencies() const
+{
+    return inputLatencies;
+}
+
+uint64_t FrameTelemetry::getHitchCount(const HitchCause cause) const
+{
+    return hitchCounts[static_cast<uint32_t>(cause)];
+}
+
+void FrameTelemetry::dump(std::ostream& stream) const
+{
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(3) << "Frame telemetry (ms):\n";
+
+    const auto writeHistogram = [&report](const char* name, const FrameTimeHistogram& histogram)
+    {
+        report << "  " << name << ": ";
+        if (histogram.getCount() == 0)
+        {
+            report << "no samples\n";
+            return;
+        }
+
+        report << histogram.getCount() << " samples, mean " << histogram.getMean()
+               << ", p50 " << histogram.getPercentile(50.0) << ", p95 " << histogram.getPercentile(95.0)
+               << ", p99 " << histogram.getPercentile(99.0) << ", max " << histogram.getMax() << "\n";
+    };
+    writeHistogram("CPU frame time", cpuFrameTimes);
+    writeHistogram("GPU frame time", gpuFrameTimes);
+    writeHistogram("Present interval", presentIntervals);
+    writeHistogram("Input latency", inputLatencies);
+
+    report << "  Hitches over " << hitchThreshold << " ms:";
+    for (uint32_t i = 0; i < HitchCauseCount; ++i)
+    {
+        report << " " << HitchCauseNames[i] << " " << hitchCounts[i] << (i + 1 < HitchCauseCount ? "," : "\n");
+    }
+
+    stream << report.str() << std::flush;
+}
@@ -0,0 +1,67 @@
+#ifndef FRAME_TELEMETRY_H
+#define FRAME_TELEMETRY_H
+
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <ostream>
+
+#include "frame_time_histogram.h"
+
+
+// Always-on frame timing: histograms of CPU frame time, GPU frame time, present-to-present intervals and input
+// latency, plus a count of hitches over a threshold, each attributed to the causes noted during that frame.
+class FrameTelemetry {
+public:
+    enum class HitchCause
+    {
+        Resize,
+        Upload,
+        RenderGraphCompile,
+        Unattributed
+    };
+
+    static constexpr uint32_t HitchCauseCount = 4;
+    static constexpr float DefaultHitchThreshold = 1000.0f / 30.0f;
+
+private:
+    static constexpr std::array<const char*, HitchCauseCount> HitchCauseNames = {
+        "resize",
+        "upload",
+        "render graph compile",
+        "unattributed"
+    };
+
+    float hitchThreshold;
+    FrameTimeHistogram cpuFrameTimes;
+    FrameTimeHistogram gpuFrameTimes;
+    FrameTimeHistogram presentIntervals;
+    FrameTimeHistogram inputLatencies;
+    std::optional<std::chrono::steady_clock::time_point> lastPresentTime;
+    std::array<bool, HitchCauseCount> pendingCauses;
+    std::array<uint64_t, HitchCauseCount> hitchCounts;
+
+public:
+    explicit FrameTelemetry(const float hitchThreshold = DefaultHitchThreshold);
+
+    void noteHitchCause(const HitchCause cause);
+    // Ends the current frame: a hitch is counted once per cause noted since the previous frame.
+    void recordCpuFrameTime(const float milliseconds);
+    void recordGpuFrameTime(const float milliseconds);
+    void recordPresent(const std::chrono::steady_clock::time_point presentTime);
+    // Time from handling an input event to presenting the first frame simulated from it.
+    void recordInputLatency(const float milliseconds);
+    void setHitchThreshold(const float milliseconds);
+
+    float getHitchThreshold() const;
+    const FrameTimeHistogram& getCpuFrameTimes() const;
+    const FrameTimeHistogram& getGpuFrameTimes() const;
+    const FrameTimeHistogram& getPresentIntervals() const;
+    const FrameTimeHistogram& getInputLatencies() const;
+    uint64_t getHitchCount(const HitchCause cause) const;
+    void dump(std::ostream& stream) const;
+};
+
+
+#endif //FRAME_TELEMETRY_H
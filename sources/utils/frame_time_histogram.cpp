@@ -0,0 +1,98 @@
+#include "frame_time_histogram.h"
+
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+
+FrameTimeHistogram::FrameTimeHistogram() :
+    counts(),
+    count(0),
+    maxValue(0),
+    sum(0.0)
+{
+}
+
+void FrameTimeHistogram::record(const float milliseconds)
+{
+    const auto value = std::min(static_cast<uint64_t>(std::max(0.0f, milliseconds) * 1000.0f + 0.5f), MaxValue);
+
+    ++counts[getBucketIndex(value)];
+    ++count;
+    maxValue = std::max(maxValue, value);
+    sum += static_cast<double>(value);
+}
+
+void FrameTimeHistogram::reset()
+{
+    counts.fill(0);
+    count = 0;
+    maxValue = 0;
+    sum = 0.0;
+}
+
+uint64_t FrameTimeHistogram::getCount() const
+{
+    return count;
+}
+
+float FrameTimeHistogram::getPercentile(const double percentile) const
+{
+    if (count == 0)
+    {
+        return 0.0f;
+    }
+
+    const auto targetCount = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(count))));
+
+    uint64_t cumulativeCount = 0;
+    for (uint32_t i = 0; i < BucketCount; ++i)
+    {
+        cumulativeCount += counts[i];
+        if (cumulativeCount >= targetCount)
+        {
+            return static_cast<float>(std::min(getHighestEquivalentValue(i), maxValue)) / 1000.0f;
+        }
+    }
+
+    return getMax();
+}
+
+float FrameTimeHistogram::getMean() const
+{
+    return count > 0 ? static_cast<float>(sum / static_cast<double>(count) / 1000.0) : 0.0f;
+}
+
+float FrameTimeHistogram::getMax() const
+{
+    return static_cast<float>(maxValue) / 1000.0f;
+}
+
+uint32_t FrameTimeHistogram::getBucketIndex(const uint64_t value)
+{
+    if (value < SubBucketCount)
+    {
+        return static_cast<uint32_t>(value);
+    }
+
+    // Keep the top log2(SubBucketCount) bits, so the sub-bucket lies in [SubBucketCount / 2, SubBucketCount).
+    const uint32_t shift = static_cast<uint32_t>(std::bit_width(value) - std::bit_width(SubBucketCount)) + 1;
+    const auto subBucket = static_cast<uint32_t>(value >> shift);
+
+    return SubBucketCount + (shift - 1) * SubBucketCount / 2 + subBucket - SubBucketCount / 2;
+}
+
+uint64_t FrameTimeHistogram::getHighestEquivalentValue(const uint32_t bucketIndex)
+{
+    if (bucketIndex < SubBucketCount)
+    {
+        return bucketIndex;
+    }
+
+    const uint32_t offset = bucketIndex - SubBucketCount;
+    const uint32_t shift = offset / (SubBucketCount / 2) + 1;
+    const uint64_t subBucket = offset % (SubBucketCount / 2) + SubBucketCount / 2;
+
+    return ((subBucket + 1) << shift) - 1;
+}
@@ -0,0 +1,43 @@
+#ifndef FRAME_TIME_HISTOGRAM_H
+#define FRAME_TIME_HISTOGRAM_H
+
+
+#include <array>
+#include <cstdint>
+
+
+// Fixed-size log-linear histogram of durations in the style of HdrHistogram. Values are kept in microseconds;
+// each power of two above SubBucketCount is split into SubBucketCount / 2 linear buckets, which bounds the
+// relative error of every reported percentile by 1/64 without allocating.
+class FrameTimeHistogram {
+public:
+    static constexpr uint32_t SubBucketCount = 128;
+    static constexpr uint32_t MaxShift = 30;
+    static constexpr uint32_t BucketCount = SubBucketCount + MaxShift * SubBucketCount / 2;
+    static constexpr uint64_t MaxValue = (uint64_t{ SubBucketCount } << MaxShift) - 1;
+
+private:
+    std::array<uint64_t, BucketCount> counts;
+    uint64_t count;
+    uint64_t maxValue;
+    double sum;
+
+public:
+    FrameTimeHistogram();
+
+    void record(const float milliseconds);
+    void reset();
+
+    uint64_t getCount() const;
+    // percentile is in [0, 100]; returns milliseconds, or 0 without samples.
+    float getPercentile(const double percentile) const;
+    float getMean() const;
+    float getMax() const;
+
+private:
+    static uint32_t getBucketIndex(const uint64_t value);
+    static uint64_t getHighestEquivalentValue(const uint32_t bucketIndex);
+};
+
+
+#endif //FRAME_TIME_HISTOGRAM_H
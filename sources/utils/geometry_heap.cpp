@@ -0,0 +1,508 @@
+#include "geometry_heap.h"
+
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+
+GeometryHeap::Allocation::Allocation(GeometryHeap& heap, const Handle handle, const vk::DeviceSize size) :
+    heap(&heap),
+    handle(handle),
+    size(size)
+{
+}
+
+GeometryHeap::Allocation::~Allocation()
+{
+    release();
+}
+
+GeometryHeap::Allocation::Allocation(Allocation&& other) noexcept :
+    heap(std::exchange(other.heap, nullptr)),
+    handle(other.handle),
+    size(other.size)
+{
+}
+
+GeometryHeap::Allocation& GeometryHeap::Allocation::operator=(Allocation&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        heap = std::exchange(other.heap, nullptr);
+        handle = other.handle;
+        size = other.size;
+    }
+
+    return *this;
+}
+
+GeometryHeap::Handle GeometryHeap::Allocation::getHandle() const
+{
+    return handle;
+}
+
+vk::DeviceSize GeometryHeap::Allocation::getSize() const
+{
+    return size;
+}
+
+void GeometryHeap::Allocation::release()
+{
+    if (heap != nullptr)
+    {
+        heap->release(handle);
+        heap = nullptr;
+    }
+}
+
+GeometryHeap::RangeAllocator::RangeAllocator(const uint32_t capacity) :
+    freeRanges({ { 0, capacity } }),
+    usedCount(0)
+{
+}
+
+std::optional<uint32_t> GeometryHeap::RangeAllocator::allocate(const uint32_t count)
+{
+    const auto range = std::ranges::find_if(freeRanges, [count](const std::pair<const uint32_t, uint32_t>& freeRange) { return freeRange.second >= count; });
+    if (range == freeRanges.end())
+    {
+        return std::nullopt;
+    }
+
+    const auto [offset, freeCount] = *range;
+    freeRanges.erase(range);
+    if (freeCount > count)
+    {
+        freeRanges.emplace(offset + count, freeCount - count);
+    }
+    usedCount += count;
+
+    return offset;
+}
+
+void GeometryHeap::RangeAllocator::free(const uint32_t offset, const uint32_t count)
+{
+    uint32_t start = offset;
+    uint32_t length = count;
+
+    const auto next = freeRanges.lower_bound(offset);
+    if (next != freeRanges.begin())
+    {
+        if (const auto previous = std::prev(next); previous->first + previous->second == offset)
+        {
+            start = previous->first;
+            length += previous->second;
+            freeRanges.erase(previous);
+        }
+    }
+    if (next != freeRanges.end() and offset + count == next->first)
+    {
+        length += next->second;
+        freeRanges.erase(next);
+    }
+
+    freeRanges.emplace(start, length);
+    usedCount -= count;
+}
+
+uint32_t GeometryHeap::RangeAllocator::getUsedCount() const
+{
+    return usedCount;
+}
+
+GeometryHeap::GeometryHeap(const Environment& environment) :
+    environment(environment),
+    mutex(),
+    blocks(),
+    entries(),
+    freeHandles(),
+    retiredRanges(),
+    inFlightMoveCount(0),
+    moveCount(0),
+    freedBlockCount(0)
+{
+}
+
+GeometryHeap::~GeometryHeap() = default;
+
+GeometryHeap::Allocation GeometryHeap::allocate(const uint32_t vertexCount, const uint32_t indexCount)
+{
+    if (vertexCount == 0 or indexCount == 0)
+    {
+        throw std::invalid_argument("Geometry must have vertices and indices.");
+    }
+
+    std::lock_guard lock(mutex);
+
+    std::optional<Placement> placement;
+    for (uint32_t i = 0; i < blocks.size() and !placement.has_value(); ++i)
+    {
+        if (blocks[i].has_value())
+        {
+            placement = allocateInBlock(i, vertexCount, indexCount);
+        }
+    }
+    if (!placement.has_value())
+    {
+        const uint32_t block = addBlock(std::max(BlockVertexCount, vertexCount), std::max(BlockIndexCount, indexCount));
+        placement = allocateInBlock(block, vertexCount, indexCount);
+    }
+
+    Handle handle;
+    if (freeHandles.empty())
+    {
+        handle = static_cast<Handle>(entries.size());
+        entries.emplace_back();
+    }
+    else
+    {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+    entries[handle] = {
+        .vertexCount = vertexCount,
+        .indexCount = indexCount,
+        .placement = placement.value(),
+        .destination = std::nullopt,
+        .isMovable = false,
+        .isReleased = false,
+        .isUsed = true
+    };
+
+    return Allocation(*this, handle, vertexCount * VertexStride + indexCount * IndexStride);
+}
+
+void GeometryHeap::markMovable(const Handle handle)
+{
+    std::lock_guard lock(mutex);
+
+    entries[handle].isMovable = true;
+}
+
+GeometryHeap::Location GeometryHeap::getLocation(const Handle handle) const
+{
+    std::lock_guard lock(mutex);
+
+    const Placement& placement = entries[handle].placement;
+    const Block& block = blocks[placement.block].value();
+
+    return {
+        .vertexBuffer = *block.vertexBuffer.getBuffer(),
+        .positionBuffer = *block.positionBuffer.getBuffer(),
+        .indexBuffer = *block.indexBuffer.getBuffer(),
+        .firstIndex = placement.firstIndex,
+        .vertexOffset = static_cast<int32_t>(placement.vertexOffset)
+    };
+}
+
+std::vector<GeometryHeap::Move> GeometryHeap::planMoves()
+{
+    std::lock_guard lock(mutex);
+
+    if (inFlightMoveCount > 0 or std::ranges::count_if(blocks, [](const std::optional<Block>& block) { return block.has_value(); }) < 2)
+    {
+        return {};
+    }
+
+    std::optional<uint32_t> source;
+    for (uint32_t i = 0; i < blocks.size(); ++i)
+    {
+        if (blocks[i].has_value() and getOccupancy(blocks[i].value()) < SparseBlockOccupancy and
+            (!source.has_value() or getOccupancy(blocks[i].value()) < getOccupancy(blocks[source.value()].value())))
+        {
+            source = i;
+        }
+    }
+    if (!source.has_value())
+    {
+        return {};
+    }
+
+    // Filling the densest blocks first leaves the other sparse blocks to be emptied next.
+    std::vector<uint32_t> destinations;
+    for (uint32_t i = 0; i < blocks.size(); ++i)
+    {
+        if (blocks[i].has_value() and i != source.value())
+        {
+            destinations.push_back(i);
+        }
+    }
+    std::ranges::sort(destinations, [this](const uint32_t first, const uint32_t second)
+    {
+        return getOccupancy(blocks[first].value()) > getOccupancy(blocks[second].value());
+    });
+
+    std::vector<Move> moves;
+    vk::DeviceSize moveSize = 0;
+    for (Handle handle = 0; handle < entries.size(); ++handle)
+    {
+        Entry& entry = entries[handle];
+        if (!entry.isUsed or !entry.isMovable or entry.destination.has_value() or entry.placement.block != source.value())
+        {
+            continue;
+        }
+
+        const vk::DeviceSize size = entry.vertexCount * VertexStride + entry.indexCount * IndexStride;
+        if (!moves.empty() and moveSize + size > MaxMoveSizePerStep)
+        {
+            break;
+        }
+
+        for (const uint32_t destination : destinations)
+        {
+            if (const std::optional<Placement> placement = allocateInBlock(destination, entry.vertexCount, entry.indexCount); placement.has_value())
+            {
+                entry.destination = placement;
+                moves.push_back({
+                    .handle = handle,
+                    .vertexCount = entry.vertexCount,
+                    .indexCount = entry.indexCount,
+                    .source = entry.placement,
+                    .destination = placement.value()
+                });
+                moveSize += size;
+                break;
+            }
+        }
+    }
+    inFlightMoveCount = static_cast<uint32_t>(moves.size());
+
+    return moves;
+}
+
+void GeometryHeap::recordMoves(const vk::CommandBuffer& commandBuffer, const std::span<const Move> moves) const
+{
+    std::lock_guard lock(mutex);
+
+    for (const Move& move : moves)
+    {
+        const Block& source = blocks[move.source.block].value();
+        const Block& destination = blocks[move.destination.block].value();
+
+        commandBuffer.copyBuffer(*source.vertexBuffer.getBuffer(), *destination.vertexBuffer.getBuffer(), vk::BufferCopy{
+            .srcOffset = move.source.vertexOffset * Vertex::Size,
+            .dstOffset = move.destination.vertexOffset * Vertex::Size,
+            .size = move.vertexCount * Vertex::Size
+        });
+        commandBuffer.copyBuffer(*source.positionBuffer.getBuffer(), *destination.positionBuffer.getBuffer(), vk::BufferCopy{
+            .srcOffset = move.source.vertexOffset * sizeof(glm::vec3),
+            .dstOffset = move.destination.vertexOffset * sizeof(glm::vec3),
+            .size = move.vertexCount * sizeof(glm::vec3)
+        });
+        commandBuffer.copyBuffer(*source.indexBuffer.getBuffer(), *destination.indexBuffer.getBuffer(), vk::BufferCopy{
+            .srcOffset = move.source.firstIndex * IndexStride,
+            .dstOffset = move.destination.firstIndex * IndexStride,
+            .size = move.indexCount * IndexStride
+        });
+    }
+
+    // Frames submitted after the moves complete draw from the destinations without waiting on this submission.
+    const vk::MemoryBarrier2 barrier = makeUploadBarrier();
+    const vk::DependencyInfo dependencyInfo{
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &barrier
+    };
+    commandBuffer.pipelineBarrier2(dependencyInfo);
+}
+
+void GeometryHeap::completeMoves(const std::span<const Move> moves, const uint64_t lastFrame)
+{
+    std::lock_guard lock(mutex);
+
+    for (const Move& move : moves)
+    {
+        Entry& entry = entries[move.handle];
+        if (entry.isReleased)
+        {
+            // Released geometry is no longer drawn, and the copy reading it has finished.
+            freeInBlock(move.source, move.vertexCount, move.indexCount);
+            freeInBlock(move.destination, move.vertexCount, move.indexCount);
+            freeHandle(move.handle);
+            continue;
+        }
+
+        retiredRanges.push_back({
+            .vertexCount = move.vertexCount,
+            .indexCount = move.indexCount,
+            .placement = move.source,
+            .lastFrame = lastFrame
+        });
+        entry.placement = move.destination;
+        entry.destination.reset();
+        ++moveCount;
+    }
+    inFlightMoveCount = 0;
+}
+
+void GeometryHeap::abandonMoves(const std::span<const Move> moves)
+{
+    std::lock_guard lock(mutex);
+
+    for (const Move& move : moves)
+    {
+        freeInBlock(move.destination, move.vertexCount, move.indexCount);
+        entries[move.handle].destination.reset();
+        if (entries[move.handle].isReleased)
+        {
+            freeInBlock(move.source, move.vertexCount, move.indexCount);
+            freeHandle(move.handle);
+        }
+    }
+    inFlightMoveCount = 0;
+}
+
+void GeometryHeap::releaseRetired(const uint64_t completedFrameCount)
+{
+    std::lock_guard lock(mutex);
+
+    while (!retiredRanges.empty() and retiredRanges.front().lastFrame < completedFrameCount)
+    {
+        const RetiredRange& range = retiredRanges.front();
+        freeInBlock(range.placement, range.vertexCount, range.indexCount);
+        retiredRanges.pop_front();
+    }
+
+    freeEmptyBlocks();
+}
+
+GeometryHeap::Statistics GeometryHeap::getStatistics() const
+{
+    std::lock_guard lock(mutex);
+
+    Statistics statistics{
+        .blockCount = 0,
+        .capacity = 0,
+        .usedSize = 0,
+        .moveCount = moveCount,
+        .freedBlockCount = freedBlockCount
+    };
+    for (const std::optional<Block>& block : blocks)
+    {
+        if (block.has_value())
+        {
+            ++statistics.blockCount;
+            statistics.capacity += block->vertexCapacity * VertexStride + block->indexCapacity * IndexStride;
+            statistics.usedSize += block->vertexRanges.getUsedCount() * VertexStride + block->indexRanges.getUsedCount() * IndexStride;
+        }
+    }
+
+    return statistics;
+}
+
+vk::MemoryBarrier2 GeometryHeap::makeUploadBarrier()
+{
+    return {
+        .srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eVertexAttributeInput | vk::PipelineStageFlagBits2::eIndexInput,
+        .dstAccessMask = vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eIndexRead
+    };
+}
+
+void GeometryHeap::release(const Handle handle)
+{
+    std::lock_guard lock(mutex);
+
+    Entry& entry = entries[handle];
+    if (entry.destination.has_value())
+    {
+        entry.isReleased = true;
+        return;
+    }
+
+    // Owners release geometry only once no frame in flight draws it, so its ranges are free right away.
+    freeInBlock(entry.placement, entry.vertexCount, entry.indexCount);
+    freeHandle(handle);
+}
+
+std::optional<GeometryHeap::Placement> GeometryHeap::allocateInBlock(const uint32_t block, const uint32_t vertexCount, const uint32_t indexCount)
+{
+    Block& target = blocks[block].value();
+
+    const std::optional<uint32_t> vertexOffset = target.vertexRanges.allocate(vertexCount);
+    if (!vertexOffset.has_value())
+    {
+        return std::nullopt;
+    }
+    const std::optional<uint32_t> firstIndex = target.indexRanges.allocate(indexCount);
+    if (!firstIndex.has_value())
+    {
+        target.vertexRanges.free(vertexOffset.value(), vertexCount);
+        return std::nullopt;
+    }
+
+    return Placement{
+        .block = block,
+        .vertexOffset = vertexOffset.value(),
+        .firstIndex = firstIndex.value()
+    };
+}
+
+void GeometryHeap::freeInBlock(const Placement& placement, const uint32_t vertexCount, const uint32_t indexCount)
+{
+    Block& block = blocks[placement.block].value();
+    block.vertexRanges.free(placement.vertexOffset, vertexCount);
+    block.indexRanges.free(placement.firstIndex, indexCount);
+}
+
+void GeometryHeap::freeHandle(const Handle handle)
+{
+    entries[handle] = {
+        .vertexCount = 0,
+        .indexCount = 0,
+        .placement = {},
+        .destination = std::nullopt,
+        .isMovable = false,
+        .isReleased = false,
+        .isUsed = false
+    };
+    freeHandles.push_back(handle);
+}
+
+void GeometryHeap::freeEmptyBlocks()
+{
+    auto blockCount = std::ranges::count_if(blocks, [](const std::optional<Block>& block) { return block.has_value(); });
+    for (std::optional<Block>& block : blocks)
+    {
+        if (blockCount > 1 and block.has_value() and block->vertexRanges.getUsedCount() == 0 and block->indexRanges.getUsedCount() == 0)
+        {
+            block.reset();
+            --blockCount;
+            ++freedBlockCount;
+        }
+    }
+}
+
+uint32_t GeometryHeap::addBlock(const uint32_t vertexCapacity, const uint32_t indexCapacity)
+{
+    Block block{
+        .vertexBuffer = DeviceLocalBuffer(environment.get(), vertexCapacity * Vertex::Size, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferSrc),
+        .positionBuffer = DeviceLocalBuffer(environment.get(), vertexCapacity * sizeof(glm::vec3), vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferSrc),
+        .indexBuffer = DeviceLocalBuffer(environment.get(), indexCapacity * IndexStride, vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferSrc),
+        .vertexCapacity = vertexCapacity,
+        .indexCapacity = indexCapacity,
+        .vertexRanges = RangeAllocator(vertexCapacity),
+        .indexRanges = RangeAllocator(indexCapacity)
+    };
+
+    const auto freeSlot = std::ranges::find_if(blocks, [](const std::optional<Block>& slot) { return !slot.has_value(); });
+    if (freeSlot == blocks.end())
+    {
+        blocks.emplace_back(std::move(block));
+        return static_cast<uint32_t>(blocks.size() - 1);
+    }
+
+    freeSlot->emplace(std::move(block));
+    return static_cast<uint32_t>(freeSlot - blocks.begin());
+}
+
+double GeometryHeap::getOccupancy(const Block& block)
+{
+    const vk::DeviceSize capacity = block.vertexCapacity * VertexStride + block.indexCapacity * IndexStride;
+    const vk::DeviceSize usedSize = block.vertexRanges.getUsedCount() * VertexStride + block.indexRanges.getUsedCount() * IndexStride;
+
+    return static_cast<double>(usedSize) / static_cast<double>(capacity);
+}
@@ -0,0 +1,195 @@
+#ifndef GEOMETRY_HEAP_H
+#define GEOMETRY_HEAP_H
+
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <vulkan/vulkan_raii.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "environment.h"
+#include "device_local_buffer.h"
+#include "../vertex.h"
+
+
+// Mesh geometry sub-allocated from a few large blocks, each holding a vertex, a position and an index buffer. A mesh's
+// vertices take the same range in the vertex and position buffers, so one vertexOffset addresses both. Loading and
+// evicting meshes over a long session leaves blocks sparsely used; the defragmenter moves geometry out of the sparsest
+// block with GPU copies, a bounded amount per frame, and frees blocks once they are empty. Meshes are referred to by
+// handles that stay valid across moves, and draws look their location up every frame, so a move needs no descriptor or
+// draw list update. Only geometry is defragmented: textures keep an allocation of their own each, leave no holes
+// between them, and are never relocated. Thread-safe.
+class GeometryHeap {
+public:
+    static constexpr uint32_t BlockVertexCount = 1 << 18;
+    static constexpr uint32_t BlockIndexCount = 6 * BlockVertexCount;
+    static constexpr vk::DeviceSize VertexStride = Vertex::Size + sizeof(glm::vec3);
+    static constexpr vk::DeviceSize IndexStride = sizeof(uint32_t);
+    // Blocks used below this fraction of their capacity are emptied into the others.
+    static constexpr double SparseBlockOccupancy = 0.5;
+    // Geometry bytes copied per defragmentation step; a single larger mesh still moves on its own.
+    static constexpr vk::DeviceSize MaxMoveSizePerStep = 8 << 20;
+
+    using Handle = uint32_t;
+
+    struct Location
+    {
+        vk::Buffer vertexBuffer;
+        vk::Buffer positionBuffer;
+        vk::Buffer indexBuffer;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+    };
+    struct Placement
+    {
+        uint32_t block;
+        uint32_t vertexOffset;
+        uint32_t firstIndex;
+    };
+    struct Move
+    {
+        Handle handle;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        Placement source;
+        Placement destination;
+    };
+    struct Statistics
+    {
+        uint32_t blockCount;
+        vk::DeviceSize capacity;
+        vk::DeviceSize usedSize;
+        uint64_t moveCount;
+        uint64_t freedBlockCount;
+    };
+
+    // Keeps a mesh's geometry allocated until destroyed.
+    class Allocation {
+    private:
+        GeometryHeap* heap;
+        Handle handle;
+        vk::DeviceSize size;
+
+    public:
+        Allocation(GeometryHeap& heap, const Handle handle, const vk::DeviceSize size);
+        ~Allocation();
+
+        Allocation(const Allocation&) = delete;
+        Allocation& operator=(const Allocation&) = delete;
+
+        Allocation(Allocation&& other) noexcept;
+        Allocation& operator=(Allocation&& other) noexcept;
+
+        Handle getHandle() const;
+        vk::DeviceSize getSize() const;
+
+    private:
+        void release();
+    };
+
+private:
+    // Free ranges of a block's vertex or index space, by offset, merged with their neighbours when freed.
+    class RangeAllocator {
+    private:
+        std::map<uint32_t, uint32_t> freeRanges;
+        uint32_t usedCount;
+
+    public:
+        explicit RangeAllocator(const uint32_t capacity);
+
+        std::optional<uint32_t> allocate(const uint32_t count);
+        void free(const uint32_t offset, const uint32_t count);
+        uint32_t getUsedCount() const;
+    };
+    struct Block
+    {
+        DeviceLocalBuffer vertexBuffer;
+        DeviceLocalBuffer positionBuffer;
+        DeviceLocalBuffer indexBuffer;
+        uint32_t vertexCapacity;
+        uint32_t indexCapacity;
+        RangeAllocator vertexRanges;
+        RangeAllocator indexRanges;
+    };
+    struct Entry
+    {
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        Placement placement;
+        // Where a move in flight copies the geometry to.
+        std::optional<Placement> destination;
+        // Set once the contents are uploaded; only movable geometry is defragmented.
+        bool isMovable;
+        // Released while a move was in flight; the move frees both ranges when it ends.
+        bool isReleased;
+        bool isUsed;
+    };
+    struct RetiredRange
+    {
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        Placement placement;
+        // The last frame whose draw list may still reference the range.
+        uint64_t lastFrame;
+    };
+
+    std::reference_wrapper<const Environment> environment;
+    mutable std::mutex mutex;
+    std::vector<std::optional<Block>> blocks;
+    std::vector<Entry> entries;
+    std::vector<Handle> freeHandles;
+    std::deque<RetiredRange> retiredRanges;
+    uint32_t inFlightMoveCount;
+    uint64_t moveCount;
+    uint64_t freedBlockCount;
+
+public:
+    explicit GeometryHeap(const Environment& environment);
+    ~GeometryHeap();
+
+    GeometryHeap(const GeometryHeap&) = delete;
+    GeometryHeap& operator=(const GeometryHeap&) = delete;
+
+    // Finds room in an existing block, or adds a block large enough for the mesh.
+    Allocation allocate(const uint32_t vertexCount, const uint32_t indexCount);
+    // Called once the geometry is uploaded, after which the defragmenter may move it.
+    void markMovable(const Handle handle);
+    Location getLocation(const Handle handle) const;
+
+    // Picks the next moves out of the sparsest block and reserves their destinations. Returns nothing while the
+    // previous moves are in flight or no block is sparse enough to be worth emptying.
+    std::vector<Move> planMoves();
+    // Records the copies of moves, which must finish before completeMoves is called.
+    void recordMoves(const vk::CommandBuffer& commandBuffer, const std::span<const Move> moves) const;
+    // Points the moved handles at their destinations. The sources stay allocated until the frames up to lastFrame,
+    // which were drawn from them, are done on the GPU.
+    void completeMoves(const std::span<const Move> moves, const uint64_t lastFrame);
+    // Frees the destinations of moves whose copies were never made.
+    void abandonMoves(const std::span<const Move> moves);
+    // Frees retired ranges whose last frame is below completedFrameCount, then every empty block but the last one.
+    void releaseRetired(const uint64_t completedFrameCount);
+
+    Statistics getStatistics() const;
+
+    // Makes copies into the heap's buffers visible to vertex and index fetch of later submissions.
+    static vk::MemoryBarrier2 makeUploadBarrier();
+
+private:
+    void release(const Handle handle);
+    // The helpers below must be called with the mutex held.
+    std::optional<Placement> allocateInBlock(const uint32_t block, const uint32_t vertexCount, const uint32_t indexCount);
+    void freeInBlock(const Placement& placement, const uint32_t vertexCount, const uint32_t indexCount);
+    void freeHandle(const Handle handle);
+    void freeEmptyBlocks();
+    uint32_t addBlock(const uint32_t vertexCapacity, const uint32_t indexCapacity);
+    static double getOccupancy(const Block& block);
+};
+
+
+#endif //GEOMETRY_HEAP_H
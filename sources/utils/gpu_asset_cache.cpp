@@ -0,0 +1,159 @@
+#include "gpu_asset_cache.h"
+
+
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+
+GpuAssetCache::GpuAssetCache(const vk::DeviceSize budget) :
+    budget(budget),
+    entries(),
+    evictedKeys(),
+    retiredAssets(),
+    residentSize(0),
+    hitCount(0),
+    missCount(0),
+    evictionCount(0),
+    reuploadCount(0)
+{
+}
+
+GpuAssetCache::~GpuAssetCache() = default;
+
+bool GpuAssetCache::request(const Key& key)
+{
+    const bool isResident = entries.contains(key);
+    ++(isResident ? hitCount : missCount);
+
+    return isResident;
+}
+
+const GpuAssetCache::Asset* GpuAssetCache::find(const Key& key) const
+{
+    const auto iterator = entries.find(key);
+
+    return iterator != entries.end() ? &iterator->second.asset : nullptr;
+}
+
+void GpuAssetCache::touch(const Key& key, const uint64_t frame)
+{
+    if (const auto iterator = entries.find(key); iterator != entries.end())
+    {
+        iterator->second.lastUsedFrame = std::max(iterator->second.lastUsedFrame, frame);
+    }
+}
+
+const GpuAssetCache::Asset& GpuAssetCache::insert(const Key& key, Asset asset, const uint64_t frame)
+{
+    const vk::DeviceSize size = getSize(asset);
+    const auto [iterator, inserted] = entries.try_emplace(key, Entry{
+        .asset = std::move(asset),
+        .size = size,
+        .lastUsedFrame = frame
+    });
+    if (!inserted)
+    {
+        throw std::logic_error("Asset is already resident in the cache.");
+    }
+
+    residentSize += size;
+    if (evictedKeys.erase(key) > 0)
+    {
+        ++reuploadCount;
+    }
+
+    return iterator->second.asset;
+}
+
+uint32_t GpuAssetCache::evict(const uint64_t lastFrame)
+{
+    uint32_t evictedCount = 0;
+
+    while (residentSize > budget)
+    {
+        auto leastRecentlyUsed = entries.end();
+        for (auto iterator = entries.begin(); iterator != entries.end(); ++iterator)
+        {
+            if (iterator->second.lastUsedFrame < lastFrame and
+                (leastRecentlyUsed == entries.end() or iterator->second.lastUsedFrame < leastRecentlyUsed->second.lastUsedFrame))
+            {
+                leastRecentlyUsed = iterator;
+            }
+        }
+        // Everything left was used by the latest frame; the cache stays over budget until some of it falls out of view.
+        if (leastRecentlyUsed == entries.end())
+        {
+            break;
+        }
+
+        residentSize -= leastRecentlyUsed->second.size;
+        retiredAssets.push_back({
+            .asset = std::move(leastRecentlyUsed->second.asset),
+            .lastFrame = lastFrame
+        });
+        evictedKeys.insert(leastRecentlyUsed->first);
+        entries.erase(leastRecentlyUsed);
+        ++evictionCount;
+        ++evictedCount;
+    }
+
+    return evictedCount;
+}
+
+void GpuAssetCache::releaseRetired(const uint64_t completedFrameCount)
+{
+    // Assets retire in frame order, so the oldest are at the front.
+    while (!retiredAssets.empty() and retiredAssets.front().lastFrame < completedFrameCount)
+    {
+        retiredAssets.pop_front();
+    }
+}
+
+void GpuAssetCache::setBudget(const vk::DeviceSize budget)
+{
+    this->budget = budget;
+}
+
+GpuAssetCache::Statistics GpuAssetCache::getStatistics() const
+{
+    return {
+        .hitCount = hitCount,
+        .missCount = missCount,
+        .evictionCount = evictionCount,
+        .reuploadCount = reuploadCount,
+        .residentSize = residentSize,
+        .budget = budget
+    };
+}
+
+GpuAssetCache::Key GpuAssetCache::hashContent(const std::span<const std::byte> content)
+{
+    // 64-bit FNV-1a, independent of the standard library hash.
+    uint64_t checkHash = 0xcbf29ce484222325;
+    for (const std::byte byte : content)
+    {
+        checkHash = (checkHash ^ static_cast<uint64_t>(byte)) * 0x100000001b3;
+    }
+
+    return {
+        .hash = std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(content.data()), content.size())),
+        .checkHash = checkHash,
+        .size = content.size()
+    };
+}
+
+vk::DeviceSize GpuAssetCache::getSize(const Asset& asset)
+{
+    if (const Mesh* mesh = std::get_if<Mesh>(&asset))
+    {
+        return mesh->geometry.getSize();
+    }
+
+    return std::get<Texture>(asset).image.getSize();
+}
+
+size_t GpuAssetCache::KeyHash::operator()(const Key& key) const noexcept
+{
+    return key.hash;
+}
@@ -0,0 +1,122 @@
+#ifndef GPU_ASSET_CACHE_H
+#define GPU_ASSET_CACHE_H
+
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <vulkan/vulkan_raii.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+
+#include "device_local_image.h"
+#include "geometry_heap.h"
+
+
+// GPU meshes and textures keyed by the content of the file they were loaded from, so identical files share one upload.
+// Once the resident size exceeds the budget, the assets used least recently are evicted. Evicted assets are
+// retired rather than destroyed, because frames still in flight may draw them.
+class GpuAssetCache {
+public:
+    static constexpr vk::DeviceSize Unlimited = std::numeric_limits<vk::DeviceSize>::max();
+
+    // Identifies file content by its size and two independent 64-bit hashes. Lookups compare all three, so files
+    // whose first hash collides still get separate entries.
+    struct Key
+    {
+        uint64_t hash;
+        uint64_t checkHash;
+        uint64_t size;
+
+        bool operator==(const Key&) const = default;
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const noexcept;
+    };
+
+    struct Mesh
+    {
+        GeometryHeap::Allocation geometry;
+        uint32_t indexCount;
+        glm::vec4 boundingSphere;
+    };
+    struct Texture
+    {
+        DeviceLocalImage image;
+        vk::raii::DescriptorSet descriptorSet;
+    };
+    using Asset = std::variant<Mesh, Texture>;
+
+    struct Statistics
+    {
+        uint64_t hitCount;
+        uint64_t missCount;
+        uint64_t evictionCount;
+        uint64_t reuploadCount;
+        vk::DeviceSize residentSize;
+        vk::DeviceSize budget;
+    };
+
+private:
+    struct Entry
+    {
+        Asset asset;
+        vk::DeviceSize size;
+        uint64_t lastUsedFrame;
+    };
+    struct RetiredAsset
+    {
+        Asset asset;
+        // The last frame whose draw list may still reference the asset.
+        uint64_t lastFrame;
+    };
+
+    vk::DeviceSize budget;
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    std::unordered_set<Key, KeyHash> evictedKeys;
+    std::deque<RetiredAsset> retiredAssets;
+    vk::DeviceSize residentSize;
+    uint64_t hitCount;
+    uint64_t missCount;
+    uint64_t evictionCount;
+    uint64_t reuploadCount;
+
+public:
+    explicit GpuAssetCache(const vk::DeviceSize budget = Unlimited);
+    ~GpuAssetCache();
+
+    GpuAssetCache(const GpuAssetCache&) = delete;
+    GpuAssetCache& operator=(const GpuAssetCache&) = delete;
+
+    // Looks up an asset that is about to be loaded, counting a hit if it is resident and a miss otherwise.
+    bool request(const Key& key);
+    // Looks up an asset for drawing without touching the statistics; returns nullptr if it is not resident.
+    const Asset* find(const Key& key) const;
+    // Marks a resident asset as used by frame, protecting it from eviction while that frame is the latest.
+    void touch(const Key& key, const uint64_t frame);
+    const Asset& insert(const Key& key, Asset asset, const uint64_t frame);
+    // Evicts the least recently used assets that lastFrame did not use until the cache fits its budget.
+    // Returns how many were evicted.
+    uint32_t evict(const uint64_t lastFrame);
+    // Destroys retired assets whose last frame is below completedFrameCount, and therefore done on the GPU.
+    void releaseRetired(const uint64_t completedFrameCount);
+
+    void setBudget(const vk::DeviceSize budget);
+    Statistics getStatistics() const;
+
+    static Key hashContent(const std::span<const std::byte> content);
+
+private:
+    static vk::DeviceSize getSize(const Asset& asset);
+};
+
+
+#endif //GPU_ASSET_CACHE_H
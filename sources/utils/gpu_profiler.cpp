@@ -0,0 +1,272 @@
+#include "gpu_profiler.h"
+
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+
+GpuProfiler::Scope::Scope(GpuProfiler& profiler, const vk::CommandBuffer& commandBuffer, const char* name) :
+    profiler(profiler),
+    commandBuffer(commandBuffer),
+    scopeIndex(profiler.beginScope(commandBuffer, name))
+{
+}
+
+GpuProfiler::Scope::~Scope()
+{
+    if (scopeIndex.has_value())
+    {
+        profiler.endScope(commandBuffer, scopeIndex.value());
+    }
+}
+
+GpuProfiler::GpuProfiler(const Environment& environment, const uint32_t frameCount, const bool pipelineStatisticsRequested) :
+    environment(environment),
+    timestampsSupported(environment.physicalDeviceProperties.limits.timestampComputeAndGraphics),
+    pipelineStatisticsEnabled(timestampsSupported and pipelineStatisticsRequested and environment.isPipelineStatisticsQueryEnabled()),
+    frameCount(frameCount),
+    timestampQueryPool(createTimestampQueryPool()),
+    pipelineStatisticsQueryPool(createPipelineStatisticsQueryPool()),
+    frameScopes(frameCount),
+    recordingFrame(0),
+    depth(0),
+    histories()
+{
+    for (std::vector<ScopeRecord>& scopes : frameScopes)
+    {
+        scopes.reserve(MaxScopesPerFrame);
+    }
+    histories.reserve(MaxScopesPerFrame);
+}
+
+GpuProfiler::~GpuProfiler() = default;
+
+void GpuProfiler::beginFrame(const vk::CommandBuffer& commandBuffer, const uint32_t frameIndex)
+{
+    recordingFrame = frameIndex;
+    depth = 0;
+    frameScopes[frameIndex].clear();
+
+    if (!timestampsSupported)
+    {
+        return;
+    }
+
+    commandBuffer.resetQueryPool(*timestampQueryPool, getFirstTimestampQuery(frameIndex), 2 * MaxScopesPerFrame);
+    if (pipelineStatisticsEnabled)
+    {
+        commandBuffer.resetQueryPool(*pipelineStatisticsQueryPool, getFirstPipelineStatisticsQuery(frameIndex), MaxScopesPerFrame);
+    }
+
+    beginScope(commandBuffer, FrameScopeName);
+}
+
+void GpuProfiler::endFrame(const vk::CommandBuffer& commandBuffer)
+{
+    if (!frameScopes[recordingFrame].empty())
+    {
+        endScope(commandBuffer, 0);
+    }
+}
+
+bool GpuProfiler::collect(const uint32_t frameIndex)
+{
+    const std::vector<ScopeRecord>& scopes = frameScopes[frameIndex];
+    if (scopes.empty())
+    {
+        return false;
+    }
+
+    const auto scopeCount = static_cast<uint32_t>(scopes.size());
+    // Results are read into fixed-size arrays so collecting a frame never allocates.
+    const auto [timestampResult, timestamps] = timestampQueryPool.getResult<std::array<uint64_t, 2 * MaxScopesPerFrame>>(getFirstTimestampQuery(frameIndex), 2 * scopeCount, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+    if (timestampResult == vk::Result::eSuccess)
+    {
+        const float timestampPeriod = environment.get().physicalDeviceProperties.limits.timestampPeriod;
+
+        for (uint32_t i = 0; i < scopeCount; ++i)
+        {
+            ScopeHistory& history = findHistory(scopes[i]);
+            const float time = static_cast<float>(timestamps[2 * i + 1] - timestamps[2 * i]) * timestampPeriod / 1e6f;
+
+            history.samples[history.nextSample] = time;
+            history.nextSample = (history.nextSample + 1) % AverageWindow;
+            history.sampleCount = std::min(history.sampleCount + 1, AverageWindow);
+            history.timing.lastTime = time;
+            history.timing.averageTime = std::accumulate(history.samples.begin(), history.samples.begin() + history.sampleCount, 0.0f) / static_cast<float>(history.sampleCount);
+
+            if (!scopes[i].hasPipelineStatistics)
+            {
+                continue;
+            }
+
+            const auto [statisticsResult, statistics] = pipelineStatisticsQueryPool.getResult<std::array<uint64_t, 2>>(getFirstPipelineStatisticsQuery(frameIndex) + i, 1, 2 * sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+            if (statisticsResult == vk::Result::eSuccess)
+            {
+                history.timing.vertexInvocations = statistics[0];
+                history.timing.fragmentInvocations = statistics[1];
+            }
+        }
+    }
+
+    return timestampResult == vk::Result::eSuccess;
+}
+
+bool GpuProfiler::isEnabled() const
+{
+    return timestampsSupported;
+}
+
+float GpuProfiler::getLastTime(const std::string_view name) const
+{
+    const ScopeHistory* history = findHistory(name);
+
+    return history != nullptr ? history->timing.lastTime : 0.0f;
+}
+
+float GpuProfiler::getAverageTime(const std::string_view name) const
+{
+    const ScopeHistory* history = findHistory(name);
+
+    return history != nullptr ? history->timing.averageTime : 0.0f;
+}
+
+void GpuProfiler::dump(std::ostream& stream) const
+{
+    if (!timestampsSupported)
+    {
+        stream << "GPU profiler unavailable: timestamps are not supported on graphics queues." << std::endl;
+        return;
+    }
+
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(3)
+           << "GPU profile (ms, last / average over up to " << AverageWindow << " frames):\n";
+    for (const ScopeHistory& history : histories)
+    {
+        const ScopeTiming& timing = history.timing;
+        report << std::string(2 * (timing.depth + 1), ' ') << timing.name << ": " << timing.lastTime << " / " << timing.averageTime;
+        if (timing.vertexInvocations.has_value())
+        {
+            report << " (vertex invocations " << timing.vertexInvocations.value() << ", fragment invocations " << timing.fragmentInvocations.value() << ")";
+        }
+        report << "\n";
+    }
+
+    stream << report.str() << std::flush;
+}
+
+std::optional<uint32_t> GpuProfiler::beginScope(const vk::CommandBuffer& commandBuffer, const char* name)
+{
+    std::vector<ScopeRecord>& scopes = frameScopes[recordingFrame];
+    if (!timestampsSupported or scopes.size() >= MaxScopesPerFrame)
+    {
+        return std::nullopt;
+    }
+
+    const auto scopeIndex = static_cast<uint32_t>(scopes.size());
+    // Pipeline statistics queries of one pool cannot nest, so only the passes directly below the frame collect them.
+    const bool hasPipelineStatistics = pipelineStatisticsEnabled and depth == 1;
+    scopes.push_back({
+        .name = name,
+        .depth = depth,
+        .hasPipelineStatistics = hasPipelineStatistics
+    });
+
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *timestampQueryPool, getFirstTimestampQuery(recordingFrame) + 2 * scopeIndex);
+    if (hasPipelineStatistics)
+    {
+        commandBuffer.beginQuery(*pipelineStatisticsQueryPool, getFirstPipelineStatisticsQuery(recordingFrame) + scopeIndex, {});
+    }
+    ++depth;
+
+    return scopeIndex;
+}
+
+void GpuProfiler::endScope(const vk::CommandBuffer& commandBuffer, const uint32_t scopeIndex)
+{
+    --depth;
+    if (frameScopes[recordingFrame][scopeIndex].hasPipelineStatistics)
+    {
+        commandBuffer.endQuery(*pipelineStatisticsQueryPool, getFirstPipelineStatisticsQuery(recordingFrame) + scopeIndex);
+    }
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *timestampQueryPool, getFirstTimestampQuery(recordingFrame) + 2 * scopeIndex + 1);
+}
+
+GpuProfiler::ScopeHistory& GpuProfiler::findHistory(const ScopeRecord& scopeRecord)
+{
+    const auto iterator = std::ranges::find_if(histories, [&scopeRecord](const ScopeHistory& history)
+    {
+        return history.timing.depth == scopeRecord.depth and history.timing.name == scopeRecord.name;
+    });
+    if (iterator != histories.end())
+    {
+        return *iterator;
+    }
+
+    histories.push_back({
+        .timing = {
+            .name = scopeRecord.name,
+            .depth = scopeRecord.depth,
+            .lastTime = 0.0f,
+            .averageTime = 0.0f,
+            .vertexInvocations = std::nullopt,
+            .fragmentInvocations = std::nullopt
+        },
+        .samples = {},
+        .sampleCount = 0,
+        .nextSample = 0
+    });
+
+    return histories.back();
+}
+
+const GpuProfiler::ScopeHistory* GpuProfiler::findHistory(const std::string_view name) const
+{
+    const auto iterator = std::ranges::find_if(histories, [name](const ScopeHistory& history) { return history.timing.name == name; });
+
+    return iterator != histories.end() ? &*iterator : nullptr;
+}
+
+uint32_t GpuProfiler::getFirstTimestampQuery(const uint32_t frameIndex) const
+{
+    return 2 * MaxScopesPerFrame * frameIndex;
+}
+
+uint32_t GpuProfiler::getFirstPipelineStatisticsQuery(const uint32_t frameIndex) const
+{
+    return MaxScopesPerFrame * frameIndex;
+}
+
+vk::raii::QueryPool GpuProfiler::createTimestampQueryPool() const
+{
+    if (!timestampsSupported)
+    {
+        return nullptr;
+    }
+
+    const vk::QueryPoolCreateInfo createInfo{
+        .queryType = vk::QueryType::eTimestamp,
+        .queryCount = 2 * MaxScopesPerFrame * frameCount
+    };
+
+    return environment.get().device.createQueryPool(createInfo);
+}
+
+vk::raii::QueryPool GpuProfiler::createPipelineStatisticsQueryPool() const
+{
+    if (!pipelineStatisticsEnabled)
+    {
+        return nullptr;
+    }
+
+    const vk::QueryPoolCreateInfo createInfo{
+        .queryType = vk::QueryType::ePipelineStatistics,
+        .queryCount = MaxScopesPerFrame * frameCount,
+        .pipelineStatistics = vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations | vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations
+    };
+
+    return environment.get().device.createQueryPool(createInfo);
+}
@@ -0,0 +1,110 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <vulkan/vulkan_raii.hpp>
+
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "environment.h"
+
+
+// Measures GPU time of nested scopes with timestamp queries. Each command buffer that records frames owns its own
+// query range, which is read back after that command buffer's fence has been waited on, so collecting results never
+// stalls. A range keeps its scopes until it is recorded again, so a cached command buffer can be resubmitted as is.
+// Every frame is itself the root scope, named FrameScopeName.
+class GpuProfiler {
+public:
+    static constexpr uint32_t MaxScopesPerFrame = 32;
+    static constexpr uint32_t AverageWindow = 64;
+    static constexpr auto FrameScopeName = "Frame";
+
+    // Writes a timestamp when constructed and another when destroyed. Scopes directly below the frame also
+    // collect vertex and fragment shader invocations when pipeline statistics are enabled.
+    class Scope {
+    public:
+        Scope(GpuProfiler& profiler, const vk::CommandBuffer& commandBuffer, const char* name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        GpuProfiler& profiler;
+        vk::CommandBuffer commandBuffer;
+        std::optional<uint32_t> scopeIndex;
+    };
+
+    struct ScopeTiming
+    {
+        std::string name;
+        uint32_t depth;
+        float lastTime;
+        float averageTime;
+        std::optional<uint64_t> vertexInvocations;
+        std::optional<uint64_t> fragmentInvocations;
+    };
+
+private:
+    struct ScopeRecord
+    {
+        const char* name;
+        uint32_t depth;
+        bool hasPipelineStatistics;
+    };
+    struct ScopeHistory
+    {
+        ScopeTiming timing;
+        std::array<float, AverageWindow> samples;
+        uint32_t sampleCount;
+        uint32_t nextSample;
+    };
+
+    std::reference_wrapper<const Environment> environment;
+    const bool timestampsSupported;
+    const bool pipelineStatisticsEnabled;
+    const uint32_t frameCount;
+    vk::raii::QueryPool timestampQueryPool;
+    vk::raii::QueryPool pipelineStatisticsQueryPool;
+    std::vector<std::vector<ScopeRecord>> frameScopes;
+    uint32_t recordingFrame;
+    uint32_t depth;
+    std::vector<ScopeHistory> histories;
+
+public:
+    // frameCount is the number of command buffers that record frames. Pipeline statistics are collected only if requested and enabled on the device.
+    GpuProfiler(const Environment& environment, const uint32_t frameCount, const bool pipelineStatisticsRequested);
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // Resets the queries of frameIndex and opens the frame scope; the previous submission of frameIndex must have been collected.
+    void beginFrame(const vk::CommandBuffer& commandBuffer, const uint32_t frameIndex);
+    void endFrame(const vk::CommandBuffer& commandBuffer);
+    // Reads back the scopes recorded for frameIndex and returns whether timings arrived. Call it once per submission, after its fence has been waited on.
+    bool collect(const uint32_t frameIndex);
+
+    bool isEnabled() const;
+    float getLastTime(const std::string_view name) const;
+    float getAverageTime(const std::string_view name) const;
+    void dump(std::ostream& stream) const;
+
+private:
+    std::optional<uint32_t> beginScope(const vk::CommandBuffer& commandBuffer, const char* name);
+    void endScope(const vk::CommandBuffer& commandBuffer, const uint32_t scopeIndex);
+    ScopeHistory& findHistory(const ScopeRecord& scopeRecord);
+    const ScopeHistory* findHistory(const std::string_view name) const;
+    uint32_t getFirstTimestampQuery(const uint32_t frameIndex) const;
+    uint32_t getFirstPipelineStatisticsQuery(const uint32_t frameIndex) const;
+
+    vk::raii::QueryPool createTimestampQueryPool() const;
+    vk::raii::QueryPool createPipelineStatisticsQueryPool() const;
+};
+
+
+#endif //GPU_PROFILER_H
@@ -1,20 +1,25 @@
 #include "host_visible_buffer.h"
 
 HostVisibleBuffer::HostVisibleBuffer(const Environment& environment, const vk::DeviceSize size,
-    const vk::BufferUsageFlags usage) :
+    const vk::BufferUsageFlags usage, const vk::MemoryPropertyFlags preferredProperties) :
     AbstractBuffer(environment, size, usage),
-    bufferMemory(bindBufferMemory(buffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)),
-    mappedMemory(bufferMemory.mapMemory(0, size))
+    memoryProperties(selectMemoryProperties(preferredProperties)),
+    bufferMemory(bindBufferMemory(buffer, memoryProperties, DeviceMemoryTracker::getBufferCategory(usage))),
+    mappedMemory(bufferMemory.getMemory().mapMemory(0, size))
 {
 }
 
 HostVisibleBuffer::~HostVisibleBuffer()
 {
-    bufferMemory.unmapMemory();
+    if (mappedMemory != nullptr)
+    {
+        bufferMemory.getMemory().unmapMemory();
+    }
 }
 
 HostVisibleBuffer::HostVisibleBuffer(HostVisibleBuffer&& other) noexcept :
     AbstractBuffer(std::move(other)),
+    memoryProperties(other.memoryProperties),
     bufferMemory(std::move(other.bufferMemory)),
     mappedMemory(other.mappedMemory)
 {
@@ -26,7 +31,9 @@ HostVisibleBuffer& HostVisibleBuffer::operator=(HostVisibleBuffer&& other) noexc
     if (this != &other)
     {
         AbstractBuffer::operator=(std::move(other));
+        memoryProperties = other.memoryProperties;
         bufferMemory = std::move(other.bufferMemory);
+        mappedMemory = other.mappedMemory;
 
         other.mappedMemory = nullptr;
     }
@@ -42,5 +49,46 @@ void HostVisibleBuffer::uploadData(const void* sourceData, const vk::DeviceSize
     }
 
     std::memcpy(mappedMemory, sourceData, dataSize);
+
+    if (!(memoryProperties & vk::MemoryPropertyFlagBits::eHostCoherent))
+    {
+        const vk::MappedMemoryRange range{
+            .memory = *bufferMemory.getMemory(),
+            .offset = 0,
+            .size = vk::WholeSize
+        };
+        environment.get().device.flushMappedMemoryRanges(range);
+    }
+}
+
+void HostVisibleBuffer::invalidate() const
+{
+    if (!(memoryProperties & vk::MemoryPropertyFlagBits::eHostCoherent))
+    {
+        const vk::MappedMemoryRange range{
+            .memory = *bufferMemory.getMemory(),
+            .offset = 0,
+            .size = vk::WholeSize
+        };
+        environment.get().device.invalidateMappedMemoryRanges(range);
+    }
 }
 
+const void* HostVisibleBuffer::getMappedMemory() const
+{
+    return mappedMemory;
+}
+
+vk::MemoryPropertyFlags HostVisibleBuffer::selectMemoryProperties(const vk::MemoryPropertyFlags preferredProperties) const
+{
+    const DeviceMemoryTracker& memoryTracker = environment.get().getMemoryTracker();
+    const uint32_t memoryTypeBits = buffer.getMemoryRequirements().memoryTypeBits;
+
+    const vk::MemoryPropertyFlags properties = vk::MemoryPropertyFlagBits::eHostVisible | preferredProperties;
+    if (memoryTracker.hasMemoryType(memoryTypeBits, properties))
+    {
+        return memoryTracker.getMemoryTypeProperties(memoryTypeBits, properties);
+    }
+
+    return memoryTracker.getMemoryTypeProperties(memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+}
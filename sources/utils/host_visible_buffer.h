@@ -7,11 +7,15 @@
 
 class HostVisibleBuffer : public AbstractBuffer {
 private:
-    vk::raii::DeviceMemory bufferMemory;
+    vk::MemoryPropertyFlags memoryProperties;
+    DeviceMemoryTracker::Allocation bufferMemory;
     void* mappedMemory;
 
 public:
-    HostVisibleBuffer(const Environment& environment, const vk::DeviceSize size, const vk::BufferUsageFlags usage);
+    // preferredProperties are asked for on top of eHostVisible; without a memory type that has them the buffer falls
+    // back to host coherent memory. Readback buffers prefer eHostCached, since reading uncached memory is slow.
+    HostVisibleBuffer(const Environment& environment, const vk::DeviceSize size, const vk::BufferUsageFlags usage,
+        const vk::MemoryPropertyFlags preferredProperties = vk::MemoryPropertyFlagBits::eHostCoherent);
     ~HostVisibleBuffer() override;
 
     HostVisibleBuffer(const HostVisibleBuffer&) = delete;
@@ -21,6 +25,12 @@ public:
     HostVisibleBuffer& operator=(HostVisibleBuffer&& other) noexcept;
 
     void uploadData(const void* sourceData, const vk::DeviceSize dataSize) const override;
+    // Makes device writes visible to getMappedMemory; does nothing for host coherent memory.
+    void invalidate() const;
+    const void* getMappedMemory() const;
+
+private:
+    vk::MemoryPropertyFlags selectMemoryProperties(const vk::MemoryPropertyFlags preferredProperties) const;
 };
 
 
@@ -0,0 +1,74 @@
+#include "image_barrier.h"
+
+
+ImageBarrier::Scope ImageBarrier::getLayoutScope(const vk::ImageLayout layout)
+{
+    switch (layout)
+    {
+        case vk::ImageLayout::eUndefined:
+        case vk::ImageLayout::ePresentSrcKHR:
+            return { vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone };
+        case vk::ImageLayout::eGeneral:
+            return { vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite };
+        case vk::ImageLayout::eColorAttachmentOptimal:
+            return { vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite };
+        case vk::ImageLayout::eDepthStencilAttachmentOptimal:
+        case vk::ImageLayout::eDepthAttachmentOptimal:
+            return { vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests, vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite };
+        case vk::ImageLayout::eDepthStencilReadOnlyOptimal:
+        case vk::ImageLayout::eDepthReadOnlyOptimal:
+            return { vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead };
+        case vk::ImageLayout::eShaderReadOnlyOptimal:
+            return { vk::PipelineStageFlagBits2::eFragmentShader, vk::AccessFlagBits2::eShaderSampledRead };
+        case vk::ImageLayout::eTransferSrcOptimal:
+            return { vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferRead };
+        case vk::ImageLayout::eTransferDstOptimal:
+            return { vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite };
+        default: throw std::invalid_argument("Unsupported image layout.");
+    }
+}
+
+vk::ImageAspectFlags ImageBarrier::getAspectFlags(const vk::Format format)
+{
+    switch (format)
+    {
+        case vk::Format::eD16Unorm:
+        case vk::Format::eX8D24UnormPack32:
+        case vk::Format::eD32Sfloat:
+            return vk::ImageAspectFlagBits::eDepth;
+        case vk::Format::eD16UnormS8Uint:
+        case vk::Format::eD24UnormS8Uint:
+        case vk::Format::eD32SfloatS8Uint:
+            return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+        case vk::Format::eS8Uint:
+            return vk::ImageAspectFlagBits::eStencil;
+        default:
+            return vk::ImageAspectFlagBits::eColor;
+    }
+}
+
+vk::ImageMemoryBarrier2 ImageBarrier::create(const vk::Image image, const vk::ImageAspectFlags aspectFlags, const uint32_t layerCount,
+    const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout)
+{
+    const Scope sourceScope = getLayoutScope(oldLayout);
+    const Scope destinationScope = getLayoutScope(newLayout);
+
+    return vk::ImageMemoryBarrier2{
+        .srcStageMask = sourceScope.stageMask,
+        .srcAccessMask = sourceScope.accessMask,
+        .dstStageMask = destinationScope.stageMask,
+        .dstAccessMask = destinationScope.accessMask,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = vk::ImageSubresourceRange{
+            .aspectMask = aspectFlags,
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = layerCount
+        }
+    };
+}
@@ -0,0 +1,24 @@
+#ifndef IMAGE_BARRIER_H
+#define IMAGE_BARRIER_H
+
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <vulkan/vulkan_raii.hpp>
+
+
+class ImageBarrier {
+public:
+    struct Scope
+    {
+        vk::PipelineStageFlags2 stageMask;
+        vk::AccessFlags2 accessMask;
+    };
+
+    static Scope getLayoutScope(const vk::ImageLayout layout);
+    static vk::ImageAspectFlags getAspectFlags(const vk::Format format);
+    static vk::ImageMemoryBarrier2 create(const vk::Image image, const vk::ImageAspectFlags aspectFlags, const uint32_t layerCount,
+        const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout);
+};
+
+
+#endif //IMAGE_BARRIER_H
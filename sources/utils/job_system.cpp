@@ -0,0 +1,271 @@
+#include "job_system.h"
+
+
+#include "cpu_tracer.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+
+thread_local const JobSystem* JobSystem::currentSystem = nullptr;
+thread_local uint32_t JobSystem::currentWorker = 0;
+
+JobSystem::Counter::Counter() :
+    pendingCount(0),
+    mutex(),
+    continuations(),
+    exception()
+{
+}
+
+JobSystem::Counter::~Counter() = default;
+
+bool JobSystem::Counter::isDone() const
+{
+    return pendingCount.load(std::memory_order_acquire) == 0;
+}
+
+JobSystem::JobSystem(const uint32_t workerCount) :
+    queues(),
+    detachedCounter(),
+    queuedTaskCount(0),
+    nextQueue(0),
+    stopping(false),
+    workers()
+{
+    if (workerCount == 0)
+    {
+        throw std::invalid_argument("Job system needs at least one worker.");
+    }
+
+    queues.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        workers.emplace_back(&JobSystem::runWorker, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock(sleepMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::submit(Job job, Counter& counter)
+{
+    counter.pendingCount.fetch_add(1, std::memory_order_relaxed);
+    push({
+        .job = std::move(job),
+        .counter = &counter
+    });
+}
+
+void JobSystem::submitDetached(Job job)
+{
+    submit(std::move(job), detachedCounter);
+}
+
+void JobSystem::submitAfter(Counter& dependency, Job job, Counter& counter)
+{
+    counter.pendingCount.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        // Jobs of dependency finish under this mutex, so the continuation is either queued here or released by the last of them.
+        std::lock_guard lock(dependency.mutex);
+        if (!dependency.isDone())
+        {
+            dependency.continuations.push_back({
+                .job = std::move(job),
+                .counter = &counter
+            });
+            return;
+        }
+    }
+
+    push({
+        .job = std::move(job),
+        .counter = &counter
+    });
+}
+
+void JobSystem::wait(Counter& counter)
+{
+    while (!counter.isDone())
+    {
+        if (!runOneTask())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // The last job may still hold the mutex after counting down; taking it makes destroying the counter safe.
+    std::exception_ptr exception;
+    {
+        std::lock_guard lock(counter.mutex);
+        exception = std::exchange(counter.exception, nullptr);
+    }
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+void JobSystem::parallelFor(const size_t begin, const size_t end, const size_t grainSize, const std::function<void(size_t, size_t)>& function)
+{
+    Counter counter;
+    const size_t chunkSize = std::max<size_t>(grainSize, 1);
+    for (size_t first = begin; first < end; first += chunkSize)
+    {
+        const size_t last = std::min(first + chunkSize, end);
+        submit([&function, first, last] { function(first, last); }, counter);
+    }
+
+    wait(counter);
+}
+
+uint32_t JobSystem::getWorkerCount() const
+{
+    return workers.size();
+}
+
+void JobSystem::push(Task task)
+{
+    // Workers keep their own jobs local; other threads spread theirs round robin.
+    const uint32_t queueIndex = currentSystem == this ? currentWorker : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard lock(queues[queueIndex]->mutex);
+        queues[queueIndex]->tasks.push_back(std::move(task));
+        queuedTaskCount.fetch_add(1, std::memory_order_release);
+    }
+
+    {
+        std::lock_guard lock(sleepMutex);
+    }
+    wakeCondition.notify_one();
+}
+
+bool JobSystem::runOneTask()
+{
+    Task task;
+    if (!popTask(task))
+    {
+        return false;
+    }
+
+    runTask(task);
+    return true;
+}
+
+bool JobSystem::popTask(Task& task)
+{
+    if (queuedTaskCount.load(std::memory_order_acquire) == 0)
+    {
+        return false;
+    }
+
+    const bool isWorker = currentSystem == this;
+    const auto queueCount = static_cast<uint32_t>(queues.size());
+    const uint32_t first = isWorker ? currentWorker : 0;
+
+    for (uint32_t i = 0; i < queueCount; ++i)
+    {
+        WorkerQueue& queue = *queues[(first + i) % queueCount];
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty())
+        {
+            continue;
+        }
+
+        // The owner takes its newest job while it is still hot in cache; thieves take the oldest, which tends to be the largest.
+        if (isWorker and i == 0)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queuedTaskCount.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+
+void JobSystem::runTask(Task& task)
+{
+    try
+    {
+        task.job();
+    }
+    catch (...)
+    {
+        std::lock_guard lock(task.counter->mutex);
+        if (!task.counter->exception)
+        {
+            task.counter->exception = std::current_exception();
+        }
+    }
+
+    finishTask(*task.counter);
+}
+
+void JobSystem::finishTask(Counter& counter)
+{
+    std::vector<Counter::Continuation> continuations;
+    {
+        std::lock_guard lock(counter.mutex);
+        if (counter.pendingCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            continuations.swap(counter.continuations);
+        }
+    }
+
+    for (Counter::Continuation& continuation : continuations)
+    {
+        push({
+            .job = std::move(continuation.job),
+            .counter = continuation.counter
+        });
+    }
+}
+
+void JobSystem::runWorker(const uint32_t worker)
+{
+    currentSystem = this;
+    currentWorker = worker;
+    TRACE_THREAD_NAME("Job worker " + std::to_string(worker));
+
+    while (true)
+    {
+        if (runOneTask())
+        {
+            continue;
+        }
+
+        std::unique_lock lock(sleepMutex);
+        wakeCondition.wait(lock, [this] { return stopping or queuedTaskCount.load(std::memory_order_acquire) > 0; });
+        if (stopping and queuedTaskCount.load(std::memory_order_acquire) == 0)
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Work-stealing scheduler. Every worker owns a deque: it pushes and pops its own jobs at the back and steals from
+// the front of the others when it runs dry. Jobs report to a Counter, and a thread waiting on a counter runs queued
+// jobs meanwhile, so jobs may wait on jobs they spawn without tying up a worker.
+class JobSystem {
+public:
+    using Job = std::function<void()>;
+
+    // Number of unfinished jobs submitted against it. Holds the first exception those jobs throw until it is waited on.
+    class Counter {
+    public:
+        Counter();
+        ~Counter();
+
+        Counter(const Counter&) = delete;
+        Counter& operator=(const Counter&) = delete;
+
+        bool isDone() const;
+
+    private:
+        friend class JobSystem;
+
+        struct Continuation
+        {
+            Job job;
+            Counter* counter;
+        };
+
+        std::atomic<uint32_t> pendingCount;
+        std::mutex mutex;
+        std::vector<Continuation> continuations;
+        std::exception_ptr exception;
+    };
+
+private:
+    struct Task
+    {
+        Job job;
+        Counter* counter;
+    };
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    Counter detachedCounter;
+    std::atomic<uint32_t> queuedTaskCount;
+    std::atomic<uint32_t> nextQueue;
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    bool stopping;
+    std::vector<std::thread> workers;
+
+    static thread_local const JobSystem* currentSystem;
+    static thread_local uint32_t currentWorker;
+
+public:
+    explicit JobSystem(const uint32_t workerCount);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void submit(Job job, Counter& counter);
+    // Runs a job nobody waits for; it must handle its own exceptions.
+    void submitDetached(Job job);
+    // Queues job once every job submitted against dependency so far has finished.
+    void submitAfter(Counter& dependency, Job job, Counter& counter);
+    // Runs queued jobs until counter is done, then rethrows the first exception its jobs threw.
+    void wait(Counter& counter);
+    // Calls function(first, last) over [begin, end) in chunks of at most grainSize and waits for all of them.
+    void parallelFor(const size_t begin, const size_t end, const size_t grainSize, const std::function<void(size_t, size_t)>& function);
+    uint32_t getWorkerCount() const;
+
+    template<typename F>
+    auto async(F function) -> std::future<decltype(function())>
+    {
+        using Result = decltype(function());
+
+        // Jobs must be copyable, so the move-only task lives behind a shared pointer.
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(function));
+        std::future<Result> future = task->get_future();
+        submitDetached([task] { (*task)(); });
+
+        return future;
+    }
+
+private:
+    void push(Task task);
+    bool runOneTask();
+    bool popTask(Task& task);
+    void runTask(Task& task);
+    void finishTask(Counter& counter);
+    void runWorker(const uint32_t worker);
+};
+
+
+#endif //JOB_SYSTEM_H
@@ -0,0 +1,42 @@
+#include "orbit_camera.h"
+
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+OrbitCamera::OrbitCamera(const FrameScript::View& view) :
+    target(view.target),
+    yaw(std::atan2(view.eye.y - view.target.y, view.eye.x - view.target.x)),
+    pitch(std::clamp(std::asin((view.eye.z - view.target.z) / glm::length(view.eye - view.target)), -MaxPitch, MaxPitch)),
+    distance(std::clamp(glm::length(view.eye - view.target), MinDistance, MaxDistance))
+{
+    if (view.eye == view.target)
+    {
+        throw std::invalid_argument("An orbit camera needs an eye apart from its target.");
+    }
+}
+
+void OrbitCamera::orbit(const float yawDelta, const float pitchDelta)
+{
+    yaw = std::remainder(yaw + yawDelta, glm::two_pi<float>());
+    pitch = std::clamp(pitch + pitchDelta, -MaxPitch, MaxPitch);
+}
+
+void OrbitCamera::zoom(const float factor)
+{
+    distance = std::clamp(distance * factor, MinDistance, MaxDistance);
+}
+
+FrameScript::View OrbitCamera::getView() const
+{
+    const glm::vec3 direction(std::cos(pitch) * std::cos(yaw), std::cos(pitch) * std::sin(yaw), std::sin(pitch));
+
+    return {
+        .eye = target + distance * direction,
+        .target = target
+    };
+}
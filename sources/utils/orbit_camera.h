@@ -0,0 +1,37 @@
+#ifndef ORBIT_CAMERA_H
+#define ORBIT_CAMERA_H
+
+
+#include <glm/glm.hpp>
+
+#include "frame_script.h"
+
+
+// A camera circling a fixed target with z up, kept as yaw and pitch around the target and the distance to it. Plain
+// data, so the render thread can hand copies of it to the simulation.
+class OrbitCamera {
+public:
+    // Keeps the eye off the poles, where the z-up view would flip.
+    static constexpr float MaxPitch = 1.5f;
+    static constexpr float MinDistance = 0.5f;
+    // Inside the far plane of the renderer's camera.
+    static constexpr float MaxDistance = 8.0f;
+
+private:
+    glm::vec3 target;
+    float yaw;
+    float pitch;
+    float distance;
+
+public:
+    // Starts from the eye and target of view, clamped to the pitch and distance limits.
+    explicit OrbitCamera(const FrameScript::View& view);
+
+    void orbit(const float yawDelta, const float pitchDelta);
+    // Scales the distance to the target by factor.
+    void zoom(const float factor);
+    FrameScript::View getView() const;
+};
+
+
+#endif //ORBIT_CAMERA_H
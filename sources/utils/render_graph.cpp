@@ -0,0 +1,750 @@
+#include "render_graph.h"
+
+
+#include "image_barrier.h"
+#include "cpu_tracer.h"
+
+#include <algorithm>
+#include <numeric>
+
+
+RenderGraph::RenderGraph(const Environment& environment, const uint32_t maxFramesInFlight) :
+    environment(environment),
+    maxFramesInFlight(maxFramesInFlight),
+    resources(),
+    passes(),
+    accesses(),
+    transientCount(0),
+    plans(),
+    currentPlan(nullptr),
+    transientAllocation(),
+    retiredAllocations(),
+    transientGeneration(0),
+    recordingKey(0),
+    compileCount(0),
+    barrierScratch(),
+    frameArena(FrameArenaSize)
+{
+}
+
+RenderGraph::~RenderGraph() = default;
+
+void RenderGraph::reset()
+{
+    // Called once per frame, after the frame's fence has been waited on, so retired transients age by one frame.
+    for (RetiredAllocation& retiredAllocation : retiredAllocations)
+    {
+        --retiredAllocation.framesUntilRelease;
+    }
+    std::erase_if(retiredAllocations, [](const RetiredAllocation& retiredAllocation) { return retiredAllocation.framesUntilRelease == 0; });
+
+    resources.clear();
+    passes.clear();
+    accesses.clear();
+    transientCount = 0;
+    currentPlan = nullptr;
+    frameArena.reset();
+}
+
+RenderGraph::ResourceHandle RenderGraph::importImage(const ImportedImage& importedImage)
+{
+    resources.push_back({
+        .isTransient = false,
+        .transientIndex = 0,
+        .image = importedImage,
+        .description = {}
+    });
+
+    return static_cast<ResourceHandle>(resources.size() - 1);
+}
+
+RenderGraph::ResourceHandle RenderGraph::createTransientImage(const TransientImage& transientImage)
+{
+    resources.push_back({
+        .isTransient = true,
+        .transientIndex = transientCount++,
+        .image = {
+            .image = nullptr,
+            .imageView = nullptr,
+            .aspectFlags = ImageBarrier::getAspectFlags(transientImage.format),
+            .layerCount = transientImage.layerCount,
+            .initialLayout = vk::ImageLayout::eUndefined,
+            .initialStageMask = vk::PipelineStageFlagBits2::eNone,
+            .finalLayout = vk::ImageLayout::eUndefined
+        },
+        .description = transientImage
+    });
+
+    return static_cast<ResourceHandle>(resources.size() - 1);
+}
+
+RenderGraph::PassHandle RenderGraph::addPass(ExecuteFunction execute)
+{
+    passes.push_back(std::move(execute));
+
+    return static_cast<PassHandle>(passes.size() - 1);
+}
+
+void RenderGraph::read(const PassHandle pass, const ResourceHandle resource, const Access access)
+{
+    if (getAccessInfo(access).isWrite)
+    {
+        throw std::invalid_argument("Read declared with a write access.");
+    }
+
+    addAccess(pass, resource, access);
+}
+
+void RenderGraph::write(const PassHandle pass, const ResourceHandle resource, const Access access)
+{
+    if (!getAccessInfo(access).isWrite)
+    {
+        throw std::invalid_argument("Write declared with a read access.");
+    }
+
+    addAccess(pass, resource, access);
+}
+
+void RenderGraph::compile()
+{
+    TRACE_SCOPE("Compile render graph");
+
+    const uint64_t transientKey = hashTransients();
+    if (!transientAllocation.has_value() or transientAllocation->key != transientKey)
+    {
+        if (transientAllocation.has_value())
+        {
+            retiredAllocations.push_back({
+                .allocation = std::move(*transientAllocation),
+                .framesUntilRelease = maxFramesInFlight
+            });
+        }
+
+        // Resizing back and forth, as dragging a window edge does, finds earlier allocations still waiting for release.
+        const auto retiredAllocation = std::ranges::find_if(retiredAllocations, [&](const RetiredAllocation& retired) { return retired.allocation.key == transientKey; });
+        if (retiredAllocation != retiredAllocations.end())
+        {
+            transientAllocation.emplace(std::move(retiredAllocation->allocation));
+            retiredAllocations.erase(retiredAllocation);
+        }
+        else
+        {
+            transientAllocation.emplace(allocateTransients(transientKey));
+        }
+        ++transientGeneration;
+    }
+
+    for (Resource& resource : resources)
+    {
+        if (resource.isTransient)
+        {
+            const PhysicalImage& physicalImage = transientAllocation->images[resource.transientIndex];
+            resource.image.image = *physicalImage.image;
+            resource.image.imageView = *physicalImage.imageView;
+        }
+    }
+
+    const uint64_t key = hashDeclaration();
+    auto iterator = plans.find(key);
+    if (iterator == plans.end())
+    {
+        if (plans.size() >= MaxCachedPlans)
+        {
+            plans.clear();
+        }
+        iterator = plans.emplace(key, buildPlan()).first;
+        ++compileCount;
+    }
+
+    currentPlan = &iterator->second;
+    // A returning declaration may find its transients reallocated, so the key also covers the allocation.
+    recordingKey = key;
+    hashValue(recordingKey, transientGeneration);
+}
+
+void RenderGraph::execute(const vk::CommandBuffer& commandBuffer) const
+{
+    if (currentPlan == nullptr)
+    {
+        throw std::logic_error("Render graph was not compiled.");
+    }
+
+    for (uint32_t i = 0; i < passes.size(); ++i)
+    {
+        recordBarrierBatch(commandBuffer, i);
+        passes[i](commandBuffer);
+    }
+
+    recordBarrierBatch(commandBuffer, static_cast<uint32_t>(passes.size()));
+}
+
+vk::Image RenderGraph::getImage(const ResourceHandle resource) const
+{
+    return resources[resource].image.image;
+}
+
+vk::ImageView RenderGraph::getImageView(const ResourceHandle resource) const
+{
+    return resources[resource].image.imageView;
+}
+
+vk::DeviceSize RenderGraph::getTransientMemorySize() const
+{
+    return transientAllocation.has_value() ? transientAllocation->allocatedSize : 0;
+}
+
+vk::DeviceSize RenderGraph::getUnaliasedTransientMemorySize() const
+{
+    return transientAllocation.has_value() ? transientAllocation->requestedSize : 0;
+}
+
+vk::DeviceSize RenderGraph::getLazilyAllocatedTransientMemorySize() const
+{
+    return transientAllocation.has_value() ? transientAllocation->lazilyAllocatedSize : 0;
+}
+
+vk::DeviceSize RenderGraph::getSavedTransientMemorySize() const
+{
+    if (!transientAllocation.has_value())
+    {
+        return 0;
+    }
+
+    vk::DeviceSize savedSize = transientAllocation->lazilyAllocatedSize;
+    for (size_t i = 0; i < transientAllocation->memoryBlocks.size(); ++i)
+    {
+        if (transientAllocation->isLazilyAllocated[i])
+        {
+            savedSize -= transientAllocation->memoryBlocks[i].getMemory().getCommitment();
+        }
+    }
+
+    return savedSize;
+}
+
+uint32_t RenderGraph::getCompileCount() const
+{
+    return compileCount;
+}
+
+uint64_t RenderGraph::getRecordingKey() const
+{
+    return recordingKey;
+}
+
+void RenderGraph::addAccess(const PassHandle pass, const ResourceHandle resource, const Access access)
+{
+    if (pass >= passes.size() or resource >= resources.size())
+    {
+        throw std::out_of_range("Unknown render graph pass or resource.");
+    }
+
+    // All barriers before a pass go into one batch, in which two barriers on the same image would be unordered.
+    if (std::ranges::any_of(accesses, [&](const ResourceAccess& other) { return other.pass == pass and other.resource == resource; }))
+    {
+        throw std::invalid_argument("A pass may access a resource only once.");
+    }
+
+    accesses.push_back({
+        .pass = pass,
+        .resource = resource,
+        .access = access
+    });
+}
+
+uint64_t RenderGraph::hashDeclaration() const
+{
+    uint64_t hash = hashTransients();
+
+    for (const Resource& resource : resources)
+    {
+        hashValue(hash, resource.isTransient);
+        hashValue(hash, static_cast<VkImageAspectFlags>(resource.image.aspectFlags));
+        hashValue(hash, resource.image.layerCount);
+        hashValue(hash, resource.image.initialLayout);
+        hashValue(hash, static_cast<VkPipelineStageFlags2>(resource.image.initialStageMask));
+        hashValue(hash, resource.image.finalLayout);
+    }
+
+    hashValue(hash, static_cast<uint32_t>(passes.size()));
+    for (const ResourceAccess& access : accesses)
+    {
+        hashValue(hash, access.pass);
+        hashValue(hash, access.resource);
+        hashValue(hash, access.access);
+    }
+
+    return hash;
+}
+
+uint64_t RenderGraph::hashTransients() const
+{
+    uint64_t hash = 14695981039346656037ull;
+
+    for (const Resource& resource : resources)
+    {
+        if (!resource.isTransient)
+        {
+            continue;
+        }
+
+        hashValue(hash, resource.description.extent.width);
+        hashValue(hash, resource.description.extent.height);
+        hashValue(hash, resource.description.format);
+        hashValue(hash, static_cast<VkImageUsageFlags>(resource.description.usage));
+        hashValue(hash, resource.description.layerCount);
+    }
+
+    for (const auto& [firstPass, lastPass] : computeTransientLifetimes())
+    {
+        hashValue(hash, firstPass);
+        hashValue(hash, lastPass);
+    }
+
+    return hash;
+}
+
+std::pmr::vector<std::pair<uint32_t, uint32_t>> RenderGraph::computeTransientLifetimes() const
+{
+    // Hashing computes these on every compile, so they come from the frame arena rather than the heap.
+    std::pmr::vector<std::pair<uint32_t, uint32_t>> lifetimes(transientCount, { std::numeric_limits<uint32_t>::max(), 0 }, &frameArena.getResource());
+
+    for (const ResourceAccess& access : accesses)
+    {
+        const Resource& resource = resources[access.resource];
+        if (resource.isTransient)
+        {
+            auto& [firstPass, lastPass] = lifetimes[resource.transientIndex];
+            firstPass = std::min(firstPass, access.pass);
+            lastPass = std::max(lastPass, access.pass);
+        }
+    }
+
+    return lifetimes;
+}
+
+RenderGraph::TransientAllocation RenderGraph::allocateTransients(const uint64_t key) const
+{
+    struct MemorySlot
+    {
+        uint32_t lastPass;
+        vk::DeviceSize size;
+        vk::DeviceSize alignment;
+        uint32_t memoryTypeBits;
+        bool isLazilyAllocated;
+    };
+    struct MemoryPool
+    {
+        uint32_t memoryTypeIndex;
+        vk::DeviceSize size;
+        vk::DeviceSize alignment;
+        bool isLazilyAllocated;
+    };
+
+    const vk::raii::Device& device = environment.get().device;
+    const DeviceMemoryTracker& memoryTracker = environment.get().getMemoryTracker();
+    const std::pmr::vector<std::pair<uint32_t, uint32_t>> lifetimes = computeTransientLifetimes();
+    const bool lazyAllocationSupported = memoryTracker.hasMemoryType(~0u, LazilyAllocatedProperties);
+
+    std::vector<const Resource*> transients(transientCount);
+    for (const Resource& resource : resources)
+    {
+        if (resource.isTransient)
+        {
+            transients[resource.transientIndex] = &resource;
+        }
+    }
+
+    TransientAllocation allocation{
+        .key = key,
+        .memoryBlocks = {},
+        .isLazilyAllocated = {},
+        .images = {},
+        .memorySlots = std::vector<uint32_t>(transientCount),
+        .slotPlacements = {},
+        .allocatedSize = 0,
+        .requestedSize = 0,
+        .lazilyAllocatedSize = 0
+    };
+
+    std::vector<vk::MemoryRequirements> memoryRequirements;
+    std::vector<bool> lazyTransients;
+    allocation.images.reserve(transientCount);
+    for (uint32_t i = 0; i < transientCount; ++i)
+    {
+        const TransientImage& description = transients[i]->description;
+        const bool isPassLocal = lifetimes[i].first == lifetimes[i].second and !(description.usage & ~PassLocalUsage);
+        const bool isLazy = isPassLocal and lazyAllocationSupported;
+
+        const vk::ImageCreateInfo createInfo{
+            .imageType = vk::ImageType::e2D,
+            .format = description.format,
+            .extent = vk::Extent3D{ description.extent.width, description.extent.height, 1 },
+            .mipLevels = 1,
+            .arrayLayers = description.layerCount,
+            .samples = vk::SampleCountFlagBits::e1,
+            .tiling = vk::ImageTiling::eOptimal,
+            .usage = isLazy ? description.usage | vk::ImageUsageFlagBits::eTransientAttachment : description.usage,
+            .sharingMode = vk::SharingMode::eExclusive,
+            .queueFamilyIndexCount = 0,
+            .pQueueFamilyIndices = nullptr,
+            .initialLayout = vk::ImageLayout::eUndefined
+        };
+
+        allocation.images.push_back({
+            .image = device.createImage(createInfo),
+            .imageView = nullptr
+        });
+        memoryRequirements.push_back(allocation.images.back().image.getMemoryRequirements());
+        // A transient attachment may still be bound to ordinary memory if no lazily allocated type accepts the image.
+        lazyTransients.push_back(isLazy and memoryTracker.hasMemoryType(memoryRequirements.back().memoryTypeBits, LazilyAllocatedProperties));
+        allocation.requestedSize += memoryRequirements.back().size;
+    }
+
+    // Greedy interval assignment: a transient reuses the first slot whose previous occupant's last pass precedes its first pass.
+    std::vector<uint32_t> order(transientCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::sort(order, [&](const uint32_t a, const uint32_t b) { return lifetimes[a].first < lifetimes[b].first; });
+
+    std::vector<MemorySlot> memorySlots;
+    for (const uint32_t i : order)
+    {
+        const auto [firstPass, lastPass] = lifetimes[i];
+        const bool isUsed = firstPass <= lastPass;
+
+        auto slot = std::ranges::find_if(memorySlots, [&](const MemorySlot& memorySlot) {
+            return isUsed and memorySlot.lastPass < firstPass and memorySlot.isLazilyAllocated == lazyTransients[i] and
+                   (memorySlot.memoryTypeBits & memoryRequirements[i].memoryTypeBits) != 0;
+        });
+
+        if (slot == memorySlots.end())
+        {
+            memorySlots.push_back({
+                .lastPass = isUsed ? lastPass : std::numeric_limits<uint32_t>::max(),
+                .size = memoryRequirements[i].size,
+                .alignment = memoryRequirements[i].alignment,
+                .memoryTypeBits = memoryRequirements[i].memoryTypeBits,
+                .isLazilyAllocated = lazyTransients[i]
+            });
+            allocation.memorySlots[i] = static_cast<uint32_t>(memorySlots.size() - 1);
+        }
+        else
+        {
+            slot->lastPass = lastPass;
+            slot->size = std::max(slot->size, memoryRequirements[i].size);
+            slot->alignment = std::max(slot->alignment, memoryRequirements[i].alignment);
+            slot->memoryTypeBits &= memoryRequirements[i].memoryTypeBits;
+            allocation.memorySlots[i] = static_cast<uint32_t>(slot - memorySlots.begin());
+        }
+    }
+
+    // Slots of the same memory type share one allocation instead of one each.
+    std::vector<MemoryPool> memoryPools;
+    allocation.slotPlacements.reserve(memorySlots.size());
+    for (const MemorySlot& memorySlot : memorySlots)
+    {
+        const vk::MemoryPropertyFlags properties = memorySlot.isLazilyAllocated ? LazilyAllocatedProperties : vk::MemoryPropertyFlags(vk::MemoryPropertyFlagBits::eDeviceLocal);
+        const uint32_t memoryTypeIndex = memoryTracker.findMemoryType(memorySlot.memoryTypeBits, properties);
+
+        auto pool = std::ranges::find_if(memoryPools, [&](const MemoryPool& memoryPool) {
+            return memoryPool.memoryTypeIndex == memoryTypeIndex and memoryPool.isLazilyAllocated == memorySlot.isLazilyAllocated;
+        });
+        if (pool == memoryPools.end())
+        {
+            memoryPools.push_back({
+                .memoryTypeIndex = memoryTypeIndex,
+                .size = 0,
+                .alignment = 1,
+                .isLazilyAllocated = memorySlot.isLazilyAllocated
+            });
+            pool = memoryPools.end() - 1;
+        }
+
+        const vk::DeviceSize offset = (pool->size + memorySlot.alignment - 1) / memorySlot.alignment * memorySlot.alignment;
+        pool->size = offset + memorySlot.size;
+        pool->alignment = std::max(pool->alignment, memorySlot.alignment);
+        allocation.slotPlacements.push_back({
+            .memoryBlock = static_cast<uint32_t>(pool - memoryPools.begin()),
+            .offset = offset
+        });
+    }
+
+    allocation.memoryBlocks.reserve(memoryPools.size());
+    for (const MemoryPool& memoryPool : memoryPools)
+    {
+        const vk::MemoryRequirements poolRequirements{
+            .size = memoryPool.size,
+            .alignment = memoryPool.alignment,
+            .memoryTypeBits = 1u << memoryPool.memoryTypeIndex
+        };
+        const vk::MemoryPropertyFlags properties = memoryPool.isLazilyAllocated ? LazilyAllocatedProperties : vk::MemoryPropertyFlags(vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+        allocation.memoryBlocks.push_back(environment.get().allocateMemory(poolRequirements, properties, DeviceMemoryTracker::Category::Attachment));
+        allocation.isLazilyAllocated.push_back(memoryPool.isLazilyAllocated);
+        allocation.allocatedSize += memoryPool.size;
+        if (memoryPool.isLazilyAllocated)
+        {
+            allocation.lazilyAllocatedSize += memoryPool.size;
+        }
+    }
+
+    for (uint32_t i = 0; i < transientCount; ++i)
+    {
+        PhysicalImage& physicalImage = allocation.images[i];
+        const SlotPlacement& slotPlacement = allocation.slotPlacements[allocation.memorySlots[i]];
+        physicalImage.image.bindMemory(*allocation.memoryBlocks[slotPlacement.memoryBlock].getMemory(), slotPlacement.offset);
+
+        const vk::ImageAspectFlags aspectFlags = transients[i]->image.aspectFlags;
+        const vk::ImageViewCreateInfo createInfo{
+            .image = *physicalImage.image,
+            .viewType = transients[i]->description.layerCount > 1 ? vk::ImageViewType::e2DArray : vk::ImageViewType::e2D,
+            .format = transients[i]->description.format,
+            .components = {
+                .r = vk::ComponentSwizzle::eIdentity,
+                .g = vk::ComponentSwizzle::eIdentity,
+                .b = vk::ComponentSwizzle::eIdentity,
+                .a = vk::ComponentSwizzle::eIdentity
+            },
+            .subresourceRange = {
+                .aspectMask = aspectFlags & vk::ImageAspectFlagBits::eDepth ? vk::ImageAspectFlags(vk::ImageAspectFlagBits::eDepth) : aspectFlags,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = transients[i]->description.layerCount
+            }
+        };
+
+        physicalImage.imageView = device.createImageView(createInfo);
+    }
+
+    return allocation;
+}
+
+RenderGraph::Plan RenderGraph::buildPlan() const
+{
+    struct ResourceState
+    {
+        vk::ImageLayout layout;
+        vk::PipelineStageFlags2 stageMask;
+        vk::AccessFlags2 accessMask;
+        bool isWritten;
+        bool isTouched;
+    };
+
+    const std::vector<uint32_t>& memorySlots = transientAllocation->memorySlots;
+    const size_t memorySlotCount = transientAllocation->slotPlacements.size();
+
+    // Aliased transients hand their memory over in slot order, and the last occupant of a slot hands it to the first one of the next frame.
+    std::vector<ImageBarrier::Scope> slotEndScopes(memorySlotCount, { vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone });
+
+    Plan plan;
+    for (uint32_t iteration = 0; iteration < 2; ++iteration)
+    {
+        const bool emit = iteration == 1;
+        std::vector<ImageBarrier::Scope> slotScopes = slotEndScopes;
+
+        std::vector<ResourceState> states;
+        states.reserve(resources.size());
+        for (const Resource& resource : resources)
+        {
+            states.push_back({
+                .layout = resource.image.initialLayout,
+                .stageMask = resource.image.initialStageMask,
+                .accessMask = vk::AccessFlagBits2::eNone,
+                .isWritten = false,
+                .isTouched = false
+            });
+        }
+
+        plan.barriers.clear();
+        plan.batchOffsets.clear();
+
+        for (uint32_t pass = 0; pass < passes.size(); ++pass)
+        {
+            plan.batchOffsets.push_back(static_cast<uint32_t>(plan.barriers.size()));
+
+            for (const ResourceAccess& access : accesses)
+            {
+                if (access.pass != pass)
+                {
+                    continue;
+                }
+
+                const Resource& resource = resources[access.resource];
+                const AccessInfo accessInfo = getAccessInfo(access.access);
+                ResourceState& state = states[access.resource];
+
+                if (resource.isTransient and !state.isTouched)
+                {
+                    const ImageBarrier::Scope& slotScope = slotScopes[memorySlots[resource.transientIndex]];
+                    plan.barriers.push_back({
+                        .resource = access.resource,
+                        .srcStageMask = slotScope.stageMask,
+                        .srcAccessMask = slotScope.accessMask,
+                        .dstStageMask = accessInfo.stageMask,
+                        .dstAccessMask = accessInfo.accessMask,
+                        .oldLayout = vk::ImageLayout::eUndefined,
+                        .newLayout = accessInfo.layout
+                    });
+                    state = { accessInfo.layout, accessInfo.stageMask, accessInfo.accessMask, accessInfo.isWrite, true };
+                }
+                else if (state.layout != accessInfo.layout or state.isWritten or accessInfo.isWrite)
+                {
+                    plan.barriers.push_back({
+                        .resource = access.resource,
+                        .srcStageMask = state.stageMask,
+                        .srcAccessMask = state.isWritten ? state.accessMask : vk::AccessFlagBits2::eNone,
+                        .dstStageMask = accessInfo.stageMask,
+                        .dstAccessMask = accessInfo.accessMask,
+                        .oldLayout = state.layout,
+                        .newLayout = accessInfo.layout
+                    });
+                    state = { accessInfo.layout, accessInfo.stageMask, accessInfo.accessMask, accessInfo.isWrite, true };
+                }
+                else
+                {
+                    // Reads in the same layout need no barrier, but a later writer must wait for all of them.
+                    state.stageMask |= accessInfo.stageMask;
+                    state.accessMask |= accessInfo.accessMask;
+                    state.isTouched = true;
+                }
+
+                if (resource.isTransient)
+                {
+                    slotScopes[memorySlots[resource.transientIndex]] = {
+                        state.stageMask,
+                        state.isWritten ? state.accessMask : vk::AccessFlagBits2::eNone
+                    };
+                }
+            }
+        }
+
+        plan.batchOffsets.push_back(static_cast<uint32_t>(plan.barriers.size()));
+
+        for (uint32_t i = 0; i < resources.size(); ++i)
+        {
+            const Resource& resource = resources[i];
+            const ResourceState& state = states[i];
+            if (resource.isTransient or resource.image.finalLayout == vk::ImageLayout::eUndefined)
+            {
+                continue;
+            }
+
+            if (state.layout != resource.image.finalLayout or state.isWritten)
+            {
+                const ImageBarrier::Scope finalScope = ImageBarrier::getLayoutScope(resource.image.finalLayout);
+                plan.barriers.push_back({
+                    .resource = i,
+                    .srcStageMask = state.stageMask,
+                    .srcAccessMask = state.isWritten ? state.accessMask : vk::AccessFlagBits2::eNone,
+                    .dstStageMask = finalScope.stageMask,
+                    .dstAccessMask = finalScope.accessMask,
+                    .oldLayout = state.layout,
+                    .newLayout = resource.image.finalLayout
+                });
+            }
+        }
+
+        plan.batchOffsets.push_back(static_cast<uint32_t>(plan.barriers.size()));
+
+        if (!emit)
+        {
+            slotEndScopes = slotScopes;
+        }
+    }
+
+    return plan;
+}
+
+void RenderGraph::recordBarrierBatch(const vk::CommandBuffer& commandBuffer, const uint32_t batchIndex) const
+{
+    const uint32_t first = currentPlan->batchOffsets[batchIndex];
+    const uint32_t last = currentPlan->batchOffsets[batchIndex + 1];
+    if (first == last)
+    {
+        return;
+    }
+
+    barrierScratch.clear();
+    for (uint32_t i = first; i < last; ++i)
+    {
+        const Barrier& barrier = currentPlan->barriers[i];
+        const Resource& resource = resources[barrier.resource];
+
+        barrierScratch.push_back(vk::ImageMemoryBarrier2{
+            .srcStageMask = barrier.srcStageMask,
+            .srcAccessMask = barrier.srcAccessMask,
+            .dstStageMask = barrier.dstStageMask,
+            .dstAccessMask = barrier.dstAccessMask,
+            .oldLayout = barrier.oldLayout,
+            .newLayout = barrier.newLayout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = resource.image.image,
+            .subresourceRange = vk::ImageSubresourceRange{
+                .aspectMask = resource.image.aspectFlags,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = resource.image.layerCount
+            }
+        });
+    }
+
+    const vk::DependencyInfo dependencyInfo{
+        .imageMemoryBarrierCount = static_cast<uint32_t>(barrierScratch.size()),
+        .pImageMemoryBarriers = barrierScratch.data()
+    };
+
+    commandBuffer.pipelineBarrier2(dependencyInfo);
+}
+
+RenderGraph::AccessInfo RenderGraph::getAccessInfo(const Access access)
+{
+    switch (access)
+    {
+        case Access::ColorAttachmentWrite:
+            return {
+                vk::ImageLayout::eColorAttachmentOptimal,
+                vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+                vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite,
+                true
+            };
+        case Access::DepthAttachmentWrite:
+            return {
+                vk::ImageLayout::eDepthStencilAttachmentOptimal,
+                vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+                vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+                true
+            };
+        case Access::DepthSampledRead:
+            return {
+                vk::ImageLayout::eDepthStencilReadOnlyOptimal,
+                vk::PipelineStageFlagBits2::eFragmentShader,
+                vk::AccessFlagBits2::eShaderSampledRead,
+                false
+            };
+        case Access::SampledRead:
+            return {
+                vk::ImageLayout::eShaderReadOnlyOptimal,
+                vk::PipelineStageFlagBits2::eFragmentShader,
+                vk::AccessFlagBits2::eShaderSampledRead,
+                false
+            };
+        case Access::TransferRead:
+            return {
+                vk::ImageLayout::eTransferSrcOptimal,
+                vk::PipelineStageFlagBits2::eTransfer,
+                vk::AccessFlagBits2::eTransferRead,
+                false
+            };
+        case Access::TransferWrite:
+            return {
+                vk::ImageLayout::eTransferDstOptimal,
+                vk::PipelineStageFlagBits2::eTransfer,
+                vk::AccessFlagBits2::eTransferWrite,
+                true
+            };
+        default: throw std::invalid_argument("Unsupported render graph access.");
+    }
+}
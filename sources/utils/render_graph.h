@@ -0,0 +1,192 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <vulkan/vulkan_raii.hpp>
+
+#include <functional>
+#include <memory_resource>
+#include <unordered_map>
+
+#include "environment.h"
+#include "frame_arena.h"
+
+
+class RenderGraph {
+public:
+    using ResourceHandle = uint32_t;
+    using PassHandle = uint32_t;
+    using ExecuteFunction = std::function<void(const vk::CommandBuffer&)>;
+
+    enum class Access
+    {
+        ColorAttachmentWrite,
+        DepthAttachmentWrite,
+        DepthSampledRead,
+        SampledRead,
+        TransferRead,
+        TransferWrite
+    };
+
+    struct ImportedImage
+    {
+        vk::Image image;
+        vk::ImageView imageView;
+        vk::ImageAspectFlags aspectFlags;
+        uint32_t layerCount;
+        vk::ImageLayout initialLayout;
+        vk::PipelineStageFlags2 initialStageMask;
+        vk::ImageLayout finalLayout;
+    };
+    struct TransientImage
+    {
+        vk::Extent2D extent;
+        vk::Format format;
+        vk::ImageUsageFlags usage;
+        uint32_t layerCount;
+    };
+
+private:
+    struct Resource
+    {
+        bool isTransient;
+        uint32_t transientIndex;
+        ImportedImage image;
+        TransientImage description;
+    };
+    struct ResourceAccess
+    {
+        PassHandle pass;
+        ResourceHandle resource;
+        Access access;
+    };
+    struct AccessInfo
+    {
+        vk::ImageLayout layout;
+        vk::PipelineStageFlags2 stageMask;
+        vk::AccessFlags2 accessMask;
+        bool isWrite;
+    };
+    struct Barrier
+    {
+        ResourceHandle resource;
+        vk::PipelineStageFlags2 srcStageMask;
+        vk::AccessFlags2 srcAccessMask;
+        vk::PipelineStageFlags2 dstStageMask;
+        vk::AccessFlags2 dstAccessMask;
+        vk::ImageLayout oldLayout;
+        vk::ImageLayout newLayout;
+    };
+    struct Plan
+    {
+        std::vector<Barrier> barriers;
+        std::vector<uint32_t> batchOffsets;
+    };
+    struct PhysicalImage
+    {
+        vk::raii::Image image;
+        vk::raii::ImageView imageView;
+    };
+    struct SlotPlacement
+    {
+        uint32_t memoryBlock;
+        vk::DeviceSize offset;
+    };
+    struct TransientAllocation
+    {
+        uint64_t key;
+        // One pooled allocation per memory type, holding the memory slots of that type at aligned offsets.
+        std::vector<DeviceMemoryTracker::Allocation> memoryBlocks;
+        std::vector<bool> isLazilyAllocated;
+        std::vector<PhysicalImage> images;
+        std::vector<uint32_t> memorySlots;
+        std::vector<SlotPlacement> slotPlacements;
+        vk::DeviceSize allocatedSize;
+        vk::DeviceSize requestedSize;
+        vk::DeviceSize lazilyAllocatedSize;
+    };
+    struct RetiredAllocation
+    {
+        TransientAllocation allocation;
+        uint32_t framesUntilRelease;
+    };
+
+    static constexpr uint32_t MaxCachedPlans = 8;
+    // Transients with no other usage and a single pass never leave it, so tile-based GPUs can keep them on chip.
+    static constexpr vk::ImageUsageFlags PassLocalUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment |
+                                                          vk::ImageUsageFlagBits::eInputAttachment;
+    static constexpr vk::MemoryPropertyFlags LazilyAllocatedProperties = vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eLazilyAllocated;
+    static constexpr size_t FrameArenaSize = 16 * 1024;
+
+    std::reference_wrapper<const Environment> environment;
+    const uint32_t maxFramesInFlight;
+    std::vector<Resource> resources;
+    std::vector<ExecuteFunction> passes;
+    std::vector<ResourceAccess> accesses;
+    uint32_t transientCount;
+    std::unordered_map<uint64_t, Plan> plans;
+    const Plan* currentPlan;
+    std::optional<TransientAllocation> transientAllocation;
+    std::vector<RetiredAllocation> retiredAllocations;
+    uint64_t transientGeneration;
+    uint64_t recordingKey;
+    uint32_t compileCount;
+    mutable std::vector<vk::ImageMemoryBarrier2> barrierScratch;
+    // Scratch data of the frame being declared; released by reset.
+    mutable FrameArena frameArena;
+
+public:
+    RenderGraph(const Environment& environment, const uint32_t maxFramesInFlight);
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    void reset();
+    ResourceHandle importImage(const ImportedImage& importedImage);
+    ResourceHandle createTransientImage(const TransientImage& transientImage);
+    PassHandle addPass(ExecuteFunction execute);
+    void read(const PassHandle pass, const ResourceHandle resource, const Access access);
+    void write(const PassHandle pass, const ResourceHandle resource, const Access access);
+    void compile();
+    void execute(const vk::CommandBuffer& commandBuffer) const;
+
+    vk::Image getImage(const ResourceHandle resource) const;
+    vk::ImageView getImageView(const ResourceHandle resource) const;
+    vk::DeviceSize getTransientMemorySize() const;
+    vk::DeviceSize getUnaliasedTransientMemorySize() const;
+    // Part of the transient memory in lazily allocated memory, which the device only backs as far as it has to.
+    vk::DeviceSize getLazilyAllocatedTransientMemorySize() const;
+    // Lazily allocated transient memory the device has not committed, queried from the driver.
+    vk::DeviceSize getSavedTransientMemorySize() const;
+    uint32_t getCompileCount() const;
+    // Identifies the barriers and transient images that execute records; imported images and pass contents are up to the caller.
+    uint64_t getRecordingKey() const;
+
+private:
+    void addAccess(const PassHandle pass, const ResourceHandle resource, const Access access);
+    uint64_t hashDeclaration() const;
+    uint64_t hashTransients() const;
+    std::pmr::vector<std::pair<uint32_t, uint32_t>> computeTransientLifetimes() const;
+    TransientAllocation allocateTransients(const uint64_t key) const;
+    Plan buildPlan() const;
+    void recordBarrierBatch(const vk::CommandBuffer& commandBuffer, const uint32_t batchIndex) const;
+
+    static AccessInfo getAccessInfo(const Access access);
+    template<typename T>
+    static void hashValue(uint64_t& hash, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    }
+};
+
+
+#endif //RENDER_GRAPH_H
@@ -2,15 +2,15 @@
 
 
 #include "../vertex.h"
+#include "cpu_tracer.h"
 
 #include <fstream>
 
 
-RenderPipeline::RenderPipeline(const Environment& environment) :
+RenderPipeline::RenderPipeline(const Environment& environment, const vk::raii::DescriptorSetLayout& materialDescriptorSetLayout, const uint32_t viewMask) :
     descriptorSetLayout(createDescriptorSetLayout(environment)),
-    pipelineLayout(createPipelineLayout(environment)),
-    renderPass(createRenderPass(environment)),
-    pipeline(createGraphicsPipeline(environment))
+    pipelineLayout(createPipelineLayout(environment, materialDescriptorSetLayout)),
+    pipeline(createGraphicsPipeline(environment, viewMask))
 {
 }
 
@@ -22,17 +22,17 @@ vk::raii::DescriptorSetLayout RenderPipeline::createDescriptorSetLayout(const En
         .binding = 0,
         .descriptorType = vk::DescriptorType::eUniformBuffer,
         .descriptorCount = 1,
-        .stageFlags = vk::ShaderStageFlagBits::eVertex,
+        .stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
         .pImmutableSamplers = nullptr
     };
-    constexpr vk::DescriptorSetLayoutBinding samplerLayoutBinding{
+    constexpr vk::DescriptorSetLayoutBinding shadowMapLayoutBinding{
         .binding = 1,
         .descriptorType = vk::DescriptorType::eCombinedImageSampler,
         .descriptorCount = 1,
         .stageFlags = vk::ShaderStageFlagBits::eFragment,
         .pImmutableSamplers = nullptr
     };
-    constexpr std::array<vk::DescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
+    constexpr std::array<vk::DescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, shadowMapLayoutBinding };
 
     const vk::DescriptorSetLayoutCreateInfo createInfo{
         .bindingCount = static_cast<uint32_t>(bindings.size()),
@@ -42,87 +42,29 @@ vk::raii::DescriptorSetLayout RenderPipeline::createDescriptorSetLayout(const En
     return environment.device.createDescriptorSetLayout(createInfo);
 }
 
-vk::raii::PipelineLayout RenderPipeline::createPipelineLayout(const Environment& environment) const
+vk::raii::PipelineLayout RenderPipeline::createPipelineLayout(const Environment& environment, const vk::raii::DescriptorSetLayout& materialDescriptorSetLayout) const
 {
+    constexpr vk::PushConstantRange pushConstantRange{
+        .stageFlags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
+        .offset = 0,
+        .size = sizeof(PushConstants)
+    };
+
+    const std::array<vk::DescriptorSetLayout, 2> setLayouts = { *descriptorSetLayout, *materialDescriptorSetLayout };
     const vk::PipelineLayoutCreateInfo createInfo{
-        .setLayoutCount = 1,
-        .pSetLayouts = &*descriptorSetLayout,
-        .pushConstantRangeCount = 0,
-        .pPushConstantRanges = nullptr
+        .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+        .pSetLayouts = setLayouts.data(),
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange
     };
 
     return environment.device.createPipelineLayout(createInfo);
 }
 
-vk::raii::RenderPass RenderPipeline::createRenderPass(const Environment& environment)
+vk::raii::Pipeline RenderPipeline::createGraphicsPipeline(const Environment& environment, const uint32_t viewMask) const
 {
-    const vk::AttachmentDescription colorAttachmentDescription{
-        .format = environment.swapchainSurfaceFormat.format,
-        .samples = vk::SampleCountFlagBits::e1,
-        .loadOp = vk::AttachmentLoadOp::eClear,
-        .storeOp = vk::AttachmentStoreOp::eStore,
-        .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
-        .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
-        .initialLayout = vk::ImageLayout::eUndefined,
-        .finalLayout = vk::ImageLayout::ePresentSrcKHR
-    };
-    const vk::AttachmentDescription depthAttachmentDescription{
-        .format = environment.depthFormat,
-        .samples = vk::SampleCountFlagBits::e1,
-        .loadOp = vk::AttachmentLoadOp::eClear,
-        .storeOp = vk::AttachmentStoreOp::eDontCare,
-        .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
-        .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
-        .initialLayout = vk::ImageLayout::eUndefined,
-        .finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal
-    };
-    const std::array<vk::AttachmentDescription, 2> attachments = { colorAttachmentDescription, depthAttachmentDescription };
-
-    constexpr vk::AttachmentReference colorAttachmentReference{
-        .attachment = 0,
-        .layout = vk::ImageLayout::eColorAttachmentOptimal
-    };
-
-    constexpr vk::AttachmentReference depthAttachmentReference{
-        .attachment = 1,
-        .layout = vk::ImageLayout::eDepthStencilAttachmentOptimal
-    };
-
-    const vk::SubpassDescription subpassDescription{
-        .pipelineBindPoint = vk::PipelineBindPoint::eGraphics,
-        .inputAttachmentCount = 0,
-        .pInputAttachments = nullptr,
-        .colorAttachmentCount = 1,
-        .pColorAttachments = &colorAttachmentReference,
-        .pResolveAttachments = nullptr,
-        .pDepthStencilAttachment = &depthAttachmentReference,
-        .preserveAttachmentCount = 0,
-        .pPreserveAttachments = nullptr
-    };
+    TRACE_SCOPE("Create render pipeline");
 
-    constexpr vk::SubpassDependency subpassDependency{
-        .srcSubpass = vk::SubpassExternal,
-        .dstSubpass = 0,
-        .srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests,
-        .dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests,
-        .srcAccessMask = {},
-        .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite
-    };
-
-    const vk::RenderPassCreateInfo createInfo{
-        .attachmentCount = static_cast<uint32_t>(attachments.size()),
-        .pAttachments = attachments.data(),
-        .subpassCount = 1,
-        .pSubpasses = &subpassDescription,
-        .dependencyCount = 1,
-        .pDependencies = &subpassDependency
-    };
-
-    return environment.device.createRenderPass(createInfo);
-}
-
-vk::raii::Pipeline RenderPipeline::createGraphicsPipeline(const Environment& environment) const
-{
     const vk::raii::ShaderModule vertexShaderModule = createShaderModule(environment.device, readFile(ShaderPath + VertexShaderFilename));
     const vk::PipelineShaderStageCreateInfo vertexShaderStageCreateInfo{
         .stage = vk::ShaderStageFlagBits::eVertex,
@@ -219,7 +161,16 @@ vk::raii::Pipeline RenderPipeline::createGraphicsPipeline(const Environment& env
         .pDynamicStates = dynamicStates.data()
     };
 
+    const vk::PipelineRenderingCreateInfo renderingCreateInfo{
+        .viewMask = viewMask,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &environment.swapchainSurfaceFormat.format,
+        .depthAttachmentFormat = environment.depthFormat,
+        .stencilAttachmentFormat = vk::Format::eUndefined
+    };
+
     const vk::GraphicsPipelineCreateInfo createInfo{
+        .pNext = &renderingCreateInfo,
         .stageCount = static_cast<uint32_t>(shaderStageCreateInfos.size()),
         .pStages = shaderStageCreateInfos.data(),
         .pVertexInputState = &vertexInputStateCreateInfo,
@@ -232,7 +183,7 @@ vk::raii::Pipeline RenderPipeline::createGraphicsPipeline(const Environment& env
         .pColorBlendState = &colorBlendStateCreateInfo,
         .pDynamicState = &dynamicStateCreateInfo,
         .layout = *pipelineLayout,
-        .renderPass = *renderPass,
+        .renderPass = nullptr,
         .subpass = 0,
         .basePipelineHandle = nullptr,
         .basePipelineIndex = -1
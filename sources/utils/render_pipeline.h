@@ -2,32 +2,41 @@
 #define RENDER_PIPELINE_H
 
 
+#include <glm/glm.hpp>
+
 #include "environment.h"
 
 
 class RenderPipeline {
 private:
-    static constexpr std::string ShaderPath = "../shaders/";
+    static constexpr std::string ShaderPath = MY_RENDERER_SHADER_DIRECTORY;
 
     static constexpr std::string VertexShaderFilename = "vertex.spv";
     static constexpr std::string FragmentShaderFilename = "fragment.spv";
 
 public:
+    struct PushConstants
+    {
+        alignas(16) glm::mat4 model;
+        alignas(16) glm::vec4 baseColor;
+    };
+
     const vk::raii::DescriptorSetLayout descriptorSetLayout;
     const vk::raii::PipelineLayout pipelineLayout;
-    const vk::raii::RenderPass renderPass;
     const vk::raii::Pipeline pipeline;
 
 public:
-    explicit RenderPipeline(const Environment& environment);
+    // Set 0 holds per-frame resources and set 1 the material. A non-zero viewMask renders one multiview view per
+    // set bit into layered attachments.
+    RenderPipeline(const Environment& environment, const vk::raii::DescriptorSetLayout& materialDescriptorSetLayout, const uint32_t viewMask = 0);
     ~RenderPipeline();
 
 private:
     static vk::raii::DescriptorSetLayout createDescriptorSetLayout(const Environment& environment);
-    vk::raii::PipelineLayout createPipelineLayout(const Environment& environment) const;
-    static vk::raii::RenderPass createRenderPass(const Environment& environment);
-    vk::raii::Pipeline createGraphicsPipeline(const Environment& environment) const;
+    vk::raii::PipelineLayout createPipelineLayout(const Environment& environment, const vk::raii::DescriptorSetLayout& materialDescriptorSetLayout) const;
+    vk::raii::Pipeline createGraphicsPipeline(const Environment& environment, const uint32_t viewMask) const;
 
+public:
     static vk::raii::ShaderModule createShaderModule(const vk::raii::Device& device, const std::vector<char>& code);
     static std::vector<char> readFile(const std::string& filename);
 };
@@ -0,0 +1,77 @@
+#include "resolution_controller.h"
+
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+ResolutionController::ResolutionController(const float targetFrameTime) :
+    targetFrameTime(targetFrameTime),
+    smoothedFrameTime(0.0f),
+    scale(MaxScale),
+    framesUntilSettled(0),
+    scaleChangeCount(0)
+{
+    if (!(targetFrameTime > 0.0f))
+    {
+        throw std::invalid_argument("Dynamic resolution needs a positive frame time target.");
+    }
+}
+
+bool ResolutionController::update(const float gpuFrameTime)
+{
+    if (framesUntilSettled > 0)
+    {
+        --framesUntilSettled;
+        return false;
+    }
+
+    smoothedFrameTime = smoothedFrameTime == 0.0f ? gpuFrameTime : smoothedFrameTime + SmoothingFactor * (gpuFrameTime - smoothedFrameTime);
+    if (smoothedFrameTime <= 0.0f)
+    {
+        return false;
+    }
+
+    const float idealScale = scale * std::sqrt(targetFrameTime / smoothedFrameTime);
+    const float nextScale = std::clamp(std::round((scale + Gain * (idealScale - scale)) / ScaleStep) * ScaleStep, MinScale, MaxScale);
+    if (std::abs(nextScale - scale) < 0.5f * ScaleStep)
+    {
+        return false;
+    }
+
+    scale = nextScale;
+    // The average restarts from the first frame drawn at the new scale.
+    smoothedFrameTime = 0.0f;
+    framesUntilSettled = SettleFrameCount;
+    ++scaleChangeCount;
+    return true;
+}
+
+float ResolutionController::getTargetFrameTime() const
+{
+    return targetFrameTime;
+}
+
+float ResolutionController::getSmoothedFrameTime() const
+{
+    return smoothedFrameTime;
+}
+
+float ResolutionController::getScale() const
+{
+    return scale;
+}
+
+uint64_t ResolutionController::getScaleChangeCount() const
+{
+    return scaleChangeCount;
+}
+
+vk::Extent2D ResolutionController::getRenderExtent(const vk::Extent2D outputExtent) const
+{
+    return {
+        .width = std::max(1u, static_cast<uint32_t>(std::lround(outputExtent.width * scale))),
+        .height = std::max(1u, static_cast<uint32_t>(std::lround(outputExtent.height * scale)))
+    };
+}
@@ -0,0 +1,49 @@
+#ifndef RESOLUTION_CONTROLLER_H
+#define RESOLUTION_CONTROLLER_H
+
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <vulkan/vulkan_raii.hpp>
+
+#include <cstdint>
+
+
+// Feedback controller for dynamic resolution. GPU frame time is taken to grow with the pixel count, so the scale that
+// would meet the target is the current one times the square root of target over the smoothed frame time; each frame
+// moves part of the way there. The scale snaps to steps of ScaleStep and holds for a few frames after a change, so
+// frame time noise neither re-records command buffers every frame nor reacts to frames still drawn at the old scale.
+class ResolutionController {
+public:
+    static constexpr float MinScale = 0.5f;
+    static constexpr float MaxScale = 1.0f;
+    static constexpr float ScaleStep = 0.05f;
+    static constexpr float Gain = 0.5f;
+    // Weight of the newest frame time in the exponential moving average.
+    static constexpr float SmoothingFactor = 0.1f;
+    // Frames ignored after a change: those in flight were recorded at the previous scale.
+    static constexpr uint32_t SettleFrameCount = 8;
+
+private:
+    float targetFrameTime;
+    float smoothedFrameTime;
+    float scale;
+    uint32_t framesUntilSettled;
+    uint64_t scaleChangeCount;
+
+public:
+    // targetFrameTime is the GPU time budget per frame in milliseconds.
+    explicit ResolutionController(const float targetFrameTime);
+
+    // Feeds the GPU time of a finished frame in milliseconds and returns whether the scale changed.
+    bool update(const float gpuFrameTime);
+
+    float getTargetFrameTime() const;
+    float getSmoothedFrameTime() const;
+    float getScale() const;
+    uint64_t getScaleChangeCount() const;
+    // outputExtent scaled down and rounded, at least one pixel on each side.
+    vk::Extent2D getRenderExtent(const vk::Extent2D outputExtent) const;
+};
+
+
+#endif //RESOLUTION_CONTROLLER_H
@@ -0,0 +1,779 @@
+#include "scene.h"
+
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include "host_visible_buffer.h"
+#include "cpu_tracer.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+
+Scene::Scene(const Environment& environment, AssetStreamer& streamer, JobSystem& jobSystem, SceneManifest manifest) :
+    environment(environment),
+    streamer(streamer),
+    jobSystem(jobSystem),
+    manifest(std::move(manifest)),
+    materialDescriptorSetLayout(createMaterialDescriptorSetLayout(environment)),
+    descriptorPool(createDescriptorPool()),
+    sampler(createSampler()),
+    fallbackTexture(createFallbackTexture()),
+    fallbackDescriptorSet(createMaterialDescriptorSet(fallbackTexture)),
+    geometryHeap(environment),
+    cache(),
+    meshSlots(this->manifest.getMeshPaths().size(), AssetSlot{ .key = std::nullopt, .boundingSphere = std::nullopt, .loading = false, .requested = false, .failed = false }),
+    textureSlots(this->manifest.getTexturePaths().size(), AssetSlot{ .key = std::nullopt, .boundingSphere = std::nullopt, .loading = false, .requested = false, .failed = false }),
+    queuedLoads(createLoadQueue(this->manifest)),
+    contentReads(),
+    meshUploads(),
+    textureUploads(),
+    geometryRelocation(),
+    assetCount(static_cast<uint32_t>(queuedLoads.size())),
+    failedAssetCount(0)
+{
+    for (const AssetLoad load : queuedLoads)
+    {
+        getSlot(load).loading = true;
+    }
+
+    startLoads();
+}
+
+Scene::~Scene()
+{
+    queuedLoads.clear();
+    while (!contentReads.empty() or !meshUploads.empty() or !textureUploads.empty() or geometryRelocation.has_value())
+    {
+        streamer.get().poll();
+        std::erase_if(contentReads, [](const ContentRead& read) { return read.task.ready(); });
+        std::erase_if(meshUploads, [](const MeshUpload& upload) { return upload.task.ready(); });
+        std::erase_if(textureUploads, [](const TextureUpload& upload) { return upload.task.ready(); });
+        if (geometryRelocation.has_value() and geometryRelocation->task.ready())
+        {
+            geometryRelocation.reset();
+        }
+        std::this_thread::yield();
+    }
+}
+
+bool Scene::poll(const uint64_t frameCount, const uint64_t completedFrameCount)
+{
+    const auto reportFailure = [this](const AssetLoad load, const std::exception& exception)
+    {
+        const std::string& path = load.kind == AssetKind::Mesh ? manifest.getMeshPaths()[load.index] : manifest.getTexturePaths()[load.index];
+        std::cerr << "Failed to load " << path << ": " << exception.what() << std::endl;
+        getSlot(load).failed = true;
+        ++failedAssetCount;
+    };
+
+    bool meshesChanged = false;
+
+    for (auto iterator = contentReads.begin(); iterator != contentReads.end();)
+    {
+        if (!iterator->task.ready())
+        {
+            ++iterator;
+            continue;
+        }
+
+        const AssetLoad load = iterator->load;
+        try
+        {
+            installContent(load, iterator->task.get());
+        }
+        catch (const std::exception& exception)
+        {
+            reportFailure(load, exception);
+            getSlot(load).loading = false;
+        }
+        iterator = contentReads.erase(iterator);
+    }
+
+    for (auto iterator = meshUploads.begin(); iterator != meshUploads.end();)
+    {
+        if (!iterator->task.ready())
+        {
+            ++iterator;
+            continue;
+        }
+
+        const AssetLoad load{ .kind = AssetKind::Mesh, .index = iterator->index };
+        try
+        {
+            GpuAssetCache::Mesh mesh = iterator->task.get();
+            geometryHeap.markMovable(mesh.geometry.getHandle());
+            cache.insert(iterator->key, std::move(mesh), frameCount);
+            meshesChanged = true;
+        }
+        catch (const std::exception& exception)
+        {
+            reportFailure(load, exception);
+        }
+        getSlot(load).loading = false;
+        iterator = meshUploads.erase(iterator);
+    }
+
+    for (auto iterator = textureUploads.begin(); iterator != textureUploads.end();)
+    {
+        if (!iterator->task.ready())
+        {
+            ++iterator;
+            continue;
+        }
+
+        const AssetLoad load{ .kind = AssetKind::Texture, .index = iterator->index };
+        try
+        {
+            DeviceLocalImage image = iterator->task.get();
+            vk::raii::DescriptorSet descriptorSet = createMaterialDescriptorSet(image);
+            cache.insert(iterator->key, GpuAssetCache::Texture{
+                .image = std::move(image),
+                .descriptorSet = std::move(descriptorSet)
+            }, frameCount);
+        }
+        catch (const std::exception& exception)
+        {
+            reportFailure(load, exception);
+        }
+        getSlot(load).loading = false;
+        iterator = textureUploads.erase(iterator);
+    }
+
+    // Assets used by the latest frame stay; whatever frames in flight still draw is only released once they finish.
+    if (frameCount > 0 and cache.evict(frameCount - 1) > 0)
+    {
+        meshesChanged = true;
+    }
+    cache.releaseRetired(completedFrameCount);
+
+    // Draws switch to moved geometry from this frame on; the frames before it still read the old ranges.
+    if (geometryRelocation.has_value() and geometryRelocation->task.ready())
+    {
+        try
+        {
+            geometryRelocation->task.get();
+            geometryHeap.completeMoves(geometryRelocation->moves, frameCount > 0 ? frameCount - 1 : 0);
+        }
+        catch (const std::exception& exception)
+        {
+            std::cerr << "Failed to move scene geometry: " << exception.what() << std::endl;
+            geometryHeap.abandonMoves(geometryRelocation->moves);
+        }
+        geometryRelocation.reset();
+    }
+    geometryHeap.releaseRetired(completedFrameCount);
+    if (frameCount > 0 and !geometryRelocation.has_value())
+    {
+        if (std::vector<GeometryHeap::Move> moves = geometryHeap.planMoves(); !moves.empty())
+        {
+            AssetTask<bool> task = relocateGeometry(streamer, geometryHeap, moves);
+            geometryRelocation.emplace(GeometryRelocation{
+                .moves = std::move(moves),
+                .task = std::move(task)
+            });
+        }
+    }
+
+    queueRequestedLoads();
+    startLoads();
+
+    return meshesChanged;
+}
+
+bool Scene::isLoaded() const
+{
+    return queuedLoads.empty() and contentReads.empty() and meshUploads.empty() and textureUploads.empty();
+}
+
+void Scene::finishLoading()
+{
+    TRACE_SCOPE("Finish loading scene");
+
+    while (!isLoaded())
+    {
+        streamer.get().poll();
+        poll(0, 0);
+        std::this_thread::yield();
+    }
+
+    if (failedAssetCount > 0)
+    {
+        throw std::runtime_error(std::to_string(failedAssetCount) + " of " + std::to_string(assetCount) + " scene assets failed to load.");
+    }
+}
+
+uint32_t Scene::getInstanceCount() const
+{
+    return static_cast<uint32_t>(manifest.getInstances().size());
+}
+
+uint32_t Scene::getAssetCount() const
+{
+    return assetCount;
+}
+
+uint32_t Scene::getResidentAssetCount() const
+{
+    const auto isResident = [this](const AssetSlot& slot) { return slot.key.has_value() and cache.find(slot.key.value()) != nullptr; };
+
+    return static_cast<uint32_t>(std::ranges::count_if(meshSlots, isResident) + std::ranges::count_if(textureSlots, isResident));
+}
+
+GpuAssetCache::Statistics Scene::getCacheStatistics() const
+{
+    return cache.getStatistics();
+}
+
+GeometryHeap::Statistics Scene::getGeometryStatistics() const
+{
+    return geometryHeap.getStatistics();
+}
+
+void Scene::setAssetBudget(const vk::DeviceSize budget)
+{
+    cache.setBudget(budget);
+}
+
+void Scene::animateInstances(const float time, std::vector<glm::mat4>& transforms) const
+{
+    transforms.clear();
+
+    for (const SceneManifest::Instance& instance : manifest.getInstances())
+    {
+        transforms.push_back(glm::translate(glm::mat4(1.0f), instance.position) * glm::scale(glm::mat4(1.0f), glm::vec3(instance.scale)) *
+            glm::rotate(glm::mat4(1.0f), instance.spin * time, glm::vec3(0.0f, 0.0f, 1.0f)) *
+            glm::rotate(glm::mat4(1.0f), instance.rotation.z, glm::vec3(0.0f, 0.0f, 1.0f)) *
+            glm::rotate(glm::mat4(1.0f), instance.rotation.y, glm::vec3(0.0f, 1.0f, 0.0f)) *
+            glm::rotate(glm::mat4(1.0f), instance.rotation.x, glm::vec3(1.0f, 0.0f, 0.0f)));
+    }
+}
+
+void Scene::collectDrawItems(const std::span<const glm::mat4> instanceTransforms, const std::span<const glm::mat4> viewProjections, const uint64_t frame, std::vector<DrawItem>& drawItems)
+{
+    if (instanceTransforms.size() != manifest.getInstances().size())
+    {
+        throw std::invalid_argument("Expected one transform per scene instance.");
+    }
+
+    // Resident assets in view are marked as used; missing ones in view are requested again.
+    const auto use = [this, frame](AssetSlot& slot)
+    {
+        if (slot.key.has_value() and cache.find(slot.key.value()) != nullptr)
+        {
+            cache.touch(slot.key.value(), frame);
+        }
+        else
+        {
+            slot.requested = true;
+        }
+    };
+
+    drawItems.clear();
+
+    for (size_t i = 0; i < instanceTransforms.size(); ++i)
+    {
+        const SceneManifest::Instance& instance = manifest.getInstances()[i];
+        AssetSlot& meshSlot = meshSlots[instance.meshIndex];
+        AssetSlot& textureSlot = textureSlots[manifest.getMaterials()[instance.materialIndex].textureIndex];
+        const glm::mat4& transform = instanceTransforms[i];
+
+        const GpuAssetCache::Asset* meshAsset = meshSlot.key.has_value() ? cache.find(meshSlot.key.value()) : nullptr;
+        if (meshAsset != nullptr)
+        {
+            meshSlot.boundingSphere = std::get<GpuAssetCache::Mesh>(*meshAsset).boundingSphere;
+        }
+
+        // Meshes that never loaded have no bounds yet, so their instances count as in view.
+        if (!meshSlot.boundingSphere.has_value() or
+            isInView(viewProjections, glm::vec4(glm::vec3(transform * glm::vec4(glm::vec3(meshSlot.boundingSphere.value()), 1.0f)), meshSlot.boundingSphere->w * instance.scale)))
+        {
+            use(meshSlot);
+            use(textureSlot);
+        }
+
+        if (meshAsset == nullptr)
+        {
+            continue;
+        }
+
+        const GpuAssetCache::Mesh& mesh = std::get<GpuAssetCache::Mesh>(*meshAsset);
+        const GeometryHeap::Location location = geometryHeap.getLocation(mesh.geometry.getHandle());
+        const GpuAssetCache::Asset* textureAsset = textureSlot.key.has_value() ? cache.find(textureSlot.key.value()) : nullptr;
+
+        drawItems.push_back({
+            .transform = transform,
+            .boundingSphere = mesh.boundingSphere,
+            .vertexBuffer = location.vertexBuffer,
+            .positionBuffer = location.positionBuffer,
+            .indexBuffer = location.indexBuffer,
+            .indexCount = mesh.indexCount,
+            .firstIndex = location.firstIndex,
+            .vertexOffset = location.vertexOffset,
+            .materialDescriptorSet = textureAsset != nullptr ? *std::get<GpuAssetCache::Texture>(*textureAsset).descriptorSet : *fallbackDescriptorSet,
+            .baseColor = manifest.getMaterials()[instance.materialIndex].baseColor,
+            .isStatic = instance.spin == 0.0f
+        });
+    }
+}
+
+Scene::Mesh Scene::loadMesh(const std::string& path, JobSystem& jobSystem)
+{
+    return parseMesh(AssetStreamer::loadFile(path), jobSystem);
+}
+
+Scene::Mesh Scene::parseMesh(const std::span<const std::byte> content, JobSystem& jobSystem)
+{
+    TRACE_SCOPE("Parse mesh");
+
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+
+    Mesh mesh;
+
+    std::istringstream stream(std::string(reinterpret_cast<const char*>(content.data()), content.size()));
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream))
+    {
+        throw std::runtime_error(warn + err);
+    }
+
+    std::vector<tinyobj::index_t> objIndices;
+    for (const auto& shape : shapes)
+    {
+        objIndices.insert(objIndices.end(), shape.mesh.indices.begin(), shape.mesh.indices.end());
+    }
+    if (objIndices.empty())
+    {
+        throw std::runtime_error("Mesh has no faces.");
+    }
+
+    // Corners are assembled in parallel; deduplication stays sequential so vertices keep their first-seen order.
+    std::vector<Vertex> corners(objIndices.size());
+    jobSystem.parallelFor(0, corners.size(), MeshLoadGrainSize, [&](const size_t first, const size_t last)
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            const tinyobj::index_t& index = objIndices[i];
+            corners[i] = {
+                .pos = {
+                    attrib.vertices[3 * index.vertex_index + 0],
+                    attrib.vertices[3 * index.vertex_index + 1],
+                    attrib.vertices[3 * index.vertex_index + 2]
+                },
+                .color = { 1.0f, 1.0f, 1.0f },
+                .texCoord = {
+                    attrib.texcoords[2 * index.texcoord_index + 0],
+                    1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+                }
+            };
+        }
+    });
+
+    std::unordered_map<Vertex, uint32_t> uniqueVertices;
+    mesh.indices.reserve(corners.size());
+    for (const Vertex& vertex : corners)
+    {
+        if (!uniqueVertices.contains(vertex))
+        {
+            uniqueVertices[vertex] = mesh.vertices.size();
+            mesh.vertices.push_back(vertex);
+            mesh.positions.push_back(vertex.pos);
+        }
+
+        mesh.indices.push_back(uniqueVertices[vertex]);
+    }
+
+    // Bounds are reduced per chunk and then across chunks.
+    const size_t chunkCount = (mesh.positions.size() + MeshLoadGrainSize - 1) / MeshLoadGrainSize;
+    std::vector<std::pair<glm::vec3, glm::vec3>> chunkBounds(chunkCount, { glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) });
+    jobSystem.parallelFor(0, mesh.positions.size(), MeshLoadGrainSize, [&](const size_t first, const size_t last)
+    {
+        auto& [minimum, maximum] = chunkBounds[first / MeshLoadGrainSize];
+        for (size_t i = first; i < last; ++i)
+        {
+            minimum = glm::min(minimum, mesh.positions[i]);
+            maximum = glm::max(maximum, mesh.positions[i]);
+        }
+    });
+
+    glm::vec3 minimum(std::numeric_limits<float>::max());
+    glm::vec3 maximum(std::numeric_limits<float>::lowest());
+    for (const auto& [chunkMinimum, chunkMaximum] : chunkBounds)
+    {
+        minimum = glm::min(minimum, chunkMinimum);
+        maximum = glm::max(maximum, chunkMaximum);
+    }
+
+    const glm::vec3 center = (minimum + maximum) * 0.5f;
+    std::vector<float> chunkRadii(chunkCount, 0.0f);
+    jobSystem.parallelFor(0, mesh.positions.size(), MeshLoadGrainSize, [&](const size_t first, const size_t last)
+    {
+        float& radius = chunkRadii[first / MeshLoadGrainSize];
+        for (size_t i = first; i < last; ++i)
+        {
+            radius = std::max(radius, glm::length(mesh.positions[i] - center));
+        }
+    });
+    float radius = 0.0f;
+    for (const float chunkRadius : chunkRadii)
+    {
+        radius = std::max(radius, chunkRadius);
+    }
+    mesh.boundingSphere = glm::vec4(center, radius);
+
+    return mesh;
+}
+
+Scene::Image Scene::decodeImage(const std::span<const std::byte> encoded)
+{
+    TRACE_SCOPE("Decode texture");
+
+    int texWidth, texHeight, texChannels;
+    stbi_uc* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(encoded.data()), static_cast<int>(encoded.size()), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+    if (!pixels)
+    {
+        throw std::runtime_error("Failed to load texture image.");
+    }
+
+    return {
+        .pixels = { pixels, stbi_image_free },
+        .extent = { static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight) }
+    };
+}
+
+void Scene::installContent(const AssetLoad load, Content content)
+{
+    AssetSlot& slot = getSlot(load);
+    slot.key = content.key;
+
+    // Files with the same contents share one upload, whether it is resident already or still in flight.
+    const bool isUploading = std::ranges::any_of(meshUploads, [&content](const MeshUpload& upload) { return upload.key == content.key; }) or
+        std::ranges::any_of(textureUploads, [&content](const TextureUpload& upload) { return upload.key == content.key; });
+    if (cache.request(content.key) or isUploading)
+    {
+        slot.loading = false;
+        return;
+    }
+
+    if (load.kind == AssetKind::Mesh)
+    {
+        meshUploads.push_back({
+            .index = load.index,
+            .key = content.key,
+            .task = streamMesh(streamer, jobSystem, environment, geometryHeap, std::move(content.bytes))
+        });
+    }
+    else
+    {
+        textureUploads.push_back({
+            .index = load.index,
+            .key = content.key,
+            .task = streamTexture(streamer, environment, std::move(content.bytes))
+        });
+    }
+}
+
+void Scene::queueRequestedLoads()
+{
+    for (const AssetKind kind : { AssetKind::Mesh, AssetKind::Texture })
+    {
+        std::vector<AssetSlot>& slots = kind == AssetKind::Mesh ? meshSlots : textureSlots;
+        for (uint32_t i = 0; i < slots.size(); ++i)
+        {
+            AssetSlot& slot = slots[i];
+            if (slot.requested and !slot.loading and !slot.failed)
+            {
+                queuedLoads.push_back({
+                    .kind = kind,
+                    .index = i
+                });
+                slot.loading = true;
+            }
+            slot.requested = false;
+        }
+    }
+}
+
+void Scene::startLoads()
+{
+    while (!queuedLoads.empty() and contentReads.size() + meshUploads.size() + textureUploads.size() < MaxConcurrentLoads)
+    {
+        const AssetLoad load = queuedLoads.front();
+        queuedLoads.pop_front();
+
+        const std::string& path = load.kind == AssetKind::Mesh ? manifest.getMeshPaths()[load.index] : manifest.getTexturePaths()[load.index];
+        contentReads.push_back({
+            .load = load,
+            .task = readContent(streamer, path)
+        });
+    }
+}
+
+Scene::AssetSlot& Scene::getSlot(const AssetLoad load)
+{
+    return load.kind == AssetKind::Mesh ? meshSlots[load.index] : textureSlots[load.index];
+}
+
+vk::raii::DescriptorSet Scene::createMaterialDescriptorSet(const DeviceLocalImage& texture) const
+{
+    const vk::DescriptorSetAllocateInfo allocateInfo{
+        .descriptorPool = *descriptorPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &*materialDescriptorSetLayout
+    };
+    vk::raii::DescriptorSet descriptorSet = std::move(environment.get().device.allocateDescriptorSets(allocateInfo)[0]);
+
+    const vk::DescriptorImageInfo imageInfo{
+        .sampler = *sampler,
+        .imageView = *texture.imageView,
+        .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
+    };
+    const vk::WriteDescriptorSet descriptorWrite{
+        .dstSet = *descriptorSet,
+        .dstBinding = 0,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+        .pImageInfo = &imageInfo,
+        .pBufferInfo = nullptr,
+        .pTexelBufferView = nullptr
+    };
+    environment.get().device.updateDescriptorSets(descriptorWrite, nullptr);
+
+    return descriptorSet;
+}
+
+vk::raii::DescriptorPool Scene::createDescriptorPool() const
+{
+    // A texture evicted and loaded again may briefly have two sets while the old one waits for frames in flight.
+    const auto setCount = static_cast<uint32_t>(2 * manifest.getTexturePaths().size() + 1);
+    const vk::DescriptorPoolSize poolSize{
+        .type = vk::DescriptorType::eCombinedImageSampler,
+        .descriptorCount = setCount
+    };
+
+    const vk::DescriptorPoolCreateInfo createInfo{
+        .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+        .maxSets = setCount,
+        .poolSizeCount = 1,
+        .pPoolSizes = &poolSize
+    };
+
+    return environment.get().device.createDescriptorPool(createInfo);
+}
+
+vk::raii::Sampler Scene::createSampler() const
+{
+    const vk::SamplerCreateInfo createInfo{
+        .magFilter = vk::Filter::eLinear,
+        .minFilter = vk::Filter::eLinear,
+        .addressModeU = vk::SamplerAddressMode::eRepeat,
+        .addressModeV = vk::SamplerAddressMode::eRepeat,
+        .addressModeW = vk::SamplerAddressMode::eRepeat,
+        .anisotropyEnable = vk::True,
+        .maxAnisotropy = environment.get().physicalDeviceProperties.limits.maxSamplerAnisotropy,
+        .borderColor = vk::BorderColor::eIntOpaqueBlack,
+        .unnormalizedCoordinates = vk::False,
+        .compareEnable = vk::False,
+        .compareOp = vk::CompareOp::eAlways,
+        .mipmapMode = vk::SamplerMipmapMode::eLinear,
+        .mipLodBias = 0.0f,
+        .minLod = 0.0f,
+        .maxLod = 0.0f
+    };
+
+    return environment.get().device.createSampler(createInfo);
+}
+
+DeviceLocalImage Scene::createFallbackTexture() const
+{
+    constexpr std::array<unsigned char, 4> white = { 255, 255, 255, 255 };
+
+    DeviceLocalImage image{environment.get(), { 1, 1 }, vk::Format::eR8G8B8A8Srgb, vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor};
+    image.uploadData(white.data(), white.size());
+    image.transitionImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    return image;
+}
+
+vk::raii::DescriptorSetLayout Scene::createMaterialDescriptorSetLayout(const Environment& environment)
+{
+    constexpr vk::DescriptorSetLayoutBinding samplerLayoutBinding{
+        .binding = 0,
+        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+        .descriptorCount = 1,
+        .stageFlags = vk::ShaderStageFlagBits::eFragment,
+        .pImmutableSamplers = nullptr
+    };
+
+    const vk::DescriptorSetLayoutCreateInfo createInfo{
+        .bindingCount = 1,
+        .pBindings = &samplerLayoutBinding
+    };
+
+    return environment.device.createDescriptorSetLayout(createInfo);
+}
+
+std::deque<Scene::AssetLoad> Scene::createLoadQueue(const SceneManifest& manifest)
+{
+    // Assets are queued in the order instances need them, so instances complete one after another rather than all at the end.
+    std::deque<AssetLoad> loads;
+    std::vector<bool> queuedMeshes(manifest.getMeshPaths().size(), false);
+    std::vector<bool> queuedTextures(manifest.getTexturePaths().size(), false);
+
+    for (const SceneManifest::Instance& instance : manifest.getInstances())
+    {
+        if (!queuedMeshes[instance.meshIndex])
+        {
+            queuedMeshes[instance.meshIndex] = true;
+            loads.push_back({
+                .kind = AssetKind::Mesh,
+                .index = instance.meshIndex
+            });
+        }
+
+        const uint32_t textureIndex = manifest.getMaterials()[instance.materialIndex].textureIndex;
+        if (!queuedTextures[textureIndex])
+        {
+            queuedTextures[textureIndex] = true;
+            loads.push_back({
+                .kind = AssetKind::Texture,
+                .index = textureIndex
+            });
+        }
+    }
+
+    return loads;
+}
+
+bool Scene::isInView(const std::span<const glm::mat4> viewProjections, const glm::vec4& boundingSphere)
+{
+    for (const glm::mat4& viewProjection : viewProjections)
+    {
+        // Frustum planes of a zero-to-one depth projection, taken from the rows of the matrix.
+        const glm::mat4 rows = glm::transpose(viewProjection);
+        const std::array<glm::vec4, 6> planes = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[2], rows[3] - rows[2] };
+
+        const bool isInside = std::ranges::all_of(planes, [&boundingSphere](const glm::vec4& plane)
+        {
+            return glm::dot(glm::vec3(plane), glm::vec3(boundingSphere)) + plane.w >= -boundingSphere.w * glm::length(glm::vec3(plane));
+        });
+        if (isInside)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+AssetTask<Scene::Content> Scene::readContent(AssetStreamer& streamer, const std::string path)
+{
+    std::vector<std::byte> bytes = co_await streamer.readFile(path);
+    const GpuAssetCache::Key key = GpuAssetCache::hashContent(bytes);
+
+    co_return Content{
+        .key = key,
+        .bytes = std::move(bytes)
+    };
+}
+
+AssetTask<GpuAssetCache::Mesh> Scene::streamMesh(AssetStreamer& streamer, JobSystem& jobSystem, const Environment& environment, GeometryHeap& geometryHeap,
+    const std::vector<std::byte> content)
+{
+    const Mesh mesh = co_await streamer.runJob([&content, &jobSystem] { return parseMesh(content, jobSystem); });
+
+    const vk::DeviceSize vertexSize = Vertex::Size * mesh.vertices.size();
+    const vk::DeviceSize positionSize = sizeof(glm::vec3) * mesh.positions.size();
+    const vk::DeviceSize indexSize = sizeof(uint32_t) * mesh.indices.size();
+
+    GpuAssetCache::Mesh gpuMesh{
+        .geometry = geometryHeap.allocate(static_cast<uint32_t>(mesh.vertices.size()), static_cast<uint32_t>(mesh.indices.size())),
+        .indexCount = static_cast<uint32_t>(mesh.indices.size()),
+        .boundingSphere = mesh.boundingSphere
+    };
+    // Geometry is only moved once it is marked movable, so its location holds until the upload is installed.
+    const GeometryHeap::Location location = geometryHeap.getLocation(gpuMesh.geometry.getHandle());
+    const HostVisibleBuffer vertexStagingBuffer(environment, vertexSize, vk::BufferUsageFlagBits::eTransferSrc);
+    vertexStagingBuffer.uploadData(mesh.vertices.data(), vertexSize);
+    const HostVisibleBuffer positionStagingBuffer(environment, positionSize, vk::BufferUsageFlagBits::eTransferSrc);
+    positionStagingBuffer.uploadData(mesh.positions.data(), positionSize);
+    const HostVisibleBuffer indexStagingBuffer(environment, indexSize, vk::BufferUsageFlagBits::eTransferSrc);
+    indexStagingBuffer.uploadData(mesh.indices.data(), indexSize);
+
+    co_await streamer.submit([&location, &vertexStagingBuffer, &positionStagingBuffer, &indexStagingBuffer, vertexSize, positionSize, indexSize](const vk::CommandBuffer& commandBuffer)
+    {
+        const vk::DeviceSize vertexOffset = static_cast<vk::DeviceSize>(location.vertexOffset);
+        commandBuffer.copyBuffer(*vertexStagingBuffer.getBuffer(), location.vertexBuffer, vk::BufferCopy{ .srcOffset = 0, .dstOffset = vertexOffset * Vertex::Size, .size = vertexSize });
+        commandBuffer.copyBuffer(*positionStagingBuffer.getBuffer(), location.positionBuffer, vk::BufferCopy{ .srcOffset = 0, .dstOffset = vertexOffset * sizeof(glm::vec3), .size = positionSize });
+        commandBuffer.copyBuffer(*indexStagingBuffer.getBuffer(), location.indexBuffer, vk::BufferCopy{ .srcOffset = 0, .dstOffset = location.firstIndex * sizeof(uint32_t), .size = indexSize });
+
+        // Frames submitted later read the buffers without waiting on this submission.
+        const vk::MemoryBarrier2 barrier = GeometryHeap::makeUploadBarrier();
+        const vk::DependencyInfo dependencyInfo{
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers = &barrier
+        };
+        commandBuffer.pipelineBarrier2(dependencyInfo);
+    });
+
+    co_return std::move(gpuMesh);
+}
+
+AssetTask<bool> Scene::relocateGeometry(AssetStreamer& streamer, const GeometryHeap& geometryHeap, const std::vector<GeometryHeap::Move> moves)
+{
+    co_await streamer.submit([&geometryHeap, &moves](const vk::CommandBuffer& commandBuffer)
+    {
+        geometryHeap.recordMoves(commandBuffer, moves);
+    });
+
+    co_return true;
+}
+
+AssetTask<DeviceLocalImage> Scene::streamTexture(AssetStreamer& streamer, const Environment& environment, const std::vector<std::byte> content)
+{
+    const Image texture = co_await streamer.runJob([&content] { return decodeImage(content); });
+
+    // Creating resources needs no queue, so only the copy itself waits for the render thread.
+    DeviceLocalImage image{environment, texture.extent, vk::Format::eR8G8B8A8Srgb, vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor};
+    const vk::DeviceSize size = static_cast<vk::DeviceSize>(texture.extent.width) * texture.extent.height * 4;
+    const HostVisibleBuffer stagingBuffer(environment, size, vk::BufferUsageFlagBits::eTransferSrc);
+    stagingBuffer.uploadData(texture.pixels.get(), size);
+
+    co_await streamer.submit([&image, &stagingBuffer, &texture](const vk::CommandBuffer& commandBuffer)
+    {
+        const vk::BufferImageCopy region{
+            .bufferOffset = 0,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource = vk::ImageSubresourceLayers{
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            },
+            .imageOffset = vk::Offset3D{ 0, 0, 0 },
+            .imageExtent = vk::Extent3D{ texture.extent.width, texture.extent.height, 1 }
+        };
+
+        image.recordLayoutTransition(commandBuffer, vk::ImageLayout::eTransferDstOptimal);
+        commandBuffer.copyBufferToImage(*stagingBuffer.getBuffer(), *image.getImage(), vk::ImageLayout::eTransferDstOptimal, region);
+        image.recordLayoutTransition(commandBuffer, vk::ImageLayout::eShaderReadOnlyOptimal);
+    });
+
+    co_return std::move(image);
+}
@@ -0,0 +1,185 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#include <vulkan/vulkan_raii.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "environment.h"
+#include "asset_streamer.h"
+#include "asset_task.h"
+#include "device_local_image.h"
+#include "geometry_heap.h"
+#include "gpu_asset_cache.h"
+#include "job_system.h"
+#include "scene_manifest.h"
+#include "../vertex.h"
+#include "../draw_item.h"
+
+
+// GPU side of a scene manifest. Every distinct mesh and texture streams in through its own coroutines, at most
+// MaxConcurrentLoads at a time so file contents, decoded data and staging buffers stay bounded however large the
+// scene is. Instances are drawn as soon as their mesh is resident, with a white texture until their own arrives.
+// Assets live in a GpuAssetCache; evicted ones are loaded again once an instance using them comes back into view.
+// Mesh geometry is sub-allocated from a GeometryHeap, which every poll compacts a step further.
+class Scene {
+public:
+    static constexpr uint32_t MaxConcurrentLoads = 8;
+    static constexpr size_t MeshLoadGrainSize = 1 << 14;
+
+    struct Mesh
+    {
+        std::vector<Vertex> vertices;
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        glm::vec4 boundingSphere;
+    };
+    struct Image
+    {
+        std::unique_ptr<unsigned char, void(*)(void*)> pixels;
+        vk::Extent2D extent;
+    };
+
+private:
+    enum class AssetKind
+    {
+        Mesh,
+        Texture
+    };
+    struct AssetLoad
+    {
+        AssetKind kind;
+        uint32_t index;
+    };
+    // Loading state of one distinct mesh or texture file.
+    struct AssetSlot
+    {
+        // Identifies the file contents, known once the file has been read.
+        std::optional<GpuAssetCache::Key> key;
+        // Kept for meshes after eviction, so instances can still tell whether they are in view.
+        std::optional<glm::vec4> boundingSphere;
+        bool loading;
+        // Set when an instance in view found the asset missing; the next poll queues it.
+        bool requested;
+        bool failed;
+    };
+    struct Content
+    {
+        GpuAssetCache::Key key;
+        std::vector<std::byte> bytes;
+    };
+    struct ContentRead
+    {
+        AssetLoad load;
+        AssetTask<Content> task;
+    };
+    struct MeshUpload
+    {
+        uint32_t index;
+        GpuAssetCache::Key key;
+        AssetTask<GpuAssetCache::Mesh> task;
+    };
+    struct TextureUpload
+    {
+        uint32_t index;
+        GpuAssetCache::Key key;
+        AssetTask<DeviceLocalImage> task;
+    };
+    struct GeometryRelocation
+    {
+        std::vector<GeometryHeap::Move> moves;
+        AssetTask<bool> task;
+    };
+
+    std::reference_wrapper<const Environment> environment;
+    std::reference_wrapper<AssetStreamer> streamer;
+    std::reference_wrapper<JobSystem> jobSystem;
+    SceneManifest manifest;
+
+public:
+    const vk::raii::DescriptorSetLayout materialDescriptorSetLayout;
+
+private:
+    vk::raii::DescriptorPool descriptorPool;
+    vk::raii::Sampler sampler;
+    DeviceLocalImage fallbackTexture;
+    vk::raii::DescriptorSet fallbackDescriptorSet;
+    GeometryHeap geometryHeap;
+    // Declared after the descriptor pool and the geometry heap, since cached assets are allocated from them.
+    GpuAssetCache cache;
+    std::vector<AssetSlot> meshSlots;
+    std::vector<AssetSlot> textureSlots;
+    std::deque<AssetLoad> queuedLoads;
+    std::vector<ContentRead> contentReads;
+    std::vector<MeshUpload> meshUploads;
+    std::vector<TextureUpload> textureUploads;
+    std::optional<GeometryRelocation> geometryRelocation;
+    uint32_t assetCount;
+    uint32_t failedAssetCount;
+
+public:
+    // Starts loading right away; the first meshes and textures can be resident before the first frame.
+    Scene(const Environment& environment, AssetStreamer& streamer, JobSystem& jobSystem, SceneManifest manifest);
+    // Waits for the loads in flight, which use the streamer, the job system and the device.
+    ~Scene();
+
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
+
+    // Installs finished assets, evicts assets over budget, starts queued loads and the next geometry moves. Call after
+    // the streamer's poll.
+    // frameCount is the number of frames drawn so far and completedFrameCount how many of them the GPU has finished.
+    // Returns whether the set of resident meshes changed.
+    bool poll(const uint64_t frameCount, const uint64_t completedFrameCount);
+    bool isLoaded() const;
+    // Polls the streamer until every queued asset is resident, throwing if any failed to load.
+    void finishLoading();
+    uint32_t getInstanceCount() const;
+    uint32_t getAssetCount() const;
+    uint32_t getResidentAssetCount() const;
+    GpuAssetCache::Statistics getCacheStatistics() const;
+    GeometryHeap::Statistics getGeometryStatistics() const;
+    void setAssetBudget(const vk::DeviceSize budget);
+    // Replaces transforms with those of every instance spun to time. Reads only the manifest, so it may run on another
+    // thread than the rest of the scene.
+    void animateInstances(const float time, std::vector<glm::mat4>& transforms) const;
+    // Replaces drawItems with the instances whose mesh is resident, placed by instanceTransforms from animateInstances.
+    // Instances inside any of the view frustums mark their assets as used by frame, and request the ones that were evicted.
+    void collectDrawItems(const std::span<const glm::mat4> instanceTransforms, const std::span<const glm::mat4> viewProjections, const uint64_t frame, std::vector<DrawItem>& drawItems);
+
+    static Mesh loadMesh(const std::string& path, JobSystem& jobSystem);
+    static Mesh parseMesh(const std::span<const std::byte> content, JobSystem& jobSystem);
+    static Image decodeImage(const std::span<const std::byte> encoded);
+
+private:
+    void installContent(const AssetLoad load, Content content);
+    void queueRequestedLoads();
+    void startLoads();
+    AssetSlot& getSlot(const AssetLoad load);
+    vk::raii::DescriptorSet createMaterialDescriptorSet(const DeviceLocalImage& texture) const;
+    vk::raii::DescriptorPool createDescriptorPool() const;
+    vk::raii::Sampler createSampler() const;
+    DeviceLocalImage createFallbackTexture() const;
+
+    static bool isInView(const std::span<const glm::mat4> viewProjections, const glm::vec4& boundingSphere);
+    static vk::raii::DescriptorSetLayout createMaterialDescriptorSetLayout(const Environment& environment);
+    static std::deque<AssetLoad> createLoadQueue(const SceneManifest& manifest);
+    static AssetTask<Content> readContent(AssetStreamer& streamer, const std::string path);
+    static AssetTask<GpuAssetCache::Mesh> streamMesh(AssetStreamer& streamer, JobSystem& jobSystem, const Environment& environment, GeometryHeap& geometryHeap, const std::vector<std::byte> content);
+    static AssetTask<bool> relocateGeometry(AssetStreamer& streamer, const GeometryHeap& geometryHeap, const std::vector<GeometryHeap::Move> moves);
+    static AssetTask<DeviceLocalImage> streamTexture(AssetStreamer& streamer, const Environment& environment, const std::vector<std::byte> content);
+};
+
+
+#endif //SCENE_H
@@ -0,0 +1,191 @@
+#include "scene_manifest.h"
+
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace
+{
+    uint32_t findName(const std::unordered_map<std::string, uint32_t>& names, const std::string& name, const std::string& location)
+    {
+        const auto iterator = names.find(name);
+        if (iterator == names.end())
+        {
+            throw std::runtime_error("Undeclared name " + name + " at " + location);
+        }
+
+        return iterator->second;
+    }
+
+    // Declarations naming the same file share one entry, so the file is loaded once.
+    uint32_t addPath(std::vector<std::string>& paths, std::unordered_map<std::string, uint32_t>& pathIndices, const std::filesystem::path& path)
+    {
+        const std::string normalizedPath = path.lexically_normal().string();
+        const auto [iterator, inserted] = pathIndices.try_emplace(normalizedPath, static_cast<uint32_t>(paths.size()));
+        if (inserted)
+        {
+            paths.push_back(normalizedPath);
+        }
+
+        return iterator->second;
+    }
+}
+
+SceneManifest::SceneManifest(std::vector<std::string> meshPaths, std::vector<std::string> texturePaths, std::vector<Material> materials, std::vector<Instance> instances) :
+    meshPaths(std::move(meshPaths)),
+    texturePaths(std::move(texturePaths)),
+    materials(std::move(materials)),
+    instances(std::move(instances))
+{
+    if (this->instances.empty())
+    {
+        throw std::invalid_argument("Scene contains no instances.");
+    }
+
+    for (const Material& material : this->materials)
+    {
+        if (material.textureIndex >= this->texturePaths.size())
+        {
+            throw std::invalid_argument("Material references a texture outside the scene.");
+        }
+    }
+    for (const Instance& instance : this->instances)
+    {
+        if (instance.meshIndex >= this->meshPaths.size() or instance.materialIndex >= this->materials.size())
+        {
+            throw std::invalid_argument("Instance references a mesh or material outside the scene.");
+        }
+    }
+}
+
+SceneManifest::~SceneManifest() = default;
+
+const std::vector<std::string>& SceneManifest::getMeshPaths() const
+{
+    return meshPaths;
+}
+
+const std::vector<std::string>& SceneManifest::getTexturePaths() const
+{
+    return texturePaths;
+}
+
+const std::vector<SceneManifest::Material>& SceneManifest::getMaterials() const
+{
+    return materials;
+}
+
+const std::vector<SceneManifest::Instance>& SceneManifest::getInstances() const
+{
+    return instances;
+}
+
+SceneManifest SceneManifest::load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open scene manifest: " + path);
+    }
+
+    const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+
+    std::vector<std::string> meshPaths;
+    std::vector<std::string> texturePaths;
+    std::vector<Material> materials;
+    std::vector<Instance> instances;
+    std::unordered_map<std::string, uint32_t> meshPathIndices;
+    std::unordered_map<std::string, uint32_t> texturePathIndices;
+    std::unordered_map<std::string, uint32_t> meshNames;
+    std::unordered_map<std::string, uint32_t> textureNames;
+    std::unordered_map<std::string, uint32_t> materialNames;
+
+    std::string line;
+    for (uint32_t lineNumber = 1; std::getline(file, line); ++lineNumber)
+    {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos or line[first] == '#')
+        {
+            continue;
+        }
+
+        const std::string location = path + ":" + std::to_string(lineNumber);
+        std::istringstream stream(line);
+        std::string kind;
+        stream >> kind;
+
+        if (kind == "mesh" or kind == "texture")
+        {
+            std::string name, assetPath;
+            if (!(stream >> name >> assetPath) or !(stream >> std::ws).eof())
+            {
+                throw std::runtime_error("Malformed " + kind + " at " + location);
+            }
+
+            auto& names = kind == "mesh" ? meshNames : textureNames;
+            const uint32_t index = kind == "mesh" ? addPath(meshPaths, meshPathIndices, directory / assetPath) : addPath(texturePaths, texturePathIndices, directory / assetPath);
+            if (!names.try_emplace(name, index).second)
+            {
+                throw std::runtime_error("Duplicate " + kind + " name " + name + " at " + location);
+            }
+        }
+        else if (kind == "material")
+        {
+            std::string name, textureName;
+            glm::vec4 baseColor(1.0f);
+            if (!(stream >> name >> textureName))
+            {
+                throw std::runtime_error("Malformed material at " + location);
+            }
+            if (!(stream >> std::ws).eof() and (!(stream >> baseColor.r >> baseColor.g >> baseColor.b >> baseColor.a) or !(stream >> std::ws).eof()))
+            {
+                throw std::runtime_error("Malformed material at " + location);
+            }
+
+            if (!materialNames.try_emplace(name, static_cast<uint32_t>(materials.size())).second)
+            {
+                throw std::runtime_error("Duplicate material name " + name + " at " + location);
+            }
+            materials.push_back({
+                .textureIndex = findName(textureNames, textureName, location),
+                .baseColor = baseColor
+            });
+        }
+        else if (kind == "instance")
+        {
+            std::string meshName, materialName;
+            std::vector<float> values;
+            if (!(stream >> meshName >> materialName))
+            {
+                throw std::runtime_error("Malformed instance at " + location);
+            }
+            for (float value; stream >> value;)
+            {
+                values.push_back(value);
+            }
+            if (!stream.eof() or (values.size() != 4 and values.size() != 7 and values.size() != 8))
+            {
+                throw std::runtime_error("Malformed instance at " + location);
+            }
+
+            instances.push_back({
+                .meshIndex = findName(meshNames, meshName, location),
+                .materialIndex = findName(materialNames, materialName, location),
+                .position = glm::vec3(values[0], values[1], values[2]),
+                .scale = values[3],
+                .rotation = values.size() >= 7 ? glm::radians(glm::vec3(values[4], values[5], values[6])) : glm::vec3(0.0f),
+                .spin = values.size() == 8 ? glm::radians(values[7]) : 0.0f
+            });
+        }
+        else
+        {
+            throw std::runtime_error("Unknown declaration " + kind + " at " + location);
+        }
+    }
+
+    return SceneManifest(std::move(meshPaths), std::move(texturePaths), std::move(materials), std::move(instances));
+}
@@ -0,0 +1,56 @@
+#ifndef SCENE_MANIFEST_H
+#define SCENE_MANIFEST_H
+
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+
+class SceneManifest {
+public:
+    struct Material
+    {
+        uint32_t textureIndex;
+        glm::vec4 baseColor;
+    };
+    struct Instance
+    {
+        uint32_t meshIndex;
+        uint32_t materialIndex;
+        glm::vec3 position;
+        float scale;
+        // Euler angles in radians, applied in X, Y, Z order.
+        glm::vec3 rotation;
+        // Radians per second around Z; instances that do not spin are static shadow casters.
+        float spin;
+    };
+
+private:
+    std::vector<std::string> meshPaths;
+    std::vector<std::string> texturePaths;
+    std::vector<Material> materials;
+    std::vector<Instance> instances;
+
+public:
+    SceneManifest(std::vector<std::string> meshPaths, std::vector<std::string> texturePaths, std::vector<Material> materials, std::vector<Instance> instances);
+    ~SceneManifest();
+
+    const std::vector<std::string>& getMeshPaths() const;
+    const std::vector<std::string>& getTexturePaths() const;
+    const std::vector<Material>& getMaterials() const;
+    const std::vector<Instance>& getInstances() const;
+
+    // One declaration per line, with paths relative to the manifest:
+    //   mesh <name> <OBJ path>
+    //   texture <name> <image path>
+    //   material <name> <texture name> [<base color r g b a>]
+    //   instance <mesh name> <material name> <x y z> <scale> [<rotation x y z in degrees> [<spin in degrees per second>]]
+    // Names must be declared before use. Meshes and textures sharing a file are loaded once. Blank lines and lines
+    // starting with '#' are skipped.
+    static SceneManifest load(const std::string& path);
+};
+
+
+#endif //SCENE_MANIFEST_H
@@ -0,0 +1,144 @@
+#include "shadow_pipeline.h"
+
+
+#include "render_pipeline.h"
+#include "../vertex.h"
+#include "cpu_tracer.h"
+
+
+ShadowPipeline::ShadowPipeline(const Environment& environment) :
+    pipelineLayout(createPipelineLayout(environment)),
+    pipeline(createGraphicsPipeline(environment))
+{
+}
+
+ShadowPipeline::~ShadowPipeline() = default;
+
+vk::raii::PipelineLayout ShadowPipeline::createPipelineLayout(const Environment& environment)
+{
+    constexpr vk::PushConstantRange pushConstantRange{
+        .stageFlags = vk::ShaderStageFlagBits::eVertex,
+        .offset = 0,
+        .size = sizeof(PushConstants)
+    };
+
+    const vk::PipelineLayoutCreateInfo createInfo{
+        .setLayoutCount = 0,
+        .pSetLayouts = nullptr,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange
+    };
+
+    return environment.device.createPipelineLayout(createInfo);
+}
+
+vk::raii::Pipeline ShadowPipeline::createGraphicsPipeline(const Environment& environment) const
+{
+    TRACE_SCOPE("Create shadow pipeline");
+
+    const vk::raii::ShaderModule vertexShaderModule = RenderPipeline::createShaderModule(environment.device, RenderPipeline::readFile(ShaderPath + VertexShaderFilename));
+    const vk::PipelineShaderStageCreateInfo vertexShaderStageCreateInfo{
+        .stage = vk::ShaderStageFlagBits::eVertex,
+        .module = *vertexShaderModule,
+        .pName = "main"
+    };
+
+    const vk::VertexInputBindingDescription vertexInputBindingDescription = Vertex::getPositionBindingDescription();
+    const vk::VertexInputAttributeDescription vertexInputAttributeDescription = Vertex::getPositionAttributeDescription();
+    const vk::PipelineVertexInputStateCreateInfo vertexInputStateCreateInfo {
+        .vertexBindingDescriptionCount = 1,
+        .pVertexBindingDescriptions = &vertexInputBindingDescription,
+        .vertexAttributeDescriptionCount = 1,
+        .pVertexAttributeDescriptions = &vertexInputAttributeDescription
+    };
+
+    constexpr vk::PipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo{
+        .topology = vk::PrimitiveTopology::eTriangleList,
+        .primitiveRestartEnable = vk::False
+    };
+
+    constexpr vk::PipelineViewportStateCreateInfo viewportStateCreateInfo{
+        .viewportCount = 1,
+        .pViewports = nullptr,
+        .scissorCount = 1,
+        .pScissors = nullptr
+    };
+
+    constexpr vk::PipelineRasterizationStateCreateInfo rasterizationStateCreateInfo{
+        .depthClampEnable = vk::False,
+        .rasterizerDiscardEnable = vk::False,
+        .polygonMode = vk::PolygonMode::eFill,
+        .cullMode = vk::CullModeFlagBits::eNone,
+        .frontFace = vk::FrontFace::eCounterClockwise,
+        .depthBiasEnable = vk::True,
+        .depthBiasConstantFactor = DepthBiasConstantFactor,
+        .depthBiasClamp = 0.0f,
+        .depthBiasSlopeFactor = DepthBiasSlopeFactor,
+        .lineWidth = 1.0f,
+    };
+
+    constexpr vk::PipelineMultisampleStateCreateInfo multisampleStateCreateInfo{
+        .rasterizationSamples = vk::SampleCountFlagBits::e1,
+        .sampleShadingEnable = vk::False,
+        .minSampleShading = 1.0f,
+        .pSampleMask = nullptr,
+        .alphaToCoverageEnable = vk::False,
+        .alphaToOneEnable = vk::False
+    };
+
+    constexpr vk::PipelineDepthStencilStateCreateInfo depthStencilStateCreateInfo{
+        .depthTestEnable = vk::True,
+        .depthWriteEnable = vk::True,
+        .depthCompareOp = vk::CompareOp::eLessOrEqual,
+        .depthBoundsTestEnable = vk::False,
+        .stencilTestEnable = vk::False,
+        .front = {},
+        .back = {},
+        .minDepthBounds = 0.0f,
+        .maxDepthBounds = 1.0f
+    };
+
+    const vk::PipelineColorBlendStateCreateInfo colorBlendStateCreateInfo{
+        .logicOpEnable = vk::False,
+        .logicOp = vk::LogicOp::eCopy,
+        .attachmentCount = 0,
+        .pAttachments = nullptr,
+        .blendConstants = {{ 0.0f, 0.0f, 0.0f, 0.0f }}
+    };
+
+    constexpr std::array<vk::DynamicState, 2> dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+    const vk::PipelineDynamicStateCreateInfo dynamicStateCreateInfo{
+        .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+        .pDynamicStates = dynamicStates.data()
+    };
+
+    const vk::PipelineRenderingCreateInfo renderingCreateInfo{
+        .viewMask = 0,
+        .colorAttachmentCount = 0,
+        .pColorAttachmentFormats = nullptr,
+        .depthAttachmentFormat = environment.shadowDepthFormat,
+        .stencilAttachmentFormat = vk::Format::eUndefined
+    };
+
+    const vk::GraphicsPipelineCreateInfo createInfo{
+        .pNext = &renderingCreateInfo,
+        .stageCount = 1,
+        .pStages = &vertexShaderStageCreateInfo,
+        .pVertexInputState = &vertexInputStateCreateInfo,
+        .pInputAssemblyState = &inputAssemblyStateCreateInfo,
+        .pTessellationState = nullptr,
+        .pViewportState = &viewportStateCreateInfo,
+        .pRasterizationState = &rasterizationStateCreateInfo,
+        .pMultisampleState = &multisampleStateCreateInfo,
+        .pDepthStencilState = &depthStencilStateCreateInfo,
+        .pColorBlendState = &colorBlendStateCreateInfo,
+        .pDynamicState = &dynamicStateCreateInfo,
+        .layout = *pipelineLayout,
+        .renderPass = nullptr,
+        .subpass = 0,
+        .basePipelineHandle = nullptr,
+        .basePipelineIndex = -1
+    };
+
+    return environment.device.createGraphicsPipeline(nullptr, createInfo);
+}
@@ -0,0 +1,38 @@
+#ifndef SHADOW_PIPELINE_H
+#define SHADOW_PIPELINE_H
+
+
+#include <glm/glm.hpp>
+
+#include "environment.h"
+
+
+class ShadowPipeline {
+private:
+    static constexpr std::string ShaderPath = MY_RENDERER_SHADER_DIRECTORY;
+
+    static constexpr std::string VertexShaderFilename = "shadow_vertex.spv";
+
+    static constexpr float DepthBiasConstantFactor = 1.25f;
+    static constexpr float DepthBiasSlopeFactor = 1.75f;
+
+public:
+    struct PushConstants
+    {
+        alignas(16) glm::mat4 lightModelViewProjection;
+    };
+
+    const vk::raii::PipelineLayout pipelineLayout;
+    const vk::raii::Pipeline pipeline;
+
+public:
+    explicit ShadowPipeline(const Environment& environment);
+    ~ShadowPipeline();
+
+private:
+    static vk::raii::PipelineLayout createPipelineLayout(const Environment& environment);
+    vk::raii::Pipeline createGraphicsPipeline(const Environment& environment) const;
+};
+
+
+#endif //SHADOW_PIPELINE_H
@@ -0,0 +1,109 @@
+#include "simulation_thread.h"
+
+
+#include "cpu_tracer.h"
+
+#include <limits>
+#include <utility>
+
+
+SimulationThread::SimulationThread(StepFunction step, const Input& initialInput, const size_t instanceCount) :
+    step(std::move(step)),
+    snapshots(createSnapshots(initialInput, instanceCount)),
+    sharedIndex(1),
+    writeIndex(0),
+    readIndex(2),
+    inputs({ initialInput, initialInput, initialInput }),
+    sharedInputIndex(1),
+    inputWriteIndex(0),
+    inputReadIndex(2),
+    publishedSequence(0),
+    consumedSequence(0),
+    stopping(false),
+    thread(&SimulationThread::run, this)
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+    stopping.store(true, std::memory_order_release);
+    // Releases a simulation thread waiting for its last snapshot to be taken.
+    consumedSequence.store(std::numeric_limits<uint64_t>::max(), std::memory_order_release);
+    consumedSequence.notify_one();
+
+    thread.join();
+}
+
+void SimulationThread::submitInput(const Input& input)
+{
+    inputs[inputWriteIndex] = input;
+    inputWriteIndex = sharedInputIndex.exchange(inputWriteIndex | FreshBit, std::memory_order_acq_rel) & IndexMask;
+}
+
+const SimulationThread::Snapshot& SimulationThread::acquireSnapshot()
+{
+    if (snapshots[readIndex].sequence == 0)
+    {
+        publishedSequence.wait(0, std::memory_order_acquire);
+    }
+
+    if (sharedIndex.load(std::memory_order_acquire) & FreshBit)
+    {
+        readIndex = sharedIndex.exchange(readIndex, std::memory_order_acq_rel) & IndexMask;
+        consumedSequence.store(snapshots[readIndex].sequence, std::memory_order_release);
+        consumedSequence.notify_one();
+    }
+
+    return snapshots[readIndex];
+}
+
+void SimulationThread::run()
+{
+    TRACE_THREAD_NAME("Simulation");
+
+    uint64_t sequence = 0;
+    while (!stopping.load(std::memory_order_acquire))
+    {
+        Snapshot& snapshot = snapshots[writeIndex];
+        snapshot.sequence = ++sequence;
+        if (sharedInputIndex.load(std::memory_order_acquire) & FreshBit)
+        {
+            inputReadIndex = sharedInputIndex.exchange(inputReadIndex, std::memory_order_acq_rel) & IndexMask;
+        }
+        snapshot.input = inputs[inputReadIndex];
+        {
+            TRACE_SCOPE("Simulate");
+            step(snapshot);
+        }
+
+        writeIndex = sharedIndex.exchange(writeIndex | FreshBit, std::memory_order_acq_rel) & IndexMask;
+        publishedSequence.store(sequence, std::memory_order_release);
+        publishedSequence.notify_one();
+
+        uint64_t consumed = consumedSequence.load(std::memory_order_acquire);
+        while (consumed < sequence)
+        {
+            consumedSequence.wait(consumed, std::memory_order_acquire);
+            consumed = consumedSequence.load(std::memory_order_acquire);
+        }
+    }
+}
+
+std::array<SimulationThread::Snapshot, SimulationThread::SnapshotCount> SimulationThread::createSnapshots(const Input& initialInput, const size_t instanceCount)
+{
+    const auto createSnapshot = [&]
+    {
+        Snapshot snapshot{
+            .sequence = 0,
+            .input = initialInput,
+            .time = 0.0f,
+            .view = initialInput.camera.getView(),
+            .instanceTransforms = {}
+        };
+        snapshot.instanceTransforms.reserve(instanceCount);
+
+        return snapshot;
+    };
+
+    return { createSnapshot(), createSnapshot(), createSnapshot() };
+}
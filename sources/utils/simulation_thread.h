@@ -0,0 +1,96 @@
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "frame_script.h"
+#include "orbit_camera.h"
+
+
+// Runs the simulation one frame ahead of rendering: while the render thread records and submits frame N from one
+// snapshot, the simulation thread fills the snapshot for frame N + 1 from the latest input. Snapshots, and the inputs
+// going the other way, are triple buffered and change hands through a single atomic index each, so neither thread
+// ever takes a lock. The simulation waits
+// for each snapshot to be picked up before starting the next, which bounds the age of the input a frame shows to one
+// snapshot; a render thread that finds no newer snapshot draws the previous one again instead of waiting on a slow step.
+class SimulationThread {
+public:
+    // What the render thread had seen by one of its event polls.
+    struct Input
+    {
+        std::chrono::steady_clock::time_point pollTime;
+        // When the newest event that moved the camera was handled; unset until one has.
+        std::optional<std::chrono::steady_clock::time_point> eventTime;
+        OrbitCamera camera;
+    };
+    // Immutable once published; the render thread may read it until its next acquireSnapshot.
+    struct Snapshot
+    {
+        uint64_t sequence;
+        // The input the snapshot was simulated from.
+        Input input;
+        float time;
+        FrameScript::View view;
+        std::vector<glm::mat4> instanceTransforms;
+    };
+    // Fills everything but sequence and input, and must not touch state the render thread uses.
+    using StepFunction = std::function<void(Snapshot&)>;
+
+private:
+    static constexpr uint32_t SnapshotCount = 3;
+    static constexpr uint32_t IndexMask = 0x3;
+    static constexpr uint32_t FreshBit = 0x4;
+
+    StepFunction step;
+    std::array<Snapshot, SnapshotCount> snapshots;
+    // Index of the snapshot between the threads, with FreshBit set until the render thread takes it.
+    std::atomic<uint32_t> sharedIndex;
+    // Owned by the simulation thread.
+    uint32_t writeIndex;
+    // Owned by the render thread.
+    uint32_t readIndex;
+    std::array<Input, SnapshotCount> inputs;
+    // Index of the input between the threads, with FreshBit set until the simulation thread takes it.
+    std::atomic<uint32_t> sharedInputIndex;
+    // Owned by the render thread.
+    uint32_t inputWriteIndex;
+    // Owned by the simulation thread.
+    uint32_t inputReadIndex;
+    std::atomic<uint64_t> publishedSequence;
+    std::atomic<uint64_t> consumedSequence;
+    std::atomic<bool> stopping;
+    // Started last, once everything it reads is initialized.
+    std::thread thread;
+
+public:
+    // Steps see initialInput until the first submitInput. instanceCount sizes the transform lists up front, so
+    // steady-state steps do not allocate.
+    SimulationThread(StepFunction step, const Input& initialInput, const size_t instanceCount);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    // Called by the render thread after polling events; the next step simulates from this input.
+    void submitInput(const Input& input);
+    // Takes the newest snapshot, or returns the previous one again if no newer one is ready. Only the first call waits.
+    const Snapshot& acquireSnapshot();
+
+private:
+    void run();
+
+    static std::array<Snapshot, SnapshotCount> createSnapshots(const Input& initialInput, const size_t instanceCount);
+};
+
+
+#endif //SIMULATION_THREAD_H
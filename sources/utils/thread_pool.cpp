@@ -0,0 +1,79 @@
+#include "thread_pool.h"
+
+
+#include "cpu_tracer.h"
+
+#include <stdexcept>
+
+
+ThreadPool::ThreadPool(const uint32_t threadCount) :
+    stopping(false)
+{
+    if (threadCount == 0)
+    {
+        throw std::invalid_argument("Thread pool needs at least one thread.");
+    }
+
+    workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back(&ThreadPool::runWorker, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task)
+{
+    std::packaged_task<void()> packagedTask(std::move(task));
+    std::future<void> future = packagedTask.get_future();
+
+    {
+        std::lock_guard lock(mutex);
+        tasks.push(std::move(packagedTask));
+    }
+    condition.notify_one();
+
+    return future;
+}
+
+uint32_t ThreadPool::getThreadCount() const
+{
+    return workers.size();
+}
+
+void ThreadPool::runWorker()
+{
+    TRACE_THREAD_NAME("Thread pool worker");
+
+    while (true)
+    {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock lock(mutex);
+            condition.wait(lock, [this] { return stopping or !tasks.empty(); });
+
+            if (tasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+
+class ThreadPool {
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::queue<std::packaged_task<void()>> tasks;
+    bool stopping;
+    std::vector<std::thread> workers;
+
+public:
+    explicit ThreadPool(const uint32_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Exceptions thrown by the task are rethrown from the returned future.
+    std::future<void> submit(std::function<void()> task);
+    uint32_t getThreadCount() const;
+
+private:
+    void runWorker();
+};
+
+
+#endif //THREAD_POOL_H
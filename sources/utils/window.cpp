@@ -6,7 +6,12 @@
 
 Window::Window(const char* windowTitle, const int width, const int height) :
     glfwWindow(createGlfwWindow(windowTitle, width, height)),
-    framebufferResized(false)
+    framebufferResized(false),
+    pressedKeys(),
+    cursorPosition(0.0, 0.0),
+    cursorDrag(0.0, 0.0),
+    scrollOffset(0.0),
+    inputEventTime()
 {
 }
 
@@ -39,6 +44,31 @@ void Window::resetFramebufferResized()
     framebufferResized = false;
 }
 
+bool Window::consumeKeyPress(const int key)
+{
+    return pressedKeys.erase(key) > 0;
+}
+
+bool Window::isKeyDown(const int key) const
+{
+    return glfwGetKey(glfwWindow, key) == GLFW_PRESS;
+}
+
+std::pair<double, double> Window::consumeCursorDrag()
+{
+    return std::exchange(cursorDrag, { 0.0, 0.0 });
+}
+
+double Window::consumeScroll()
+{
+    return std::exchange(scrollOffset, 0.0);
+}
+
+std::optional<std::chrono::steady_clock::time_point> Window::consumeInputEventTime()
+{
+    return std::exchange(inputEventTime, std::nullopt);
+}
+
 vk::raii::SurfaceKHR Window::createSurface(const vk::raii::Instance& instance) const
 {
     VkSurfaceKHR surface;
@@ -70,6 +100,40 @@ GLFWwindow* Window::createGlfwWindow(const char* windowTitle, const int width, c
         const auto windowPtr = static_cast<Window*>(glfwGetWindowUserPointer(_window));
         windowPtr->framebufferResized = true;
     });
+    glfwSetKeyCallback(window, [](GLFWwindow* _window, int key, int, int action, int)
+    {
+        if (action == GLFW_PRESS)
+        {
+            const auto windowPtr = static_cast<Window*>(glfwGetWindowUserPointer(_window));
+            windowPtr->pressedKeys.insert(key);
+        }
+    });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow* _window, int button, int action, int)
+    {
+        if (button == GLFW_MOUSE_BUTTON_LEFT and action == GLFW_PRESS)
+        {
+            // Drags start from where the button went down, not from wherever the cursor last moved inside the window.
+            const auto windowPtr = static_cast<Window*>(glfwGetWindowUserPointer(_window));
+            glfwGetCursorPos(_window, &windowPtr->cursorPosition.first, &windowPtr->cursorPosition.second);
+        }
+    });
+    glfwSetCursorPosCallback(window, [](GLFWwindow* _window, double x, double y)
+    {
+        const auto windowPtr = static_cast<Window*>(glfwGetWindowUserPointer(_window));
+        if (glfwGetMouseButton(_window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
+        {
+            windowPtr->cursorDrag.first += x - windowPtr->cursorPosition.first;
+            windowPtr->cursorDrag.second += y - windowPtr->cursorPosition.second;
+            windowPtr->inputEventTime = std::chrono::steady_clock::now();
+        }
+        windowPtr->cursorPosition = { x, y };
+    });
+    glfwSetScrollCallback(window, [](GLFWwindow* _window, double, double y)
+    {
+        const auto windowPtr = static_cast<Window*>(glfwGetWindowUserPointer(_window));
+        windowPtr->scrollOffset += y;
+        windowPtr->inputEventTime = std::chrono::steady_clock::now();
+    });
 
     return window;
 }
@@ -3,7 +3,10 @@
 
 
 #define GLFW_INCLUDE_VULKAN
+#include <chrono>
+#include <optional>
 #include <utility>
+#include <unordered_set>
 #include <GLFW/glfw3.h>
 
 #define VULKAN_HPP_NO_CONSTRUCTORS
@@ -21,11 +24,26 @@ public:
     bool shouldClose() const;
     bool wasFramebufferResized() const;
     void resetFramebufferResized();
+    // Returns whether key was pressed since the last call for that key.
+    bool consumeKeyPress(const int key);
+    bool isKeyDown(const int key) const;
+    // Cursor movement while the left mouse button was held since the last call, in screen coordinates.
+    std::pair<double, double> consumeCursorDrag();
+    // Vertical scroll wheel steps since the last call.
+    double consumeScroll();
+    // When the newest cursor drag or scroll event since the last call was handled. GLFW does not timestamp events, so
+    // this is when glfwPollEvents delivered it.
+    std::optional<std::chrono::steady_clock::time_point> consumeInputEventTime();
 
     vk::raii::SurfaceKHR createSurface(const vk::raii::Instance& instance) const;
 
 private:
     bool framebufferResized;
+    std::unordered_set<int> pressedKeys;
+    std::pair<double, double> cursorPosition;
+    std::pair<double, double> cursorDrag;
+    double scrollOffset;
+    std::optional<std::chrono::steady_clock::time_point> inputEventTime;
 
     GLFWwindow* createGlfwWindow(const char* windowTitle, const int width, const int height);
 };
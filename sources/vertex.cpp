@@ -39,6 +39,25 @@ std::array<vk::VertexInputAttributeDescription, 3> Vertex::getAttributeDescripti
     };
 }
 
+vk::VertexInputBindingDescription Vertex::getPositionBindingDescription()
+{
+    return vk::VertexInputBindingDescription{
+        .binding = 0,
+        .stride = sizeof(glm::vec3),
+        .inputRate = vk::VertexInputRate::eVertex
+    };
+}
+
+vk::VertexInputAttributeDescription Vertex::getPositionAttributeDescription()
+{
+    return vk::VertexInputAttributeDescription{
+        .location = 0,
+        .binding = 0,
+        .format = vk::Format::eR32G32B32Sfloat,
+        .offset = 0
+    };
+}
+
 size_t std::hash<Vertex>::operator()(Vertex const& vertex) const noexcept
 {
     return ((std::hash<glm::vec3>()(vertex.pos) ^
@@ -22,6 +22,9 @@ public:
 
     static vk::VertexInputBindingDescription getBindingDescription();
     static std::array<vk::VertexInputAttributeDescription, 3> getAttributeDescriptions();
+
+    static vk::VertexInputBindingDescription getPositionBindingDescription();
+    static vk::VertexInputAttributeDescription getPositionAttributeDescription();
 };
 
 